@@ -0,0 +1,96 @@
+#include "AllocStats.h"
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+const char *const NM_alloc_tag_names[NM_ALLOC_TAGS] = {"other", "miner0", "miner1", "pool", "svc", "loop", "log"};
+
+static NMAllocCounters s_counters[NM_ALLOC_TAGS];
+
+#if defined(NM_ALLOC_STATS)
+
+static TaskHandle_t s_tasks[NM_ALLOC_TAGS];
+
+bool NM_alloc_enabled() { return true; }
+
+void NM_alloc_register(NMAllocTag tag) {
+    if (tag == NM_ALLOC_OTHER || tag >= NM_ALLOC_TAGS) return;
+    __atomic_store_n(&s_tasks[tag], xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+}
+
+// Runs on every heap call: a handful of compares, no locks. Never allocates.
+static inline NMAllocCounters &nmAllocSlot() {
+    if (xPortInIsrContext()) return s_counters[NM_ALLOC_OTHER];
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (self) {
+        for (uint8_t i = 1; i < NM_ALLOC_TAGS; i++) {
+            if (__atomic_load_n(&s_tasks[i], __ATOMIC_RELAXED) == self) return s_counters[i];
+        }
+    }
+    return s_counters[NM_ALLOC_OTHER];
+}
+
+static inline void nmAllocNote(void *p, size_t size) {
+    NMAllocCounters &c = nmAllocSlot();
+    if (!p) {
+        if (size) __atomic_fetch_add(&c.fails, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_fetch_add(&c.allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&c.bytes, (uint32_t)size, __ATOMIC_RELAXED);
+}
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size) {
+    void *p = __real_malloc(size);
+    nmAllocNote(p, size);
+    return p;
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    void *p = __real_calloc(n, size);
+    nmAllocNote(p, n * size);
+    return p;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    void *p = __real_realloc(ptr, size);
+    // In-place resizes are cheap and do not fragment; count the rest.
+    if (!ptr || (p && p != ptr)) {
+        nmAllocNote(p, size);
+        if (ptr) __atomic_fetch_add(&nmAllocSlot().frees, 1, __ATOMIC_RELAXED);
+    } else if (!p && size) {
+        nmAllocNote(nullptr, size);
+    }
+    return p;
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr) __atomic_fetch_add(&nmAllocSlot().frees, 1, __ATOMIC_RELAXED);
+    __real_free(ptr);
+}
+}
+
+#else
+
+bool NM_alloc_enabled() { return false; }
+void NM_alloc_register(NMAllocTag) {}
+
+#endif
+
+void NM_alloc_read(NMAllocTag tag, NMAllocCounters &out) {
+    const NMAllocCounters &c = s_counters[tag < NM_ALLOC_TAGS ? tag : NM_ALLOC_OTHER];
+    out.allocs = __atomic_load_n(&c.allocs, __ATOMIC_RELAXED);
+    out.frees = __atomic_load_n(&c.frees, __ATOMIC_RELAXED);
+    out.bytes = __atomic_load_n(&c.bytes, __ATOMIC_RELAXED);
+    out.fails = __atomic_load_n(&c.fails, __ATOMIC_RELAXED);
+}
+
+uint32_t NM_alloc_count(NMAllocTag tag) {
+    return __atomic_load_n(&s_counters[tag < NM_ALLOC_TAGS ? tag : NM_ALLOC_OTHER].allocs, __ATOMIC_RELAXED);
+}
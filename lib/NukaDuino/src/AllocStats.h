@@ -0,0 +1,52 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+// Heap allocation counters per subsystem.
+//
+// With NM_ALLOC_STATS defined (platformio.ini, together with the linker's
+// --wrap=malloc/calloc/realloc/free) every heap call in the firmware, the
+// Arduino core and the prebuilt IDF libraries goes through AllocStats.cpp,
+// which charges it to the calling task. Tasks register themselves under a tag;
+// everything else (WiFi, lwIP, timers, ...) lands in NM_ALLOC_OTHER.
+//
+// Without NM_ALLOC_STATS the functions below are no-ops and every count
+// reads 0, so callers need no #ifdefs.
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum NMAllocTag : uint8_t {
+    NM_ALLOC_OTHER = 0,
+    NM_ALLOC_MINER0,   // duco0
+    NM_ALLOC_MINER1,   // duco1
+    NM_ALLOC_POOL,     // ducoPool
+    NM_ALLOC_SVC,      // svc: web server, button, portal
+    NM_ALLOC_LOOP,     // loopTask: LCD, supervisors
+    NM_ALLOC_LOG,      // logDrain
+    NM_ALLOC_TAGS
+};
+
+struct NMAllocCounters {
+    uint32_t allocs;   // malloc/calloc and reallocs that moved or grew from NULL
+    uint32_t frees;
+    uint32_t bytes;    // requested, cumulative
+    uint32_t fails;    // NULL returns
+};
+
+extern const char *const NM_alloc_tag_names[NM_ALLOC_TAGS];
+
+// True when the firmware was built with the heap wrappers.
+bool NM_alloc_enabled();
+
+// Charge the calling task's heap calls to tag from now on. Call at the top of
+// the task function (again after a respawn: the handle changes).
+void NM_alloc_register(NMAllocTag tag);
+
+// Consistent-enough copy of one tag's counters (relaxed reads).
+void NM_alloc_read(NMAllocTag tag, NMAllocCounters &out);
+
+// Allocations charged to tag so far; take the difference around a piece of
+// work to count what it allocated.
+uint32_t NM_alloc_count(NMAllocTag tag);
+
+#endif
@@ -0,0 +1,206 @@
+#include "CrashLog.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#if defined(NM_CRASH_CAPTURE)
+#include <esp_debug_helpers.h>
+#include <esp_private/panic_internal.h>
+#include <freertos/xtensa_context.h>
+#endif
+
+namespace {
+
+constexpr uint32_t RTC_MAGIC = 0x4E4D4231;   // "NMB1"
+
+struct BootRtc {
+    uint32_t magic;
+    uint32_t boots;
+    uint8_t fast_resets;
+    uint8_t safe_mode;
+    uint8_t pending;        // the panic handler filled crash[head] this boot
+    uint8_t unsaved;        // crash[] differs from NVS
+    uint8_t head;           // next slot to write
+    uint8_t count;
+    uint8_t reserved[2];
+    NMCrashRecord crash[NM_CRASH_SLOTS];
+};
+
+RTC_NOINIT_ATTR BootRtc s_rtc;
+bool s_stable = false;
+
+bool rtcValid() {
+    return s_rtc.magic == RTC_MAGIC && s_rtc.head < NM_CRASH_SLOTS && s_rtc.count <= NM_CRASH_SLOTS;
+}
+
+bool isCrashReset(esp_reset_reason_t r) {
+    return r == ESP_RST_PANIC || r == ESP_RST_INT_WDT || r == ESP_RST_TASK_WDT ||
+           r == ESP_RST_WDT || r == ESP_RST_BROWNOUT;
+}
+
+void nvsSave() {
+    Preferences p;
+    if (!p.begin("nm_crash", false)) return;
+    p.putUChar("head", s_rtc.head);
+    p.putUChar("count", s_rtc.count);
+    p.putBytes("rec", s_rtc.crash, sizeof(s_rtc.crash));
+    p.end();
+    s_rtc.unsaved = 0;
+}
+
+void nvsLoad() {
+    Preferences p;
+    if (!p.begin("nm_crash", true)) return;
+    const uint8_t head = p.getUChar("head", 0);
+    const uint8_t count = p.getUChar("count", 0);
+    if (head < NM_CRASH_SLOTS && count <= NM_CRASH_SLOTS &&
+        p.getBytesLength("rec") == sizeof(s_rtc.crash) &&
+        p.getBytes("rec", s_rtc.crash, sizeof(s_rtc.crash)) == sizeof(s_rtc.crash)) {
+        s_rtc.head = head;
+        s_rtc.count = count;
+    }
+    p.end();
+}
+
+NMCrashRecord &nextSlot() {
+    NMCrashRecord &c = s_rtc.crash[s_rtc.head];
+    memset(&c, 0, sizeof(c));
+    return c;
+}
+
+void commitSlot() {
+    s_rtc.head = (uint8_t)((s_rtc.head + 1) % NM_CRASH_SLOTS);
+    if (s_rtc.count < NM_CRASH_SLOTS) s_rtc.count++;
+}
+
+}  // namespace
+
+void NM_crash_boot() {
+    const esp_reset_reason_t r = esp_reset_reason();
+    if (!rtcValid()) {
+        // Power-on (or first boot of this layout): start over, keep history from NVS.
+        memset(&s_rtc, 0, sizeof(s_rtc));
+        s_rtc.magic = RTC_MAGIC;
+        nvsLoad();
+    }
+    s_rtc.boots++;
+
+    if (isCrashReset(r)) {
+        if (s_rtc.pending) {
+            // The panic handler already wrote the details; the slot is the
+            // previous one.
+            const uint8_t last = (uint8_t)((s_rtc.head + NM_CRASH_SLOTS - 1) % NM_CRASH_SLOTS);
+            s_rtc.crash[last].reset_reason = (uint8_t)r;
+        } else {
+            NMCrashRecord &c = nextSlot();
+            c.boot = s_rtc.boots - 1;
+            c.reset_reason = (uint8_t)r;
+            strlcpy(c.reason, NM_reset_reason_name((uint8_t)r), sizeof(c.reason));
+            commitSlot();
+        }
+        s_rtc.unsaved = 1;
+        if (s_rtc.fast_resets < 255) s_rtc.fast_resets++;
+    }
+    s_rtc.pending = 0;
+    s_rtc.safe_mode = s_rtc.fast_resets >= NM_SAFE_MODE_RESETS;
+    if (s_rtc.unsaved) nvsSave();
+}
+
+bool NM_crash_safe_mode() { return s_rtc.safe_mode != 0; }
+uint8_t NM_crash_fast_resets() { return s_rtc.fast_resets; }
+uint32_t NM_crash_boot_count() { return s_rtc.boots; }
+bool NM_crash_stable() { return s_stable; }
+
+void NM_crash_mark_stable() {
+    s_stable = true;
+    s_rtc.fast_resets = 0;
+}
+
+uint8_t NM_crash_count() { return s_rtc.count; }
+
+bool NM_crash_get(uint8_t idx, NMCrashRecord &out) {
+    if (idx >= s_rtc.count) return false;
+    const uint8_t slot = (uint8_t)((s_rtc.head + NM_CRASH_SLOTS - 1 - idx) % NM_CRASH_SLOTS);
+    memcpy(&out, &s_rtc.crash[slot], sizeof(out));
+    return true;
+}
+
+void NM_crash_clear() {
+    memset(s_rtc.crash, 0, sizeof(s_rtc.crash));
+    s_rtc.head = 0;
+    s_rtc.count = 0;
+    nvsSave();
+}
+
+const char *NM_reset_reason_name(uint8_t reason) {
+    switch ((esp_reset_reason_t)reason) {
+        case ESP_RST_POWERON: return "power-on";
+        case ESP_RST_EXT: return "external";
+        case ESP_RST_SW: return "software";
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT: return "interrupt watchdog";
+        case ESP_RST_TASK_WDT: return "task watchdog";
+        case ESP_RST_WDT: return "watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep sleep";
+        case ESP_RST_BROWNOUT: return "brownout";
+        case ESP_RST_SDIO: return "sdio";
+        default: return "unknown";
+    }
+}
+
+#if defined(NM_CRASH_CAPTURE)
+
+bool NM_crash_capture_enabled() { return true; }
+
+// Runs inside the panic handler, before the normal panic output: no heap, no
+// locks, and only IRAM code of our own (hence no helper calls above).
+extern "C" void __real_esp_panic_handler(panic_info_t *info);
+
+extern "C" void IRAM_ATTR __wrap_esp_panic_handler(panic_info_t *info) {
+    if (info && s_rtc.magic == RTC_MAGIC && s_rtc.head < NM_CRASH_SLOTS && !s_rtc.pending) {
+        NMCrashRecord &c = s_rtc.crash[s_rtc.head];
+        c.boot = s_rtc.boots;
+        c.uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        c.core = (uint8_t)info->core;
+        c.reset_reason = 0;
+        c.depth = 0;
+        c.exc_pc = (uint32_t)(uintptr_t)info->addr;
+        const char *why = info->reason ? info->reason : "panic";
+        size_t i = 0;
+        for (; why[i] && i < sizeof(c.reason) - 1; i++) c.reason[i] = why[i];
+        c.reason[i] = 0;
+
+        const XtExcFrame *f = (const XtExcFrame *)info->frame;
+        if (f) {
+            if (!c.exc_pc) c.exc_pc = f->pc;
+            esp_backtrace_frame_t bt = {};
+            bt.pc = f->pc;
+            bt.sp = f->a1;
+            bt.next_pc = f->a0;
+            bt.exc_frame = f;
+            // Same walk (and PC decoding) as the IDF's own "Backtrace:" line,
+            // so the addresses feed straight into addr2line.
+            for (uint8_t d = 0; d < NM_CRASH_DEPTH; d++) {
+                uint32_t pc = bt.pc;
+                if (pc & 0x80000000u) pc = (pc & 0x3fffffffu) | 0x40000000u;
+                c.backtrace[d] = pc - 3;
+                c.depth = d + 1;
+                if (!bt.next_pc || !esp_backtrace_get_next_frame(&bt)) break;
+            }
+        }
+        s_rtc.pending = 1;
+        s_rtc.head = (uint8_t)((s_rtc.head + 1) % NM_CRASH_SLOTS);
+        if (s_rtc.count < NM_CRASH_SLOTS) s_rtc.count++;
+    }
+    __real_esp_panic_handler(info);
+}
+
+#else
+
+bool NM_crash_capture_enabled() { return false; }
+
+#endif
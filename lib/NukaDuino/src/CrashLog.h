@@ -0,0 +1,58 @@
+#ifndef CRASH_LOG_H
+#define CRASH_LOG_H
+
+// Crash-loop detection and panic records.
+//
+// A small record in RTC memory (RTC_NOINIT, survives every reset except a
+// power cycle) counts consecutive crash resets: panics, watchdogs and
+// brownouts that hit before the previous boot was marked stable. Once that
+// count reaches the threshold the firmware boots in safe mode.
+//
+// With NM_CRASH_CAPTURE defined (platformio.ini, together with the linker's
+// --wrap=esp_panic_handler) the panic handler also stores the exception PC and
+// a backtrace of the crashing task before the normal panic output. Records
+// are copied to NVS on the next boot so they outlive a power cycle, and read
+// back from there when the RTC record is gone.
+
+#include <stdint.h>
+
+static constexpr uint8_t NM_CRASH_DEPTH = 16;        // backtrace frames kept
+static constexpr uint8_t NM_CRASH_SLOTS = 4;         // newest crashes kept
+static constexpr uint8_t NM_SAFE_MODE_RESETS = 3;    // fast crash resets before safe mode
+
+struct NMCrashRecord {
+    uint32_t boot;               // boot number the crash happened in
+    uint32_t uptime_ms;          // time since that boot
+    uint32_t exc_pc;             // faulting PC (0 if only the reset reason is known)
+    uint32_t backtrace[NM_CRASH_DEPTH];
+    uint8_t depth;               // valid backtrace entries
+    uint8_t core;
+    uint8_t reset_reason;        // esp_reset_reason_t of the reset that followed
+    uint8_t reserved;
+    char reason[40];             // panic reason ("LoadProhibited", "Interrupt wdt timeout on CPU0", ...)
+};
+
+// Call first thing in setup(): classifies the reset, updates the counters,
+// persists new crash records and decides on safe mode.
+void NM_crash_boot();
+
+bool NM_crash_safe_mode();
+uint8_t NM_crash_fast_resets();
+uint32_t NM_crash_boot_count();
+
+// Call once this boot has proven itself (uptime, mining). Clears the fast
+// reset count, so the next crash starts from zero.
+void NM_crash_mark_stable();
+bool NM_crash_stable();
+
+// Stored crash records, newest first.
+uint8_t NM_crash_count();
+bool NM_crash_get(uint8_t idx, NMCrashRecord &out);
+void NM_crash_clear();
+
+// True when panics are captured (NM_CRASH_CAPTURE build).
+bool NM_crash_capture_enabled();
+
+const char *NM_reset_reason_name(uint8_t reason);
+
+#endif
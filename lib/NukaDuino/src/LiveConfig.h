@@ -0,0 +1,120 @@
+#ifndef LIVE_CONFIG_H
+#define LIVE_CONFIG_H
+
+// Immutable, reference-counted snapshots (adapted for NukaMiner).
+//
+// Settings read across cores are published as an immutable snapshot. The
+// writer builds a fresh one and swaps it in; readers pin the current one
+// (a miner once per mine() cycle, loop() once per pass) and use it until they
+// let go. A pin is a reference count taken under a spinlock, so a snapshot is
+// freed by whoever drops the last reference and nobody ever sees a
+// half-updated String.
+
+#include <Arduino.h>
+#include <utility>
+
+template <typename T>
+class SnapshotCell {
+    struct Box {
+        T value;
+        uint32_t refs;
+        uint32_t version;
+    };
+
+public:
+    // Pinned reference to one snapshot. Move-only; releases on destruction.
+    class Ref {
+    public:
+        Ref() = default;
+        Ref(const Ref &) = delete;
+        Ref &operator=(const Ref &) = delete;
+        Ref(Ref &&o) : cell(o.cell), box(o.box) { o.cell = nullptr; o.box = nullptr; }
+        Ref &operator=(Ref &&o) {
+            if (this != &o) {
+                reset();
+                cell = o.cell;
+                box = o.box;
+                o.cell = nullptr;
+                o.box = nullptr;
+            }
+            return *this;
+        }
+        ~Ref() { reset(); }
+
+        void reset() {
+            if (cell) cell->unref(box);
+            cell = nullptr;
+            box = nullptr;
+        }
+        const T *get() const { return box ? &box->value : nullptr; }
+        const T *operator->() const { return get(); }
+        explicit operator bool() const { return box != nullptr; }
+        uint32_t version() const { return box ? box->version : 0; }
+
+    private:
+        friend class SnapshotCell;
+        Ref(const SnapshotCell *c, Box *b) : cell(c), box(b) {}
+        const SnapshotCell *cell = nullptr;
+        Box *box = nullptr;
+    };
+
+    SnapshotCell() = default;
+    SnapshotCell(const SnapshotCell &) = delete;
+    SnapshotCell &operator=(const SnapshotCell &) = delete;
+
+    // Any task, any core. Returns an empty Ref before the first publish().
+    Ref pin() const {
+        portENTER_CRITICAL(&mux);
+        Box *b = current;
+        if (b) b->refs++;
+        portEXIT_CRITICAL(&mux);
+        return Ref(b ? this : nullptr, b);
+    }
+
+    // Replace the current snapshot. Readers holding the old one keep it alive
+    // until they let go.
+    void publish(T value) {
+        Box *b = new Box{std::move(value), 1, 0};
+        portENTER_CRITICAL(&mux);
+        b->version = ++versionCounter;
+        Box *old = current;
+        current = b;
+        portEXIT_CRITICAL(&mux);
+        unref(old);
+    }
+
+    // Version of the current snapshot (0 = none); cheap change detection.
+    uint32_t version() const { return __atomic_load_n(&versionCounter, __ATOMIC_RELAXED); }
+
+private:
+    void unref(Box *b) const {
+        if (!b) return;
+        portENTER_CRITICAL(&mux);
+        const bool last = (--b->refs == 0);
+        portEXIT_CRITICAL(&mux);
+        if (last) delete b;
+    }
+
+    mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    Box *current = nullptr;
+    uint32_t versionCounter = 0;
+};
+
+// Miner settings applied without reconnecting.
+struct NMMinerLive {
+    String user;
+    String key;
+    String rig_id;              // "Auto" = derive from the chip id
+    String group_id;            // dashboard grouping id, shared by both workers
+    uint8_t hash_limit_pct[2];  // per worker (index = MiningJob core), 100 = unlimited
+
+    // Preformatted by MiningJob::formatLive() before publishing.
+    String job_prefix;          // "JOB,<user>,<start diff>,<key>"
+    String job_line;            // job_prefix + "\n"
+    String submit_tail;         // ",<banner> <version>,<rig>,DUCOID<chip>,<group>\n"
+};
+
+// Defined in Settings.cpp; published by src/main.cpp.
+extern SnapshotCell<NMMinerLive> NM_live;
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef LOG_EVENTS_H
+#define LOG_EVENTS_H
+
+// Structured log events (adapted for NukaMiner).
+//
+// An event is an id, a millisecond timestamp and up to six 32-bit arguments,
+// stored as-is in the log ring (see LogRing.h). Nothing is formatted when the
+// event is recorded: /logs.json and the serial drain render it with the
+// format below, and /events.bin ships the raw records to
+// tools/nm_events.py, which reads this table from this file. Keep one X()
+// entry per line and only use %lu, %ld, %u, %d, %x and %f-style conversions.
+
+#include <Arduino.h>
+#include <string.h>
+
+#define NM_EVENT_TABLE(X) \
+    X(SHARE_GOOD,   NM_LOG_LEVEL_INFO,    "Core [%lu] - GOOD share #%lu (%lu) hashrate: %.2f kH/s (%.2fs) Ping: %lums") \
+    X(NONCE_FOUND,  NM_LOG_LEVEL_DEBUG,   "Core [%lu] - Nonce %lu found after %lu us") \
+    X(JOB_RECEIVED, NM_LOG_LEVEL_DEBUG,   "Core [%lu] - Job diff %lu received in %lu ms") \
+    X(HASH_YIELD,   NM_LOG_LEVEL_VERBOSE, "Core [%lu] - Yielded %lu us after a %lu ms slice")
+
+enum NMEventId : uint16_t {
+#define NM_EV_ID(name, level, fmt) NM_EV_##name,
+    NM_EVENT_TABLE(NM_EV_ID)
+#undef NM_EV_ID
+    NM_EV_COUNT
+};
+
+// Per-event levels as constants so disabled events fold away at compile time.
+enum : uint8_t {
+#define NM_EV_LEVEL(name, level, fmt) NM_EV_LEVEL_##name = level,
+    NM_EVENT_TABLE(NM_EV_LEVEL)
+#undef NM_EV_LEVEL
+};
+
+struct NMEventDef {
+    const char *name;
+    const char *fmt;
+};
+extern const NMEventDef NM_event_defs[NM_EV_COUNT];   // Settings.cpp
+
+// Record layout (little endian): header, then one 32-bit word per argument.
+// types holds two bits per argument, argument 0 in the low bits.
+static constexpr uint8_t NM_EVENT_MAX_ARGS = 6;
+enum : uint8_t { NM_EVARG_U32 = 0, NM_EVARG_I32 = 1, NM_EVARG_F32 = 2 };
+struct NMEventHdr {
+    uint16_t id;
+    uint16_t types;
+    uint32_t t_ms;
+};
+
+// Hook implemented in src/main.cpp: append one encoded event to the log ring.
+void NM_event_write(uint8_t level, const void *rec, size_t len);
+
+namespace nm_ev {
+inline void put(uint32_t *a, uint16_t &, int i, unsigned int v) { a[i] = v; }
+inline void put(uint32_t *a, uint16_t &, int i, unsigned long v) { a[i] = (uint32_t)v; }
+inline void put(uint32_t *a, uint16_t &t, int i, int v) { a[i] = (uint32_t)v; t |= NM_EVARG_I32 << (2 * i); }
+inline void put(uint32_t *a, uint16_t &t, int i, long v) { a[i] = (uint32_t)v; t |= NM_EVARG_I32 << (2 * i); }
+inline void put(uint32_t *a, uint16_t &t, int i, float v) { memcpy(&a[i], &v, 4); t |= NM_EVARG_F32 << (2 * i); }
+inline void put(uint32_t *a, uint16_t &t, int i, double v) { put(a, t, i, (float)v); }
+
+inline void pack(uint32_t *, uint16_t &, int) {}
+template <typename T, typename... Rest>
+inline void pack(uint32_t *a, uint16_t &t, int i, T v, Rest... rest) {
+    put(a, t, i, v);
+    pack(a, t, i + 1, rest...);
+}
+}  // namespace nm_ev
+
+template <typename... Args>
+inline void NM_event_emit(uint8_t level, NMEventId id, Args... args) {
+    static_assert(sizeof...(Args) <= NM_EVENT_MAX_ARGS, "too many event arguments");
+    struct {
+        NMEventHdr h;
+        uint32_t a[sizeof...(Args) ? sizeof...(Args) : 1];
+    } rec;
+    rec.h.id = id;
+    rec.h.types = 0;
+    rec.h.t_ms = millis();
+    nm_ev::pack(rec.a, rec.h.types, 0, args...);
+    NM_event_write(level, &rec, sizeof(NMEventHdr) + 4 * sizeof...(Args));
+}
+
+// NM_EVENT(SHARE_GOOD, core, shares, ...): like NM_LOGx, the arguments are
+// not evaluated when the event's level is disabled.
+#define NM_EVENT(name, ...) \
+    do { if (NM_LOG_ENABLED(NM_EV_LEVEL_##name)) NM_event_emit(NM_EV_LEVEL_##name, NM_EV_##name, __VA_ARGS__); } while (0)
+
+#endif
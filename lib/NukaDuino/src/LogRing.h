@@ -0,0 +1,150 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+// Multi-producer log ring over a fixed byte arena (adapted for NukaMiner).
+//
+// Producers (miner tasks, pool task, service task, loop) reserve space with a
+// single compare-and-swap on the write position, copy their bytes in and
+// commit by storing the record's own position into its header. Producers
+// never block or allocate; the oldest records are simply overwritten.
+//
+// Readers can be stalled: a producer preempted or suspended between reserve
+// and commit leaves READ_PENDING at its record, and nothing behind it can be
+// read in order. Readers wait a bounded time and then skip() past it. A
+// producer that resumes after being lapped drops its line instead of
+// committing over newer records.
+//
+// Positions are free-running byte offsets, so a position is also a stable
+// sequence number for readers (/logs.json "seq", the serial drain cursor).
+// Readers copy a record out and then check that the writers have not lapped
+// it in the meantime; a reader that fell behind resyncs by scanning for a
+// header whose tag equals its own position.
+
+#include <Arduino.h>
+#include <string.h>
+
+template <uint32_t N>
+class LogRing {
+    static_assert(N >= 1024 && (N & (N - 1)) == 0, "LogRing size must be a power of two");
+
+public:
+    struct Rec {
+        uint32_t pos;    // commit tag: the record's own position once written
+        uint16_t len;    // text bytes (no terminator)
+        uint8_t level;
+        uint8_t flags;
+    };
+    static constexpr uint8_t FLAG_PAD = 0x01;        // filler up to the end of the arena
+    // Other flag bits are the caller's (e.g. binary payload instead of text).
+    static constexpr uint16_t MAX_TEXT = 240;        // longer lines are truncated
+
+    enum ReadResult : uint8_t {
+        READ_OK = 0,
+        READ_EMPTY,     // pos is the head: nothing newer
+        READ_PENDING,   // a producer reserved pos but has not committed yet (see skip())
+        READ_LOST,      // pos was overwritten (or is not a record boundary)
+    };
+
+    // Any task; not from ISRs (an interrupted producer would stall readers at
+    // its record until they skip it). Text records lose trailing newlines.
+    void write(const char *text, size_t len, uint8_t level = 0, uint8_t flags = 0) {
+        if (!flags) while (len && (text[len - 1] == '\n' || text[len - 1] == '\r')) len--;
+        if (len > MAX_TEXT) len = MAX_TEXT;
+        const uint32_t need = align(sizeof(Rec) + len);
+
+        uint32_t pos = __atomic_load_n(&wpos, __ATOMIC_RELAXED);
+        uint32_t pad, next;
+        do {
+            const uint32_t off = pos & (N - 1);
+            pad = (off + need > N) ? (N - off) : 0;
+            next = pos + pad + need;
+        } while (!__atomic_compare_exchange_n(&wpos, &pos, next, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+        // Preempted for a whole lap since the reserve: the space is newer
+        // records' now. Checked again before the commit; only a producer
+        // stalled between these checks can still scribble.
+        const uint32_t start = pos;
+        if (lapped(start)) return;
+        if (pad) {
+            Rec *p = at(pos);
+            p->len = (uint16_t)(pad - sizeof(Rec));
+            p->level = 0;
+            p->flags = FLAG_PAD;
+            __atomic_store_n(&p->pos, pos, __ATOMIC_RELEASE);
+            pos += pad;
+        }
+        Rec *r = at(pos);
+        r->len = (uint16_t)len;
+        r->level = level;
+        r->flags = (uint8_t)(flags & ~FLAG_PAD);
+        memcpy(r + 1, text, len);
+        __atomic_thread_fence(__ATOMIC_ACQ_REL);
+        if (lapped(start)) return;
+        __atomic_store_n(&r->pos, pos, __ATOMIC_RELEASE);
+    }
+
+    // Position just past the newest reserved record.
+    uint32_t head() const { return __atomic_load_n(&wpos, __ATOMIC_ACQUIRE); }
+
+    // Copy the record at pos (out must hold MAX_TEXT bytes) and advance pos
+    // past it. Filler records are skipped transparently.
+    ReadResult read(uint32_t &pos, char *out, uint16_t &len, uint8_t &level, uint8_t *flags = nullptr) const {
+        for (;;) {
+            const uint32_t h = head();
+            if (pos == h) return READ_EMPTY;
+            if ((uint32_t)(h - pos) > N) return READ_LOST;
+
+            const Rec *r = at(pos);
+            if (__atomic_load_n(&r->pos, __ATOMIC_ACQUIRE) != pos) return READ_PENDING;
+            const Rec hdr = *r;
+            if (hdr.flags & FLAG_PAD) {
+                pos += sizeof(Rec) + hdr.len;
+                continue;
+            }
+            if (hdr.len > MAX_TEXT) return READ_LOST;
+            memcpy(out, r + 1, hdr.len);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            // Lapped while copying?
+            if ((uint32_t)(head() - pos) > N) return READ_LOST;
+            len = hdr.len;
+            level = hdr.level;
+            if (flags) *flags = hdr.flags;
+            pos += align(sizeof(Rec) + hdr.len);
+            return READ_OK;
+        }
+    }
+
+    // Next committed record boundary after a record that stays READ_PENDING,
+    // or head() if there is none yet. Its producer was preempted or suspended
+    // mid-write; the reader gives up on that line rather than stall.
+    uint32_t skip(uint32_t pos) const { return resync(pos + ALIGN); }
+
+    // First committed record boundary at or after `from`, skipping anything
+    // that is (or is about to be) overwritten. Returns head() if none.
+    uint32_t resync(uint32_t from) const {
+        const uint32_t h = head();
+        // Stay one maximum-size record clear of the writers.
+        const uint32_t margin = align(sizeof(Rec) + MAX_TEXT);
+        uint32_t oldest = (h > N - margin) ? h - (N - margin) : 0;
+        oldest = align(oldest);
+        uint32_t p = ((int32_t)(from - oldest) > 0 && (int32_t)(h - from) >= 0) ? align(from) : oldest;
+        for (; p != h && (int32_t)(h - p) > 0; p += ALIGN) {
+            if (__atomic_load_n(&at(p)->pos, __ATOMIC_ACQUIRE) == p) return p;
+        }
+        return h;
+    }
+
+private:
+    static constexpr uint32_t ALIGN = 8;
+    static constexpr uint32_t align(uint32_t v) { return (v + ALIGN - 1) & ~(ALIGN - 1); }
+
+    bool lapped(uint32_t pos) const { return (uint32_t)(head() - pos) > N; }
+
+    Rec *at(uint32_t pos) { return reinterpret_cast<Rec *>(arena + (pos & (N - 1))); }
+    const Rec *at(uint32_t pos) const { return reinterpret_cast<const Rec *>(arena + (pos & (N - 1))); }
+
+    alignas(8) uint8_t arena[N] = {};
+    uint32_t wpos = 0;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef MINER_STATS_H
+#define MINER_STATS_H
+
+// Per-worker mining statistics (adapted for NukaMiner).
+//
+// Each miner task owns one block and is its only writer. Readers on other
+// cores (web, LCD, loop) take a consistent copy through a seqlock: the writer
+// bumps the sequence to odd, updates, bumps it back to even; a reader retries
+// if it saw an odd sequence or the sequence changed under it. Neither side
+// ever blocks, and no String is shared across cores.
+
+#include <Arduino.h>
+#include <string.h>
+
+struct MinerStatsData {
+    uint32_t hashrate;      // H/s of the last share
+    uint32_t difficulty;    // difficulty of the current job
+    uint32_t shares;        // shares found (submitted)
+    uint32_t accepted;      // shares the node answered GOOD
+    uint32_t ping_ms;       // last submit -> verdict time
+    uint32_t updated_ms;    // millis() of the last publish
+    uint16_t duty_permille; // share of the last hashing run spent hashing (limiter + yields)
+    uint16_t duty_target;   // limiter target for that run (1000 = unlimited)
+    char node[56];          // "host:port" the worker is connected to
+};
+
+class MinerStatsBlock {
+public:
+    // Writer side: only the owning miner task may call this.
+    void publish(const MinerStatsData &src) {
+        const uint32_t s = seq;
+        __atomic_store_n(&seq, s + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(&data, &src, sizeof(data));
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&seq, s + 2, __ATOMIC_RELAXED);
+    }
+
+    // Reader side: any task, any core. Returns false only if the writer kept
+    // the block busy for every retry (out is then left zeroed).
+    bool read(MinerStatsData &out) const {
+        for (uint8_t tries = 0; tries < 16; tries++) {
+            const uint32_t s1 = __atomic_load_n(&seq, __ATOMIC_ACQUIRE);
+            if (s1 & 1u) continue;
+            memcpy(&out, (const void *)&data, sizeof(out));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&seq, __ATOMIC_RELAXED) == s1) return true;
+        }
+        memset(&out, 0, sizeof(out));
+        return false;
+    }
+
+private:
+    uint32_t seq = 0;
+    MinerStatsData data = {};
+};
+
+static constexpr uint8_t NM_STATS_WORKERS = 2;
+
+// Indexed by MiningJob::core (0 = first miner, 1 = "Core 2"). Defined in Settings.cpp.
+extern MinerStatsBlock NM_stats[NM_STATS_WORKERS];
+
+// Aggregate view for readers.
+struct MinerStatsSnapshot {
+    MinerStatsData worker[NM_STATS_WORKERS];
+    uint32_t shares;        // sum over workers
+    uint32_t accepted;      // sum over workers
+    uint8_t latest;         // worker that published most recently
+};
+
+static inline void NM_stats_snapshot(MinerStatsSnapshot &snap) {
+    snap.shares = 0;
+    snap.accepted = 0;
+    snap.latest = 0;
+    for (uint8_t i = 0; i < NM_STATS_WORKERS; i++) {
+        NM_stats[i].read(snap.worker[i]);
+        snap.shares += snap.worker[i].shares;
+        snap.accepted += snap.worker[i].accepted;
+        if (snap.worker[i].updated_ms &&
+            (!snap.worker[snap.latest].updated_ms ||
+             (int32_t)(snap.worker[i].updated_ms - snap.worker[snap.latest].updated_ms) > 0)) {
+            snap.latest = i;
+        }
+    }
+}
+
+#endif
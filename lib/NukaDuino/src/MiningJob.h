@@ -12,6 +12,11 @@
 #include "DSHA1.h"
 #include "Counter.h"
 #include "Settings.h"
+#include "RetryPolicy.h"
+#include "MinerStats.h"
+#include "LiveConfig.h"
+#include "TokenBucket.h"
+#include "Trace.h"
 
 // https://github.com/esp8266/Arduino/blob/master/cores/esp8266/TypeConversion.cpp
 const char base36Chars[36] PROGMEM = {
@@ -25,32 +30,30 @@ const uint8_t base36CharValues[75] PROGMEM{
     10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35                    // Lower case letters
 };
 
+// Warm-standby hooks (implemented in src/main.cpp). The pool manager keeps one
+// pre-connected, greeted socket to a second node; a worker whose node died
+// adopts it instead of retrying the dead node.
+bool NM_take_standby(WiFiClient &client, String &host, int &port, String &greeting);
+void NM_failover_done(int core, uint32_t elapsed_ms, bool via_standby);
+
+// Network quality hooks (implemented in src/main.cpp). Round-trip samples and
+// error events are attributed to the node the worker is actually talking to.
+enum NMNetRtt : uint8_t { NM_RTT_CONNECT = 0, NM_RTT_GREETING, NM_RTT_JOB, NM_RTT_SUBMIT, NM_RTT_KINDS };
+enum NMNetEvent : uint8_t { NM_NET_CONNECT = 0, NM_NET_CONNECT_FAIL, NM_NET_TIMEOUT, NM_NET_DISCONNECT, NM_NET_TRUNCATED };
+void NM_net_rtt(const String &host, int port, uint8_t kind, uint32_t ms);
+void NM_net_event(const String &host, int port, uint8_t kind);
+
 #define SPC_TOKEN ' '
 #define END_TOKEN '\n'
 #define SEP_TOKEN ','
 #define IOT_TOKEN '@'
 
+// Node the worker mines on. Private to the owning miner task; everything
+// user-facing (user, key, rig id, group id, limiter) comes from the live
+// snapshot (LiveConfig.h), with the protocol lines already formatted.
 struct MiningConfig {
     String host = "";
     int port = 0;
-    String DUCO_USER = "";
-    String RIG_IDENTIFIER = "";
-    String MINER_KEY = "";
-    String GROUP_ID = "";
-    String MINER_VER = SOFTWARE_VERSION;
-    #if defined(ESP8266)
-        // "High-band" 8266 diff
-        String START_DIFF = "ESP8266H";
-    #elif defined(CONFIG_FREERTOS_UNICORE)
-        // Single core 32 diff
-        String START_DIFF = "ESP32S";
-    #else
-        // Normal 32 diff
-        String START_DIFF = "ESP32";
-    #endif
-
-    MiningConfig(String DUCO_USER, String RIG_IDENTIFIER, String MINER_KEY, String GROUP_ID = "")
-            : DUCO_USER(DUCO_USER), RIG_IDENTIFIER(RIG_IDENTIFIER), MINER_KEY(MINER_KEY), GROUP_ID(GROUP_ID) {}
 };
 
 class MiningJob {
@@ -62,12 +65,27 @@ public:
     MiningJob(int core, MiningConfig *config) {
         this->core = core;
         this->config = config;
-        this->client_buffer = "";
+        // Carry totals over a miner restart (the block outlives the job).
+        NM_stats[statsIndex()].read(_stats);
         dsha1 = new DSHA1();
         dsha1->warmup();
-        generateRigIdentifier();
     }
 
+    ~MiningJob() {
+        client.stop();
+        delete dsha1;
+    }
+
+    // Stop protocol: any task may request a stop; the hash loop, the connect
+    // retries and every node read check the flag, so mine() returns within a
+    // few milliseconds (or one blocking connect) and the owning task can exit.
+    void requestStop() { __atomic_store_n(&_cancel, true, __ATOMIC_RELEASE); }
+    bool stopRequested() const { return __atomic_load_n(&_cancel, __ATOMIC_ACQUIRE); }
+
+    // Health supervisor: drop the node socket at the start of the next share
+    // cycle (without the failover clock) and connect afresh.
+    void requestReconnect() { __atomic_store_n(&_reconnect, true, __ATOMIC_RELEASE); }
+
     void blink(uint8_t count, uint8_t pin = LED_BUILTIN) {
         #if defined(LED_BLINKING)
             uint8_t state = HIGH;
@@ -110,17 +128,136 @@ public:
         // requiring ArduinoOTA.
     }
 
+    static const char *minerBanner() {
+        #if defined(ESP8266)
+            #if defined(BLUSHYBOX)
+              return "Official BlushyBox Miner (ESP8266)";
+            #else
+              return "Official ESP8266 Miner";
+            #endif
+        #elif defined(CONFIG_FREERTOS_UNICORE)
+            return "Official ESP32-S2 Miner";
+        #else
+            #if defined(BLUSHYBOX)
+              return "Official BlushyBox Miner (ESP32)";
+            #else
+              return "Official ESP32 Miner";
+            #endif
+        #endif
+    }
+
+    static const char *startDiff() {
+        #if defined(ESP8266)
+            return "ESP8266H";  // "High-band" 8266 diff
+        #elif defined(CONFIG_FREERTOS_UNICORE)
+            return "ESP32S";    // Single core 32 diff
+        #else
+            return "ESP32";     // Normal 32 diff
+        #endif
+    }
+
+    static String chipIdString() {
+        #if defined(ESP8266)
+            return String(ESP.getChipId(), HEX);
+        #else
+            uint64_t chip_id = ESP.getEfuseMac();
+            uint16_t chip = (uint16_t)(chip_id >> 32); // Prepare to print a 64 bit value into a char array
+            char fullChip[23];
+            snprintf(fullChip, 23, "%04X%08X", chip,
+                    (uint32_t)chip_id); // Store the (actually) 48 bit chip_id into a char array
+            return String(fullChip);
+        #endif
+    }
+
+    // Build the protocol fragments of a live snapshot from its user, key, rig
+    // id and group id. Runs once per settings change in the publisher, so the
+    // share path only appends the nonce and hashrate.
+    static void formatLive(NMMinerLive &live) {
+        String rig = live.rig_id;
+        if (strcmp(rig.c_str(), "Auto") == 0) {
+            #if defined(ESP8266)
+                rig = "ESP8266-" + chipIdString();
+            #else
+                rig = "ESP32-" + chipIdString();
+            #endif
+            rig.toUpperCase();
+        }
+        live.job_prefix = String("JOB,") + live.user + SEP_TOKEN + startDiff() + SEP_TOKEN + live.key;
+        live.job_line = live.job_prefix + END_TOKEN;
+        // Duino-Coin PC miners can "group" multiple workers (threads) into a single
+        // dashboard entry by appending a shared group-id to the share submission line.
+        // When the group id is set and shared across workers, the dashboard shows one miner
+        // with N threads instead of N separate miners.
+        live.submit_tail = String(SEP_TOKEN) + minerBanner() +
+                           SPC_TOKEN + SOFTWARE_VERSION +
+                           SEP_TOKEN + rig +
+                           // Field after identifier: device ID (optional but used by many miners)
+                           SEP_TOKEN + "DUCOID" + chipIdString() +
+                           // Last field: group-id used by the Duino-Coin dashboard to collapse
+                           // multiple workers into a single "threads" entry (PC miner behavior).
+                           SEP_TOKEN + live.group_id +
+                           END_TOKEN;
+    }
+
+    // True when the last mine() failed before hashing (connect or job request),
+    // as opposed to a rejected share. The caller backs off only on these.
+    bool networkFailed() const { return _netFailed; }
+
+    // True when the last mine() ran on the socket of the previous one, i.e. a
+    // steady-state share cycle (no connect, no failover).
+    bool reusedSocket() const { return _reusedSocket; }
+
+    // True while the duty target is 0 (hash limit 0%, or a core the thermal
+    // governor parked). The miner task then waits instead of calling mine():
+    // a paused worker must not hold a job or a node socket.
+    bool paused() {
+        if (_live.version() != NM_live.version()) _live = NM_live.pin();
+        return _live && limitTarget() == 0;
+    }
+
+    // Called by the miner task while paused: close the node socket (the node
+    // would time it out anyway) and report the worker as idle.
+    void park() {
+        if (client.connected()) {
+            NM_LOGI("Core [%d] - Paused, closing node socket", core);
+            client.stop();
+        }
+        _lostAtMs = 0;   // not a failover
+        if (_stats.hashrate != 0 || _stats.duty_target != 0) {
+            _stats.hashrate = 0;
+            _stats.duty_target = 0;
+            publishStats();
+        }
+    }
+
     // Mine a single share cycle.
     // Returns true if a share was accepted ("GOOD"), false on failure
     // (connect/job failures or rejected share).
     bool mine() {
-        if (!connectToNode()) return false;
-        if (!askForJob()) return false;
+        // Pick up settings changes between shares.
+        if (_live.version() != NM_live.version()) _live = NM_live.pin();
 
-        dsha1->reset().write((const unsigned char *)getLastBlockHash().c_str(), getLastBlockHash().length());
+        if (__atomic_exchange_n(&_reconnect, false, __ATOMIC_ACQ_REL)) {
+            NM_LOGW("Core [%d] - Reconnect requested, closing node socket", core);
+            client.stop();
+            _lostAtMs = 0;
+        }
+
+        _netFailed = true;
+        _reusedSocket = client.connected();
+        if (!_live) return false;   // nothing published yet
+        NM_set_net_busy(core, true);
+        if (!connectToNode()) { NM_set_net_busy(core, false); noteNodeLost(); return false; }
+        if (!askForJob()) { NM_set_net_busy(core, false); noteNodeLost(); return false; }
+        _netFailed = false;
+        NM_set_net_busy(core, false);
+
+        dsha1->reset().write((const unsigned char *)_lastHash, _lastHashLen);
 
         const uint32_t start_time = micros();
         max_micros_elapsed(start_time, 0);
+        _limiter.configure(limitTarget());
+        _limiter.start(start_time);
 
         #if defined(LED_BLINKING)
             #if defined(BLUSHYBOX)
@@ -134,9 +271,11 @@ public:
         #endif
 
         bool accepted = false;
+        bool pausedMidJob = false;
 
+        NM_TRACE_BEGIN(trHash);
         uint32_t limiterIter = 0;
-        for (Counter<10> counter; counter < difficulty; ++counter, ++limiterIter) {
+        for (Counter<10> counter; counter < _difficulty; ++counter, ++limiterIter) {
             DSHA1 ctx = *dsha1;
             ctx.write((const unsigned char *)counter.c_str(), counter.strlen()).finalize(hashArray);
 
@@ -146,16 +285,51 @@ public:
                 yield();
             }
 
-            // Hard idle guarantee on CPU0 (core==0) to prevent IDLE0 task watchdog resets
-            // when both miners run at 100%. We only do this on the CPU0 miner so Core2 speed
-            // remains essentially unaffected.
-            if (core == 0) {
-                // Guarantee the CPU0 IDLE task runs often enough to satisfy the task watchdog.
-                // This keeps WiFi/Web responsive and prevents IDLE0 WDT resets at full load.
-                const uint32_t nowMs = millis();
-                if (_idleKickMs == 0 || (uint32_t)(nowMs - _idleKickMs) >= 15) {
-                    _idleKickMs = nowMs;
-                    delay(1); // yield one RTOS tick so IDLE0 can run
+            // Blocking yield so lower-priority tasks get the CPU: on CPU0 this
+            // keeps IDLE0 (task watchdog) fed at full load, on CPU1 it bounds
+            // loop()/LCD latency. The slice comes from the yield controller;
+            // the clock is only checked every 64 hashes to keep it cheap.
+            if ((limiterIter & 0x3Fu) == 0u) {
+                if (stopRequested()) break;
+                _limiter.mark(micros(), true);
+
+                // A new limit from the web UI or the thermal governor
+                // applies mid-job.
+                if (_live.version() != NM_live.version()) {
+                    _live = NM_live.pin();
+                    if (!_live) break;
+                }
+                const uint16_t target = limitTarget();
+                // Paused mid-job: drop the job; the miner task parks.
+                if (target == 0) { pausedMidJob = true; break; }
+                if (target != _limiter.duty()) _limiter.configure(target);
+
+                // Hash-rate limiter: block whole ticks once the bucket owes
+                // one; sub-tick debt carries over to the next check.
+                if (_limiter.limiting()) {
+                    const uint32_t owed = _limiter.owedUs(portTICK_PERIOD_MS * 1000);
+                    if (owed) {
+                        delay(owed >= 100000 ? 100 : owed / 1000);
+                        _limiter.mark(micros(), false);
+                        _idleKickMs = millis();
+                    }
+                }
+
+                // Keyed by the CPU this task runs on, not the worker: either
+                // worker may be pinned to CPU0, where IDLE0 must get its tick.
+                NMYieldCfg &yc = NM_yield_cfg[xPortGetCoreID() ? 1 : 0];
+                const uint16_t sliceMs = yc.slice_ms;
+                if (sliceMs) {
+                    const uint32_t nowMs = millis();
+                    if (_idleKickMs == 0 || (uint32_t)(nowMs - _idleKickMs) >= sliceMs) {
+                        const uint32_t y0 = micros();
+                        delay(1); // yield one RTOS tick
+                        const uint32_t y1 = micros();
+                        _limiter.mark(y1, false);
+                        _idleKickMs = millis();
+                        __atomic_fetch_add(&yc.yielded_us, y1 - y0, __ATOMIC_RELAXED);
+                        NM_EVENT(HASH_YIELD, (unsigned long)core, (unsigned long)(y1 - y0), (unsigned long)sliceMs);
+                    }
                 }
             }
 
@@ -176,7 +350,8 @@ public:
             if (memcmp(getExpectedHash(), hashArray, 20) == 0) {
                 const uint32_t elapsed_time = micros() - start_time;
                 const float elapsed_time_s = elapsed_time * .000001f;
-                share_count++;
+                _stats.shares++;
+                NM_EVENT(NONCE_FOUND, (unsigned long)core, (unsigned long)counter, (unsigned long)elapsed_time);
 
                 #if defined(LED_BLINKING)
                     #if defined(BLUSHYBOX)
@@ -189,68 +364,97 @@ public:
                     #endif
                 #endif
 
-                if (String(core) == "0") {
-                    hashrate = counter / elapsed_time_s;
-                    submit(counter, hashrate, elapsed_time_s);
-                } else {
-                    hashrate_core_two = counter / elapsed_time_s;
-                    submit(counter, hashrate_core_two, elapsed_time_s);
-                }
+                NM_set_net_busy(core, true);
+                _limiter.mark(micros(), true);
+                _stats.duty_permille = _limiter.achieved();
+                _stats.duty_target = _limiter.duty();
+                _stats.hashrate = counter / elapsed_time_s;
+                submit(counter, _stats.hashrate, elapsed_time_s);
 
-                accepted = (client_buffer == "GOOD");
+                accepted = lineIs("GOOD");
 
                 #if defined(BLUSHYBOX)
-                    gauge_set(hashrate + hashrate_core_two);
+                    MinerStatsSnapshot snap;
+                    NM_stats_snapshot(snap);
+                    gauge_set(snap.worker[0].hashrate + snap.worker[1].hashrate);
                 #endif
 
                 break;
             }
         }
 
+        NM_TRACE_END(trHash, NM_TC_MINER, "hash");
+        NM_set_net_busy(core, false);
+        if (pausedMidJob) park();
+        else noteNodeLost();
         return accepted;
     }
 
 
 private:
-    String client_buffer;
+    // Last line read from the node (without the newline). Fixed buffers keep
+    // the share cycle free of heap allocations once connected.
+    static constexpr size_t LINE_MAX = 160;
+    char _line[LINE_MAX] = {};
+    size_t _lineLen = 0;
     uint8_t hashArray[20];
-    String last_block_hash;
-    String expected_hash_str;
+    char _lastHash[48] = {};       // previous block hash (40 hex chars)
+    size_t _lastHashLen = 0;
+    char _expectedHex[48] = {};    // for logs only
     uint8_t expected_hash[20];
     DSHA1 *dsha1;
     uint32_t _micros_start = 0;
-    uint32_t _limitWindowStartMs = 0;
+    TokenBucket _limiter;
     uint32_t _idleKickMs = 0;
-    WiFiClient client;
-    String chipID = "";
+    bool _cancel = false;
+    bool _reconnect = false;
+    SnapshotCell<NMMinerLive>::Ref _live;
+    // Failover bookkeeping: when the node connection was lost (0 = healthy)
+    // and whether the current socket came from the pool manager's standby.
+    // Only a node that has handed out a job can be lost; a first connect
+    // that fails is not a failover.
+    uint32_t _lostAtMs = 0;
+    bool _onStandby = false;
+    bool _hadJob = false;
+    bool _netFailed = false;
+    bool _reusedSocket = false;
+    String _nodeHost;    // node the socket is connected to (standby may differ from config)
+    int _nodePort = 0;
+    unsigned int _difficulty = 0;
+    MinerStatsData _stats = {};  // private copy; published to NM_stats[]
+
+    uint8_t statsIndex() const { return core == 0 ? 0 : 1; }
+
+    // Limiter duty (permille): the user's limit, lowered by the thermal governor.
+    uint16_t limitTarget() const {
+        const uint16_t user = (uint16_t)_live->hash_limit_pct[statsIndex()] * 10;
+        const uint16_t thermal = NM_thermal_duty[statsIndex()];
+        return user < thermal ? user : thermal;
+    }
 
-    #if defined(ESP8266)
-        #if defined(BLUSHYBOX)
-          String MINER_BANNER = "Official BlushyBox Miner (ESP8266)";
-        #else
-          String MINER_BANNER = "Official ESP8266 Miner";
-        #endif
-    #elif defined(CONFIG_FREERTOS_UNICORE)
-        String MINER_BANNER = "Official ESP32-S2 Miner";
-    #else
-        #if defined(BLUSHYBOX)
-          String MINER_BANNER = "Official BlushyBox Miner (ESP32)";
-        #else
-          String MINER_BANNER = "Official ESP32 Miner";
-        #endif
-    #endif
+    void publishStats() {
+        _stats.updated_ms = millis();
+        NM_stats[statsIndex()].publish(_stats);
+    }
+
+    void setNode(const String &host, int port) {
+        _nodeHost = host;
+        _nodePort = port;
+        snprintf(_stats.node, sizeof(_stats.node), "%s:%d", host.c_str(), port);
+        publishStats();
+    }
+    WiFiClient client;
 
     // Converts a hex string into a byte array.
     // IMPORTANT: Duino-Coin nodes can occasionally return partial lines if the
     // connection is interrupted or read timeouts occur. The upstream miner used
     // an assert() here, but that causes reboot loops on ESP32 when a truncated
     // job line is received. We validate instead and let the caller retry.
-    uint8_t *hexStringToUint8Array(const String &hexString, uint8_t *uint8Array, const uint32_t arrayLength) {
+    uint8_t *hexStringToUint8Array(const char *hexChars, size_t len, uint8_t *uint8Array, const uint32_t arrayLength) {
         // Nodes can occasionally return partial lines; avoid assert/reboot loops.
-        if (hexString.length() < arrayLength * 2) {
+        if (len < arrayLength * 2) {
             return nullptr;
         }
-        const char *hexChars = hexString.c_str();
         for (uint32_t i = 0; i < arrayLength; ++i) {
             uint8Array[i] = (pgm_read_byte(base36CharValues + hexChars[i * 2] - '0') << 4) +
                             pgm_read_byte(base36CharValues + hexChars[i * 2 + 1] - '0');
@@ -258,66 +462,79 @@ private:
         return uint8Array;
     }
 
-    void generateRigIdentifier() {
-        String AutoRigName = "";
-
-        #if defined(ESP8266)
-            chipID = String(ESP.getChipId(), HEX);
-
-            if (strcmp(config->RIG_IDENTIFIER.c_str(), "Auto") != 0)
-                return;
-
-            AutoRigName = "ESP8266-" + chipID;
-            AutoRigName.toUpperCase();
-            config->RIG_IDENTIFIER = AutoRigName.c_str();
-        #else
-            uint64_t chip_id = ESP.getEfuseMac();
-            uint16_t chip = (uint16_t)(chip_id >> 32); // Prepare to print a 64 bit value into a char array
-            char fullChip[23];
-            snprintf(fullChip, 23, "%04X%08X", chip,
-                    (uint32_t)chip_id); // Store the (actually) 48 bit chip_id into a char array
+    // Called after each mine() cycle: a dropped socket starts the failover clock.
+    void noteNodeLost() {
+        if (_hadJob && _lostAtMs == 0 && !client.connected()) {
+            _lostAtMs = millis();
+            if (_lostAtMs == 0) _lostAtMs = 1;
+        }
+    }
 
-            chipID = String(fullChip);
-
-            if (strcmp(config->RIG_IDENTIFIER.c_str(), "Auto") != 0)
-                return;
-            // Autogenerate ID if required
-            AutoRigName = "ESP32-" + String(fullChip);
-            AutoRigName.toUpperCase();
-            config->RIG_IDENTIFIER = AutoRigName.c_str();
-        #endif 
-        #if defined(SERIAL_PRINTING)
-          NM_log("Core [" + String(core) + "] - Rig identifier: "
-                          + config->RIG_IDENTIFIER);
-        #endif
+    bool adoptStandby() {
+        String host, greeting;
+        int port = 0;
+        if (!NM_take_standby(client, host, port, greeting)) return false;
+        setLine(greeting.c_str(), greeting.length());
+        client.setTimeout(15000);
+        client.setNoDelay(true);
+        _onStandby = true;
+        setNode(host, port);
+        NM_net_event(_nodeHost, _nodePort, NM_NET_CONNECT);
+        if (_lostAtMs != 0) {
+            NM_LOGW("Core [%d] - Node lost, switched to standby node %s:%d", core, host.c_str(), port);
+        } else {
+            NM_LOGW("Core [%d] - Node unreachable, using standby node %s:%d", core, host.c_str(), port);
+        }
+        return true;
     }
 
     bool connectToNode() {
         if (client.connected()) return true;
+        NM_TRACE_SCOPE(NM_TC_NET, "connect");
+
+        // The node we were on just died: take the pre-connected standby socket
+        // rather than spending connect retries on a node that is gone.
+        if (_lostAtMs != 0 && adoptStandby()) return true;
+        _onStandby = false;
+
+        // Node breaker is open: don't hammer it, use the standby if there is one.
+        if (!NM_breakers.allow(config->host.c_str(), config->port)) {
+            NM_LOGW("Core [%d] - Node %s:%d breaker open, skipping", core, config->host.c_str(), config->port);
+            return adoptStandby();
+        }
+        BreakerAttempt breaker(config->host.c_str(), config->port);
 
         // Make stream reads less prone to returning partial lines.
         client.setTimeout(15000);
 
         uint32_t stopWatch = millis();
-        #if defined(SERIAL_PRINTING)
-          NM_log("Core [" + String(core) + "] - Connecting to a Duino-Coin node...");
-        #endif
+        NM_LOGI("Core [%d] - Connecting to a Duino-Coin node...", core);
 
+        setNode(config->host, config->port);
+        Backoff backoff(NM_RETRY_CONNECT);
         int attempts = 0;
+        uint32_t t0 = millis();
         while (!client.connect(config->host.c_str(), config->port)) {
             attempts++;
+            NM_net_event(_nodeHost, _nodePort, NM_NET_CONNECT_FAIL);
             if (max_micros_elapsed(micros(), 100000)) {
                 handleSystemEvents();
             }
-            if (attempts >= 3 || (millis() - stopWatch) > 15000) {
-                #if defined(SERIAL_PRINTING)
-                  NM_log("Core [" + String(core) + "] - Failed to connect to node (timeout)");
-                #endif
+            if (stopRequested()) {
                 client.stop();
                 return false;
             }
-            delay(250);
+            if (attempts >= 3 || (millis() - stopWatch) > 15000) {
+                NM_LOGW("Core [%d] - Failed to connect to node (timeout)", core);
+                client.stop();
+                breaker.record(false);
+                return adoptStandby();
+            }
+            delay(backoff.next());
+            t0 = millis();
         }
+        NM_net_rtt(_nodeHost, _nodePort, NM_RTT_CONNECT, millis() - t0);
+        t0 = millis();
 
         // Reduce latency for small request/response packets (helps dashboard ping).
         client.setNoDelay(true);
@@ -325,13 +542,14 @@ private:
         // Wait for server greeting/version
         if (!waitForClientData()) {
             client.stop();
+            breaker.record(false);
             return false;
         }
+        breaker.record(true);
+        NM_net_rtt(_nodeHost, _nodePort, NM_RTT_GREETING, millis() - t0);
+        NM_net_event(_nodeHost, _nodePort, NM_NET_CONNECT);
 
-        #if defined(SERIAL_PRINTING)
-          NM_log("Core [" + String(core) + "] - Connected. Node reported version: "
-                          + client_buffer);
-        #endif
+        NM_LOGI("Core [%d] - Connected. Node reported version: %s", core, _line);
 
         blink(BLINK_CLIENT_CONNECT);
 
@@ -339,207 +557,200 @@ private:
     }
 
     void submit(unsigned long counter, float hashrate, float elapsed_time_s) {
-        // Duino-Coin PC miners can "group" multiple workers (threads) into a single
-        // dashboard entry by appending a shared group-id to the share submission line.
-        // When GROUP_ID is set and shared across workers, the dashboard shows one miner
-        // with N threads instead of N separate miners.
-        String submitLine = String(counter) +
-                     SEP_TOKEN + String(hashrate) +
-                     SEP_TOKEN + MINER_BANNER +
-                     SPC_TOKEN + config->MINER_VER +
-                     SEP_TOKEN + config->RIG_IDENTIFIER +
-                     // Field after identifier: device ID (optional but used by many miners)
-                     SEP_TOKEN + "DUCOID" + String(chipID) +
-                     // Last field: group-id used by the Duino-Coin dashboard to collapse
-                     // multiple workers into a single "threads" entry (PC miner behavior).
-                     SEP_TOKEN + config->GROUP_ID +
-                     END_TOKEN;
-        client.print(submitLine);
+        NM_TRACE_SCOPE(NM_TC_NET, "submit");
+        const uint32_t cost0 = micros();
+        // "<nonce>,<hashrate>" + the preformatted tail, sent as one write so
+        // the share leaves in a single segment (TCP_NODELAY is on).
+        const String &tail = _live->submit_tail;
+        char line[256];
+        const int n = snprintf(line, sizeof(line), "%lu,%.2f", counter, hashrate);
+        if (n > 0 && (size_t)n + tail.length() < sizeof(line)) {
+            memcpy(line + n, tail.c_str(), tail.length());
+            client.write((const uint8_t *)line, n + tail.length());
+        } else {
+            client.print(String(counter) + SEP_TOKEN + String(hashrate) + tail);
+        }
 
+        const uint32_t cost1 = micros();
         unsigned long ping_start = millis();
-        waitForClientData();
-        ping = millis() - ping_start;
-
-        if (client_buffer == "GOOD") {
-          accepted_share_count++;
+        const bool answered = waitForClientData();
+        const uint32_t ping = millis() - ping_start;
+        const uint32_t cost2 = micros();
+        if (answered) NM_net_rtt(_nodeHost, _nodePort, NM_RTT_SUBMIT, ping);
+
+        _stats.ping_ms = ping;
+        const bool good = lineIs("GOOD");
+        if (good) {
+          _stats.accepted++;
+        }
+        publishStats();
+
+        if (good) {
+            NM_EVENT(SHARE_GOOD, (unsigned long)core, (unsigned long)_stats.shares, counter,
+                     hashrate / 1000, elapsed_time_s, (unsigned long)ping);
+        } else {
+            NM_LOGI("Core [%d] - %s share #%lu (%lu) hashrate: %.2f kH/s (%.2fs) Ping: %lums (%s)",
+                    core, _line, (unsigned long)_stats.shares, counter,
+                    hashrate / 1000, elapsed_time_s, (unsigned long)ping, _stats.node);
         }
 
-        #if defined(SERIAL_PRINTING)
-          NM_log("Core [" + String(core) + "] - " +
-                          client_buffer +
-                          " share #" + String(share_count) +
-                          " (" + String(counter) + ")" +
-                          " hashrate: " + String(hashrate / 1000, 2) + " kH/s (" +
-                          String(elapsed_time_s) + "s) " + 
-                          "Ping: " + String(ping) + "ms " +
-                          "(" + node_id + ")\n");
-        #endif
+        NM_share_cost_add((cost1 - cost0) + (micros() - cost2));
     }
 
-    bool parse() {
-        // Create a non-constant copy of the input string
-        char *job_str_copy = strdup(client_buffer.c_str());
-
-        if (job_str_copy) {
-            String tokens[3];
-            char *token = strtok(job_str_copy, ",");
-            for (int i = 0; token != NULL && i < 3; i++) {
-                tokens[i] = token;
-                token = strtok(NULL, ",");
-            }
-
-            // Ensure we actually got all 3 tokens
-            if (tokens[0].length() == 0 || tokens[1].length() == 0 || tokens[2].length() == 0) {
-                free(job_str_copy);
-                return false;
-            }
+    bool lineIs(const char *text) const { return strcmp(_line, text) == 0; }
 
-            // Nodes may include a trailing '\r'
-            tokens[0].trim();
-            tokens[1].trim();
-            tokens[2].trim();
+    void setLine(const char *text, size_t len) {
+        if (len >= LINE_MAX) len = LINE_MAX - 1;
+        memcpy(_line, text, len);
+        _line[len] = 0;
+        _lineLen = len;
+    }
 
-            last_block_hash = tokens[0];
-            expected_hash_str = tokens[1];
-            // Expected hash is 20 bytes => 40 hex chars
-            if (hexStringToUint8Array(expected_hash_str, expected_hash, 20) == nullptr) {
-                free(job_str_copy);
-                return false;
-            }
+    // Strips leading/trailing whitespace in place (nodes may send "\r").
+    static char *trimToken(char *t) {
+        while (*t && isspace((unsigned char)*t)) t++;
+        char *end = t + strlen(t);
+        while (end > t && isspace((unsigned char)end[-1])) *--end = 0;
+        return t;
+    }
 
-            int diff = tokens[2].toInt();
-            if (diff <= 0) {
-                free(job_str_copy);
-                return false;
-            }
-            difficulty = diff * 100 + 1;
+    // "<last block hash>,<expected hash>,<difficulty>", tokenised in place.
+    bool parse() {
+        char *save = nullptr;
+        char *tokens[3] = {};
+        char *token = strtok_r(_line, ",", &save);
+        for (int i = 0; token != NULL && i < 3; i++) {
+            tokens[i] = trimToken(token);
+            token = strtok_r(NULL, ",", &save);
+        }
 
-            // Free the memory allocated by strdup
-            free(job_str_copy);
+        // Ensure we actually got all 3 tokens
+        if (!tokens[0] || !tokens[1] || !tokens[2] || !*tokens[0] || !*tokens[1] || !*tokens[2]) {
+            return false;
+        }
 
-            return true;
+        const size_t lastLen = strlen(tokens[0]);
+        const size_t expLen = strlen(tokens[1]);
+        if (lastLen >= sizeof(_lastHash) || expLen >= sizeof(_expectedHex)) return false;
+        // Expected hash is 20 bytes => 40 hex chars
+        if (hexStringToUint8Array(tokens[1], expLen, expected_hash, 20) == nullptr) {
+            return false;
         }
-        else {
-            // Handle memory allocation failure
+
+        const int diff = atoi(tokens[2]);
+        if (diff <= 0) {
             return false;
         }
+        memcpy(_lastHash, tokens[0], lastLen + 1);
+        _lastHashLen = lastLen;
+        memcpy(_expectedHex, tokens[1], expLen + 1);
+        _difficulty = diff * 100 + 1;
+        _stats.difficulty = _difficulty;
+        publishStats();
+        return true;
     }
 
     bool askForJob() {
         if (!client.connected()) return false;
+        NM_TRACE_SCOPE(NM_TC_NET, "job");
 
-        NM_log("Core [" + String(core) + "] - Asking for a new job for user: " 
-                        + String(config->DUCO_USER));
+        NM_LOGD("Core [%d] - Asking for a new job for user: %s", core, _live->user.c_str());
 
         #if defined(USE_DS18B20)
             sensors.requestTemperatures(); 
             float temp = sensors.getTempCByIndex(0);
-            #if defined(SERIAL_PRINTING)
-              NM_log("DS18B20 reading: " + String(temp) + "°C");
-            #endif
+            NM_LOGD("DS18B20 reading: %.2f°C", temp);
         
-            client.print("JOB," +
-                         String(config->DUCO_USER) +
-                         SEP_TOKEN + config->START_DIFF + 
-                         SEP_TOKEN + String(config->MINER_KEY) + 
+            client.print(_live->job_prefix +
                          SEP_TOKEN + "Temp:" + String(temp) + "*C" +
                          END_TOKEN);
         #elif defined(USE_DHT)
             float temp = dht.readTemperature();
             float hum = dht.readHumidity();
-            #if defined(SERIAL_PRINTING)
-              NM_log("DHT reading: " + String(temp) + "°C");
-              NM_log("DHT reading: " + String(hum) + "%");
-            #endif
+            NM_LOGD("DHT reading: %.2f°C", temp);
+            NM_LOGD("DHT reading: %.2f%%", hum);
 
-            client.print("JOB," +
-                         String(config->DUCO_USER) +
-                         SEP_TOKEN + config->START_DIFF + 
-                         SEP_TOKEN + String(config->MINER_KEY) + 
+            client.print(_live->job_prefix +
                          SEP_TOKEN + "Temp:" + String(temp) + "*C" +
                          IOT_TOKEN + "Hum:" + String(hum) + "%" +
                          END_TOKEN);
         #elif defined(USE_HSU07M)
             float temp = read_hsu07m();
-            #if defined(SERIAL_PRINTING)
-              NM_log("HSU reading: " + String(temp) + "°C");
-            #endif
+            NM_LOGD("HSU reading: %.2f°C", temp);
 
-            client.print("JOB," +
-                         String(config->DUCO_USER) +
-                         SEP_TOKEN + config->START_DIFF + 
-                         SEP_TOKEN + String(config->MINER_KEY) + 
+            client.print(_live->job_prefix +
                          SEP_TOKEN + "Temp:" + String(temp) + "*C" +
                          END_TOKEN);
         #elif defined(USE_INTERNAL_SENSOR)
             float temp = 0;
             temp_sensor_read_celsius(&temp);
-            #if defined(SERIAL_PRINTING)
-              NM_log("Internal temp sensor reading: " + String(temp) + "°C");
-            #endif
+            NM_LOGD("Internal temp sensor reading: %.2f°C", temp);
 
-            client.print("JOB," +
-                         String(config->DUCO_USER) +
-                         SEP_TOKEN + config->START_DIFF + 
-                         SEP_TOKEN + String(config->MINER_KEY) + 
+            client.print(_live->job_prefix +
                          SEP_TOKEN + "CPU Temp:" + String(temp) + "*C" +
                          END_TOKEN);
         #else
-            client.print("JOB," +
-                         String(config->DUCO_USER) +
-                         SEP_TOKEN + config->START_DIFF + 
-                         SEP_TOKEN + String(config->MINER_KEY) + 
-                         END_TOKEN);
+            client.write((const uint8_t *)_live->job_line.c_str(), _live->job_line.length());
         #endif
 
+        const uint32_t jobStart = millis();
         if (!waitForClientData()) return false;
-        #if defined(SERIAL_PRINTING)
-          NM_log("Core [" + String(core) + "] - Received job with size of "
-                          + String(client_buffer.length()) 
-                          + " bytes " + client_buffer);
-        #endif
+        const uint32_t jobMs = millis() - jobStart;
+        NM_net_rtt(_nodeHost, _nodePort, NM_RTT_JOB, jobMs);
+        NM_LOGV("Core [%d] - Received job with size of %u bytes %s",
+                core, (unsigned)_lineLen, _line);
 
         if (!parse()) {
-            #if defined(SERIAL_PRINTING)
-              NM_log("Core [" + String(core) + "] - Invalid/truncated job received, retrying...");
-            #endif
+            NM_net_event(_nodeHost, _nodePort, NM_NET_TRUNCATED);
+            NM_LOGW("Core [%d] - Invalid/truncated job received, retrying...", core);
             return false;
         }
-        #if defined(SERIAL_PRINTING)
-          NM_log("Core [" + String(core) + "] - Parsed job: " 
-                          + getLastBlockHash() + " " 
-                          + getExpectedHashStr() + " " 
-                          + String(getDifficulty()));
-        #endif
+        _hadJob = true;
+        if (_lostAtMs != 0) {
+            NM_failover_done(core, millis() - _lostAtMs, _onStandby);
+            _lostAtMs = 0;
+        }
+        NM_EVENT(JOB_RECEIVED, (unsigned long)core, (unsigned long)getDifficulty(), (unsigned long)jobMs);
+        NM_LOGV("Core [%d] - Parsed job: %s %s %u", core,
+                getLastBlockHash(), getExpectedHashStr(), getDifficulty());
     
         return true;
     }
 
     // Returns true if a full line was read, false on timeout/disconnect.
     bool waitForClientData() {
-        client_buffer = "";
+        _line[0] = 0;
+        _lineLen = 0;
         const uint32_t stopWatch = millis();
         while (client.connected()) {
+            if (stopRequested()) return false;
             if (client.available()) {
-                client_buffer = client.readStringUntil(END_TOKEN);
-                if (client_buffer.length() == 1 && client_buffer[0] == END_TOKEN)
-                    client_buffer = "???\n"; // Should never happen
+                const size_t n = client.readBytesUntil(END_TOKEN, _line, LINE_MAX - 1);
+                _line[n] = 0;
+                _lineLen = n;
+                // Overlong line: drop the rest so the next read starts clean.
+                if (n == LINE_MAX - 1) {
+                    char c;
+                    while (client.readBytes(&c, 1) == 1 && c != END_TOKEN) {}
+                }
                 return true;
             }
             if (max_micros_elapsed(micros(), 100000)) {
                 handleSystemEvents();
             }
             if ((millis() - stopWatch) > 15000) {
+                NM_net_event(_nodeHost, _nodePort, NM_NET_TIMEOUT);
                 return false;
             }
         }
+        NM_net_event(_nodeHost, _nodePort, NM_NET_DISCONNECT);
         return false;
     }
 
-    const String &getLastBlockHash() const { return last_block_hash; }
-    const String &getExpectedHashStr() const { return expected_hash_str; }
+    const char *getLastBlockHash() const { return _lastHash; }
+    const char *getExpectedHashStr() const { return _expectedHex; }
     const uint8_t *getExpectedHash() const { return expected_hash; }
-    unsigned int getDifficulty() const { return difficulty; }
+    unsigned int getDifficulty() const { return _difficulty; }
 };
 
 #endif
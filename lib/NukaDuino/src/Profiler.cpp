@@ -0,0 +1,323 @@
+#include "Profiler.h"
+
+#include <Arduino.h>
+#include <string.h>
+
+#if defined(NM_PROFILER)
+
+#include <esp_attr.h>
+#include <esp_debug_helpers.h>
+#include <freertos/xtensa_context.h>
+
+namespace {
+
+constexpr uint8_t TASK_SLOTS = 16;
+constexpr uint8_t PROBES = 16;
+constexpr uint8_t TIMER_NUM[2] = {2, 3};    // timer group 1, clear of the core's own users
+
+struct Stack {
+    uint32_t count;       // 0 = free slot
+    uint32_t hash;
+    uint8_t core;
+    uint8_t task;
+    uint8_t depth;
+    uint8_t reserved;
+    uint32_t pc[NM_PROF_MAX_DEPTH];
+};
+
+struct Task {
+    void *handle;
+    char name[16];
+};
+
+volatile bool s_on = false;
+uint32_t s_samplers = 0;               // timer ISRs inside sample()
+Stack *s_table = nullptr;
+uint16_t s_slots = 0;
+uint16_t s_hz = 0;
+uint8_t s_depth = 0;
+volatile uint16_t s_stacks = 0;
+volatile uint32_t s_samples = 0;
+volatile uint32_t s_dropped = 0;
+uint32_t s_startMs = 0;
+uint32_t s_runMs = 0;                  // finished runs (start..stop)
+
+Task s_tasks[TASK_SLOTS];
+volatile uint8_t s_taskCount = 1;      // slot 0: unknown
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+hw_timer_t *s_timer[2] = {nullptr, nullptr};
+volatile bool s_timerReady[2] = {false, false};
+
+inline uint32_t IRAM_ATTR decodePc(uint32_t pc) {
+    if (pc & 0x80000000u) pc = (pc & 0x3fffffffu) | 0x40000000u;
+    return pc;
+}
+
+uint8_t IRAM_ATTR taskSlot(void *h) {
+    const uint8_t n = s_taskCount;
+    for (uint8_t i = 1; i < n; i++) {
+        if (s_tasks[i].handle == h) return i;
+    }
+    uint8_t slot = 0;
+    portENTER_CRITICAL_ISR(&s_mux);
+    for (uint8_t i = 1; i < s_taskCount; i++) {
+        if (s_tasks[i].handle == h) { slot = i; break; }
+    }
+    if (!slot && s_taskCount < TASK_SLOTS) {
+        slot = s_taskCount;
+        Task &t = s_tasks[slot];
+        t.handle = h;
+        // The task is running, so its name is valid; copy it while it is.
+        const char *name = pcTaskGetName((TaskHandle_t)h);
+        uint8_t i = 0;
+        for (; name && name[i] && i < sizeof(t.name) - 1; i++) t.name[i] = name[i];
+        t.name[i] = 0;
+        s_taskCount = slot + 1;
+    }
+    portEXIT_CRITICAL_ISR(&s_mux);
+    return slot;
+}
+
+void IRAM_ATTR record(uint8_t core) {
+    void *h = xTaskGetCurrentTaskHandleForCPU(core);
+    if (!h) return;
+    // First TCB field: pxTopOfStack, which interrupt entry pointed at the
+    // interrupted context (level-1 timer interrupts do not nest).
+    const XtExcFrame *f = *(const XtExcFrame *const *)h;
+    if (!f) return;
+    s_samples = s_samples + 1;
+
+    Stack cur;
+    cur.count = 0;   // copied first when claiming a slot; count = 1 is the commit
+    cur.core = core;
+    cur.task = taskSlot(h);
+    cur.pc[0] = decodePc(f->pc);
+    cur.depth = 1;
+    esp_backtrace_frame_t bt = {};
+    bt.pc = f->pc;
+    bt.sp = f->a1;
+    bt.next_pc = f->a0;
+    bt.exc_frame = f;
+    while (cur.depth < s_depth && bt.next_pc && esp_backtrace_get_next_frame(&bt)) {
+        cur.pc[cur.depth++] = decodePc(bt.pc) - 3;   // return address -> call site
+    }
+    uint32_t hash = 2166136261u ^ ((uint32_t)core << 8 | cur.task);
+    for (uint8_t i = 0; i < cur.depth; i++) hash = (hash ^ cur.pc[i]) * 16777619u;
+    cur.hash = hash;
+
+    // Each core only inserts its own stacks (core is part of the key), but
+    // both cores probe the same table: claim free slots under the lock.
+    for (uint8_t p = 0; p < PROBES; p++) {
+        Stack &s = s_table[(hash + p) % s_slots];
+        if (s.count && s.hash == hash && s.core == core && s.task == cur.task && s.depth == cur.depth &&
+            memcmp(s.pc, cur.pc, cur.depth * sizeof(uint32_t)) == 0) {
+            __atomic_fetch_add(&s.count, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        if (!s.count) {
+            bool mine = false;
+            portENTER_CRITICAL_ISR(&s_mux);
+            if (!s.count) {
+                memcpy(&s, &cur, sizeof(Stack) - sizeof(s.pc) + cur.depth * sizeof(uint32_t));
+                s.count = 1;
+                s_stacks = s_stacks + 1;
+                mine = true;
+            }
+            portEXIT_CRITICAL_ISR(&s_mux);
+            if (mine) return;
+            p--;   // lost the race for this slot: look at it again
+        }
+    }
+    s_dropped = s_dropped + 1;
+}
+
+// Announce the sample before looking at the table: quiesce() clears s_on
+// first and then waits for the count to drop.
+void IRAM_ATTR sample(uint8_t core) {
+    __atomic_fetch_add(&s_samplers, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s_on, __ATOMIC_SEQ_CST) && s_table) record(core);
+    __atomic_fetch_sub(&s_samplers, 1, __ATOMIC_RELEASE);
+}
+
+void IRAM_ATTR onTimer0() { sample(0); }
+void IRAM_ATTR onTimer1() { sample(1); }
+
+// The timer interrupt is allocated on the core that attaches it, so each
+// timer is set up from a short task pinned to its core.
+void timerSetupTask(void *arg) {
+    const uint8_t core = (uint8_t)(uintptr_t)arg;
+    hw_timer_t *t = timerBegin(TIMER_NUM[core], 80, true);   // 1 MHz from the 80 MHz APB clock
+    if (t) {
+        timerAttachInterrupt(t, core ? onTimer1 : onTimer0, true);
+        s_timer[core] = t;
+    }
+    s_timerReady[core] = true;
+    vTaskDelete(nullptr);
+}
+
+bool timersReady() {
+    for (uint8_t core = 0; core < 2; core++) {
+        if (s_timerReady[core]) continue;
+        if (xTaskCreatePinnedToCore(timerSetupTask, "profTmr", 2048, (void *)(uintptr_t)core, 20, nullptr,
+                                    core) != pdPASS)
+            return false;
+        for (uint8_t i = 0; i < 50 && !s_timerReady[core]; i++) delay(2);
+    }
+    return s_timer[0] && s_timer[1];
+}
+
+void timersArm(uint16_t hz) {
+    for (uint8_t core = 0; core < 2; core++) {
+        if (!s_timer[core]) continue;
+        // Slightly different periods keep the cores from sampling in lockstep.
+        timerAlarmWrite(s_timer[core], 1000000u / hz + core * 7u, true);
+        timerAlarmEnable(s_timer[core]);
+    }
+}
+
+void timersDisarm() {
+    for (uint8_t core = 0; core < 2; core++) {
+        if (s_timer[core]) timerAlarmDisable(s_timer[core]);
+    }
+}
+
+// Stop sampling and wait for a timer ISR on the other core that got past the
+// s_on check. A sample takes microseconds; false only if one is still inside
+// after ~10 ms, and the table must then stay where it is.
+bool quiesce() {
+    timersDisarm();
+    __atomic_store_n(&s_on, false, __ATOMIC_SEQ_CST);
+    for (uint8_t i = 0; i < 10; i++) {
+        if (__atomic_load_n(&s_samplers, __ATOMIC_SEQ_CST) == 0) return true;
+        delay(1);
+    }
+    return false;
+}
+
+}  // namespace
+
+bool NM_prof_start(uint16_t hz, uint8_t depth, uint16_t slots) {
+    NM_prof_stop();
+    if (!quiesce()) return false;
+    if (hz < 10) hz = 10;
+    if (hz > 1000) hz = 1000;
+    if (depth < 1) depth = 1;
+    if (depth > NM_PROF_MAX_DEPTH) depth = NM_PROF_MAX_DEPTH;
+    if (slots < 64) slots = 64;
+    if (slots > 2048) slots = 2048;
+    if (!timersReady()) return false;
+    if (s_slots != slots) {
+        Stack *old = s_table;
+        s_table = nullptr;
+        s_slots = 0;
+        free(old);
+        Stack *t = (Stack *)malloc(sizeof(Stack) * slots);
+        if (!t) return false;
+        s_table = t;
+        s_slots = slots;
+    }
+    memset(s_table, 0, sizeof(Stack) * s_slots);
+    s_hz = hz;
+    s_depth = depth;
+    s_stacks = 0;
+    s_samples = 0;
+    s_dropped = 0;
+    s_runMs = 0;
+    s_startMs = millis();
+    s_on = true;
+    timersArm(hz);
+    return true;
+}
+
+void NM_prof_stop() {
+    timersDisarm();
+    if (s_on) s_runMs += millis() - s_startMs;
+    __atomic_store_n(&s_on, false, __ATOMIC_SEQ_CST);
+}
+
+bool NM_prof_free() {
+    NM_prof_stop();
+    if (!quiesce()) return false;
+    Stack *old = s_table;
+    s_table = nullptr;
+    s_slots = 0;
+    free(old);
+    return true;
+}
+
+void NM_prof_info(NMProfInfo &out) {
+    out.compiled = true;
+    out.on = s_on;
+    out.hz = s_hz;
+    out.depth = s_depth;
+    out.slots = s_slots;
+    out.stacks = s_stacks;
+    out.samples = s_samples;
+    out.dropped = s_dropped;
+    out.duration_ms = s_runMs + (s_on ? millis() - s_startMs : 0);
+}
+
+size_t NM_prof_dump(NMProfCursor &c, uint8_t *buf, size_t cap) {
+    size_t o = 0;
+    auto put = [&](const void *p, size_t n) {
+        memcpy(buf + o, p, n);
+        o += n;
+    };
+    if (c.stage == 0) {
+        if (cap < 64) return 0;
+        c.resume = s_on;
+        NM_prof_stop();
+        quiesce();   // read-only from here; a straggler only skews one count
+        const uint8_t ver = 1;
+        const uint16_t tasks = s_taskCount;
+        const uint32_t hdr[5] = {s_hz, s_samples, s_dropped, s_stacks, s_runMs};
+        put("NMPF", 4);
+        put(&ver, 1);
+        put(&s_depth, 1);
+        put(&tasks, 2);
+        put(hdr, sizeof(hdr));
+        c.stage = 1;
+        c.pos = 0;
+    }
+    if (c.stage == 1) {
+        for (; c.pos < s_taskCount; c.pos++) {
+            if (o + 16 > cap) return o;
+            char name[16] = "?";
+            if (c.pos) strncpy(name, s_tasks[c.pos].name, sizeof(name) - 1);
+            put(name, 16);
+        }
+        c.stage = 2;
+        c.pos = 0;
+    }
+    if (c.stage == 2) {
+        for (; s_table && c.pos < s_slots; c.pos++) {
+            const Stack &s = s_table[c.pos];
+            if (!s.count) continue;
+            const size_t need = 8 + s.depth * sizeof(uint32_t);
+            if (o + need > cap) return o;
+            const uint8_t meta[4] = {s.core, s.task, s.depth, 0};
+            put(&s.count, 4);
+            put(meta, 4);
+            put(s.pc, s.depth * sizeof(uint32_t));
+        }
+        c.stage = 3;
+        if (c.resume) {
+            // Resume into the same table: the next download is cumulative.
+            s_startMs = millis();
+            s_on = true;
+            timersArm(s_hz);
+        }
+    }
+    return o;
+}
+
+#else
+
+bool NM_prof_start(uint16_t, uint8_t, uint16_t) { return false; }
+void NM_prof_stop() {}
+bool NM_prof_free() { return true; }
+void NM_prof_info(NMProfInfo &out) { memset(&out, 0, sizeof(out)); }
+size_t NM_prof_dump(NMProfCursor &, uint8_t *, size_t) { return 0; }
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Sampling CPU profiler (PC sampler).
+//
+// One hardware timer per core interrupts at `hz`. The ISR reads the
+// interrupted context of the task running on that core: the IDF's interrupt
+// entry saves it on the task stack and stores the frame address in the TCB.
+// It records that PC plus up to `depth` return addresses from the same walk
+// the panic handler uses. Identical stacks (same core and task) are counted
+// in a fixed hash table instead of being logged one by one, so a run can last
+// minutes in ~16 KB. The table is allocated by NM_prof_start().
+//
+// Code that runs with interrupts masked (critical sections, other ISRs) is
+// never sampled; the sample lands just after it instead. The default rate is
+// prime so it does not alias with the 1 kHz RTOS tick.
+//
+// NM_prof_dump() writes the binary sample file tools/nm_profile.py reads,
+// little endian:
+//   header  "NMPF", u8 version (1), u8 max depth, u16 tasks, u32 hz,
+//           u32 samples, u32 dropped, u32 stacks, u32 duration_ms
+//   tasks   tasks x char[16] (index 0 = unknown)
+//   stacks  stacks x { u32 count, u8 core, u8 task, u8 depth, u8 0,
+//                      u32 pc[depth] }   pc[0] = sampled PC, then callers
+//
+// Without NM_PROFILER defined NM_prof_start() fails and nothing is linked in.
+
+#include <stddef.h>
+#include <stdint.h>
+
+static constexpr uint8_t NM_PROF_MAX_DEPTH = 8;
+static constexpr uint16_t NM_PROF_DEFAULT_HZ = 199;
+static constexpr uint16_t NM_PROF_DEFAULT_SLOTS = 384;
+
+struct NMProfInfo {
+    bool compiled;
+    bool on;
+    uint16_t hz;
+    uint8_t depth;
+    uint16_t slots;
+    uint16_t stacks;      // distinct stacks so far
+    uint32_t samples;     // including dropped
+    uint32_t dropped;     // table full
+    uint32_t duration_ms;
+};
+
+// Reset the table and start sampling both cores. hz 10..1000, depth 1..8.
+bool NM_prof_start(uint16_t hz = NM_PROF_DEFAULT_HZ, uint8_t depth = 6,
+                   uint16_t slots = NM_PROF_DEFAULT_SLOTS);
+// Stop sampling; the table stays for download until the next start/free.
+void NM_prof_stop();
+// Stop and release the table; false (table kept) if a sample did not finish.
+bool NM_prof_free();
+void NM_prof_info(NMProfInfo &out);
+
+// Sample file in pieces: call with a zeroed cursor until it returns 0
+// (buf of at least 64 bytes). Sampling is paused while a dump is in progress.
+struct NMProfCursor {
+    uint8_t stage;
+    uint16_t pos;
+    bool resume;
+};
+size_t NM_prof_dump(NMProfCursor &c, uint8_t *buf, size_t cap);
+
+#endif
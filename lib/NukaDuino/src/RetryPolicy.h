@@ -0,0 +1,208 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+// Shared retry policy for miners and the pool task (adapted for NukaMiner).
+//
+// Fixed retry delays make every dongle in a fleet reconnect in lockstep when a
+// node goes down. Instead, retries use capped exponential backoff with jitter,
+// and each node gets a circuit breaker that stops hammering it after repeated
+// failures, then lets a single probe through once the open period expires.
+
+#include <Arduino.h>
+#include <string.h>
+
+struct RetryPolicy {
+    uint32_t base_ms;
+    uint32_t cap_ms;
+};
+
+// Between connect attempts inside MiningJob::connectToNode().
+static constexpr RetryPolicy NM_RETRY_CONNECT = {250, 2000};
+// Between failed mine() cycles in the miner task.
+static constexpr RetryPolicy NM_RETRY_MINER   = {200, 30000};
+// Between failed /getPool lookups in the pool task.
+static constexpr RetryPolicy NM_RETRY_POOL    = {2000, 120000};
+// How long a tripped node breaker stays open before the first probe.
+static constexpr RetryPolicy NM_RETRY_BREAKER = {10000, 300000};
+// A half-open probe that has not reported back by then no longer blocks the
+// next one (its task may be stuck or gone).
+static constexpr uint32_t NM_BREAKER_PROBE_TIMEOUT_MS = 30000;
+
+// "Equal jitter": the n-th delay is d/2 + rand(d/2) with d = min(cap, base*2^n),
+// so retries spread out across devices but never collapse to zero.
+static inline uint32_t NM_backoff_delay_ms(const RetryPolicy &p, uint8_t attempt) {
+    uint32_t d = p.cap_ms;
+    if (attempt < 20 && (p.base_ms << attempt) < p.cap_ms) d = p.base_ms << attempt;
+    const uint32_t half = d / 2;
+    return half + (half ? (uint32_t)(esp_random() % (half + 1)) : 0);
+}
+
+class Backoff {
+public:
+    explicit Backoff(const RetryPolicy &policy) : policy(policy) {}
+
+    // Delay to wait before the next retry; each call grows the window.
+    uint32_t next() {
+        const uint32_t ms = NM_backoff_delay_ms(policy, attempt);
+        if (attempt < 255) attempt++;
+        return ms;
+    }
+
+    void reset() { attempt = 0; }
+    uint8_t attempts() const { return attempt; }
+
+private:
+    RetryPolicy policy;
+    volatile uint8_t attempt = 0;
+};
+
+// Per-node circuit breaker table. Shared by both miner tasks and the pool task
+// (different cores), so every access goes through a spinlock.
+class NodeBreakers {
+public:
+    enum State : uint8_t { CLOSED = 0, OPEN, HALF_OPEN };
+
+    static constexpr uint8_t SLOTS = 4;
+    static constexpr uint8_t TRIP_FAILURES = 3;
+
+    struct Entry {
+        char host[48];
+        int port;
+        State state;
+        uint8_t failures;   // consecutive failures while closed
+        uint8_t trips;      // consecutive open periods (grows the open time)
+        bool probing;       // half-open probe in flight
+        uint32_t probeSinceMs;
+        uint32_t openUntilMs;
+        uint32_t lastUsedMs;
+    };
+
+    // May we try this node now? A half-open breaker admits exactly one probe.
+    bool allow(const char *host, int port) {
+        bool ok = true;
+        const uint32_t now = millis();
+        portENTER_CRITICAL(&mux);
+        Entry *e = find(host, port, now);
+        if (e) {
+            if (e->state == OPEN && (int32_t)(now - e->openUntilMs) >= 0) {
+                e->state = HALF_OPEN;
+                e->probing = false;
+            }
+            if (e->state == OPEN) ok = false;
+            else if (e->state == HALF_OPEN) {
+                ok = !e->probing || (uint32_t)(now - e->probeSinceMs) >= NM_BREAKER_PROBE_TIMEOUT_MS;
+                if (ok) {
+                    e->probing = true;
+                    e->probeSinceMs = now;
+                }
+            }
+        }
+        portEXIT_CRITICAL(&mux);
+        return ok;
+    }
+
+    void record(const char *host, int port, bool success) {
+        const uint32_t now = millis();
+        portENTER_CRITICAL(&mux);
+        Entry *e = find(host, port, now);
+        if (!e && !success) e = claim(host, port, now);
+        if (e) {
+            if (success) {
+                e->state = CLOSED;
+                e->failures = 0;
+                e->trips = 0;
+                e->probing = false;
+            } else if (e->state == HALF_OPEN || ++e->failures >= TRIP_FAILURES) {
+                // Failed probe (or too many failures): open again, for longer.
+                e->state = OPEN;
+                e->probing = false;
+                e->failures = 0;
+                e->openUntilMs = now + NM_backoff_delay_ms(NM_RETRY_BREAKER, e->trips);
+                if (e->trips < 255) e->trips++;
+            }
+        }
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // The attempt allow() admitted ended without a verdict (stop requested):
+    // let the next one probe.
+    void release(const char *host, int port) {
+        portENTER_CRITICAL(&mux);
+        Entry *e = find(host, port, millis());
+        if (e && e->state == HALF_OPEN) e->probing = false;
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // Copy the table out for status reporting. Returns the number of entries.
+    uint8_t snapshot(Entry *out, uint8_t max) {
+        uint8_t n = 0;
+        portENTER_CRITICAL(&mux);
+        for (uint8_t i = 0; i < SLOTS && n < max; i++) {
+            if (slots[i].host[0]) out[n++] = slots[i];
+        }
+        portEXIT_CRITICAL(&mux);
+        return n;
+    }
+
+    static const char *stateName(State s) {
+        switch (s) {
+            case OPEN: return "open";
+            case HALF_OPEN: return "half_open";
+            default: return "closed";
+        }
+    }
+
+private:
+    Entry slots[SLOTS] = {};
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    Entry *find(const char *host, int port, uint32_t now) {
+        for (uint8_t i = 0; i < SLOTS; i++) {
+            if (slots[i].port == port && strncmp(slots[i].host, host, sizeof(slots[i].host) - 1) == 0 && slots[i].host[0]) {
+                slots[i].lastUsedMs = now;
+                return &slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Reuse an empty slot, else the least recently used closed one.
+    Entry *claim(const char *host, int port, uint32_t now) {
+        Entry *victim = nullptr;
+        for (uint8_t i = 0; i < SLOTS; i++) {
+            if (!slots[i].host[0]) { victim = &slots[i]; break; }
+            if (slots[i].state != CLOSED) continue;
+            if (!victim || (int32_t)(slots[i].lastUsedMs - victim->lastUsedMs) < 0) victim = &slots[i];
+        }
+        if (!victim) return nullptr;
+        memset(victim, 0, sizeof(*victim));
+        strncpy(victim->host, host, sizeof(victim->host) - 1);
+        victim->port = port;
+        victim->lastUsedMs = now;
+        return victim;
+    }
+};
+
+// Defined in Settings.cpp.
+extern NodeBreakers NM_breakers;
+
+// One attempt admitted by NM_breakers.allow(): record() reports the result,
+// and leaving the scope without one releases a half-open probe.
+class BreakerAttempt {
+public:
+    BreakerAttempt(const char *host, int port) : host(host), port(port) {}
+    ~BreakerAttempt() {
+        if (!done) NM_breakers.release(host, port);
+    }
+    void record(bool success) {
+        NM_breakers.record(host, port, success);
+        done = true;
+    }
+
+private:
+    const char *host;
+    int port;
+    bool done = false;
+};
+
+#endif
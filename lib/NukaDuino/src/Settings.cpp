@@ -1,16 +1,39 @@
 #include "Settings.h"
+#include "RetryPolicy.h"
+#include "MinerStats.h"
+#include "LiveConfig.h"
 
-unsigned int hashrate = 0;
-unsigned int hashrate_core_two = 0;
-unsigned int difficulty = 0;
-unsigned long share_count = 0;
-unsigned long accepted_share_count = 0;
 String WALLET_ID = "";
-String node_id = "";
-unsigned int ping = 0;
+
+// Per-worker mining statistics (one writer each, seqlock readers).
+MinerStatsBlock NM_stats[NM_STATS_WORKERS];
+
+// Rig id / group id / limiter, swapped in by the web UI without a reconnect.
+SnapshotCell<NMMinerLive> NM_live;
+
+// Per-node circuit breakers shared by both miner tasks and the pool task.
+NodeBreakers NM_breakers;
 
 uint8_t NM_hash_limit_pct_job0 = 100;
 uint8_t NM_hash_limit_pct_job1 = 100;
 
 // Alias (job0) for older code paths
 uint8_t NM_hash_limit_pct = 100;
+
+volatile uint16_t NM_thermal_duty[2] = {1000, 1000};
+
+volatile uint32_t NM_net_busy_mask = 0;
+
+// Runtime log threshold; main.cpp loads it from the config.
+volatile uint8_t NM_log_level = NM_LOG_LEVEL_INFO;
+NMShareCost NM_share_cost[NM_LOG_LEVEL_VERBOSE + 1];
+
+const NMEventDef NM_event_defs[NM_EV_COUNT] = {
+#define NM_EV_DEF(name, level, fmt) {#name, fmt},
+    NM_EVENT_TABLE(NM_EV_DEF)
+#undef NM_EV_DEF
+};
+
+// Hand-tuned starting points: CPU0 blocks every 15 ms to keep IDLE0 (task
+// watchdog) fed; CPU1 only yields to equal-priority tasks.
+NMYieldCfg NM_yield_cfg[2] = {{15, 0}, {0, 0}};
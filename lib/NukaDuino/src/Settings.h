@@ -5,7 +5,8 @@
 
 #define SOFTWARE_VERSION "4.3-nukaminer"
 
-// Enable some diagnostics (optional)
+// Enable some diagnostics (optional). How much is printed is set by the log
+// level (NM_LOGx below).
 #define SERIAL_PRINTING
 // #define LED_BLINKING   // We'll manage LED ourselves in app if desired
 
@@ -16,14 +17,8 @@
 #endif
 
 // Globals used by MiningJob (declared extern here, defined in Settings.cpp)
-extern unsigned int hashrate;
-extern unsigned int hashrate_core_two;
-extern unsigned int difficulty;
-extern unsigned long share_count;
-extern unsigned long accepted_share_count;
+// Hashrate/shares/ping/node live in per-worker stats blocks (MinerStats.h).
 extern String WALLET_ID;
-extern String node_id;
-extern unsigned int ping;
 
 // Hashrate limiter (0-100). 100 = unlimited.
 // job0 = primary miner (always available)
@@ -34,6 +29,90 @@ extern uint8_t NM_hash_limit_pct_job1;
 // Backwards compatibility: older code uses NM_hash_limit_pct (maps to job0).
 extern uint8_t NM_hash_limit_pct;
 
+// System duty cap per worker (index = MiningJob core), in permille of hashing
+// duty: 1000 = no cap, 0 = parked. The miner uses the lower of this and its
+// hash_limit_pct. Written by the thermal governor in src/main.cpp, which also
+// applies the power profile's miner duty.
+extern volatile uint16_t NM_thermal_duty[2];
+
+// Cooperative yield per CPU (index = the CPU the miner task runs on). slice_ms
+// is how long a hash loop runs before blocking for one RTOS tick so
+// lower-priority work (IDLE task, loop()) can run; 0 = never block, CPU1
+// only. Tuned at runtime by the yield controller in src/main.cpp; yielded_us
+// is added to by the miners on that CPU.
+struct NMYieldCfg {
+    volatile uint16_t slice_ms;
+    volatile uint32_t yielded_us;
+};
+extern NMYieldCfg NM_yield_cfg[2];
+
+// Bit N set while miner N is talking to its node (connect, job request or
+// share submit). Background Wi-Fi work (roaming scans) waits for it to clear.
+extern volatile uint32_t NM_net_busy_mask;
+
+// Radio hook (implemented in src/main.cpp): wakes the modem while any miner
+// talks to its node and lets it sleep between shares when the power profile
+// asks for it.
+void NM_radio_busy(uint32_t mask);
+
+static inline void NM_set_net_busy(int core, bool busy) {
+    const uint32_t bit = 1u << (core & 1);
+    const uint32_t mask = busy ? (__atomic_or_fetch(&NM_net_busy_mask, bit, __ATOMIC_RELAXED))
+                               : (__atomic_and_fetch(&NM_net_busy_mask, ~bit, __ATOMIC_RELAXED));
+    NM_radio_busy(mask);
+}
+
 // NukaMiner log hook (implemented in src/main.cpp). This allows the miner
 // library to mirror Serial output into the Web UI live console.
+// NM_log logs at Info level.
 void NM_log(const String &line);
+// printf-style variant that formats into a stack buffer (no String temporaries).
+void NM_logf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void NM_logl(uint8_t level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Log levels. NM_LOG_MAX_LEVEL is the compile-time ceiling: statements above
+// it compile to nothing. NM_log_level is the runtime threshold (web UI); a
+// statement above it costs one load and a compare, its arguments are never
+// evaluated.
+#define NM_LOG_LEVEL_NONE    0
+#define NM_LOG_LEVEL_ERROR   1
+#define NM_LOG_LEVEL_WARN    2
+#define NM_LOG_LEVEL_INFO    3
+#define NM_LOG_LEVEL_DEBUG   4
+#define NM_LOG_LEVEL_VERBOSE 5
+
+#ifndef NM_LOG_MAX_LEVEL
+#if defined(SERIAL_PRINTING)
+#define NM_LOG_MAX_LEVEL NM_LOG_LEVEL_DEBUG
+#else
+#define NM_LOG_MAX_LEVEL NM_LOG_LEVEL_WARN
+#endif
+#endif
+
+extern volatile uint8_t NM_log_level;
+
+#define NM_LOG_ENABLED(lvl) ((lvl) <= NM_LOG_MAX_LEVEL && (lvl) <= NM_log_level)
+#define NM_LOGL(lvl, ...) do { if (NM_LOG_ENABLED(lvl)) NM_logl((lvl), __VA_ARGS__); } while (0)
+#define NM_LOGE(...) NM_LOGL(NM_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define NM_LOGW(...) NM_LOGL(NM_LOG_LEVEL_WARN, __VA_ARGS__)
+#define NM_LOGI(...) NM_LOGL(NM_LOG_LEVEL_INFO, __VA_ARGS__)
+#define NM_LOGD(...) NM_LOGL(NM_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define NM_LOGV(...) NM_LOGL(NM_LOG_LEVEL_VERBOSE, __VA_ARGS__)
+
+// Binary events with deferred formatting (NM_EVENT); same level rules.
+#include "LogEvents.h"
+
+// CPU time of the share path (formatting + write before the node's answer,
+// stats + logging after it), bucketed by the log level in force. Written by
+// both miners with atomic adds; read by /status.json.
+struct NMShareCost {
+    uint32_t shares;
+    uint32_t total_us;
+};
+extern NMShareCost NM_share_cost[NM_LOG_LEVEL_VERBOSE + 1];
+
+static inline void NM_share_cost_add(uint32_t us) {
+    NMShareCost &c = NM_share_cost[NM_log_level <= NM_LOG_LEVEL_VERBOSE ? NM_log_level : NM_LOG_LEVEL_VERBOSE];
+    __atomic_fetch_add(&c.shares, 1u, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&c.total_us, us, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,139 @@
+#ifndef THERMAL_GOVERNOR_H
+#define THERMAL_GOVERNOR_H
+
+// Closed-loop thermal governor for the miners (adapted for NukaMiner).
+//
+// Fed one chip temperature sample per period. The sample is smoothed with an
+// EMA, and a PI controller turns the distance to the setpoint (just under the
+// configured ceiling) into a hashing duty for the token-bucket limiter. The
+// governor only engages near the ceiling and lets go again with hysteresis,
+// so a cool dongle is never throttled. If minimum duty on both workers is
+// still too hot, one worker is parked; it comes back once the other runs
+// flat out with headroom to spare.
+//
+// Plain C++ with no Arduino dependencies so tools/thermal_sim.cpp can drive
+// it against a simulated thermal model on the host.
+
+#include <stdint.h>
+
+class ThermalGovernor {
+public:
+    static constexpr uint16_t FULL = 1000;       // duty permille
+
+    struct Params {
+        float ceiling_c = 80.0f;     // never exceed (0 = governor off)
+        float hyst_c = 3.0f;         // engage/release band below the setpoint
+        float period_s = 1.0f;       // sample period
+        float ema_alpha = 0.25f;     // smoothing per sample
+        float kp = 100.0f;           // permille per degC
+        float ki = 10.0f;            // permille per degC per second
+        uint16_t min_duty = 150;     // lowest duty before parking a worker
+        uint8_t workers = 2;         // workers the user enabled
+        uint16_t park_after_s = 15;  // at min duty and over the ceiling this long
+        uint16_t unpark_after_s = 60;// at full duty with headroom this long
+    };
+
+    struct Output {
+        uint16_t duty = FULL;        // per running worker
+        uint8_t workers = 2;         // how many may hash
+        bool active = false;         // governor engaged
+    };
+
+    void configure(const Params &p) {
+        _p = p;
+        if (_p.workers < 1) _p.workers = 1;
+        if (_out.workers > _p.workers || !_p.ceiling_c) _out.workers = _p.workers;
+        if (!_p.ceiling_c) reset();
+    }
+
+    void reset() {
+        _out = Output();
+        _out.workers = _p.workers;
+        _integ = FULL;
+        _hotS = 0;
+        _coolS = 0;
+    }
+
+    const Params &params() const { return _p; }
+    const Output &output() const { return _out; }
+    float filtered() const { return _filt; }
+    float setpoint() const { return _p.ceiling_c - 1.0f; }
+
+    // One sample. Returns the new output.
+    const Output &update(float tempC) {
+        if (!_primed) {
+            _filt = tempC;
+            _primed = true;
+        } else {
+            _filt += _p.ema_alpha * (tempC - _filt);
+        }
+        if (_p.ceiling_c <= 0.0f) return _out;
+
+        const float sp = setpoint();
+        const float e = sp - _filt;   // > 0: headroom
+
+        if (!_out.active) {
+            if (_filt < sp - _p.hyst_c) return _out;
+            _out.active = true;
+            _integ = FULL;            // bumpless: start from flat out
+        }
+
+        // Well over the ceiling: drop to minimum at once.
+        if (_filt > _p.ceiling_c + 5.0f) _integ = _p.min_duty;
+
+        float u = _p.kp * e + _integ;
+        const bool satHigh = u >= FULL;
+        const bool satLow = u <= _p.min_duty;
+        // Anti-windup: only integrate in the direction that can still act.
+        if (!(satHigh && e > 0) && !(satLow && e < 0)) _integ += _p.ki * e * _p.period_s;
+        if (_integ > FULL) _integ = FULL;
+        if (_integ < _p.min_duty) _integ = _p.min_duty;
+        u = clamp(_p.kp * e + _integ);
+        _out.duty = (uint16_t)(u + 0.5f);
+
+        // Worker count: park one when minimum duty is not enough.
+        if (_out.workers > 1 && _out.duty <= _p.min_duty && _filt > _p.ceiling_c) {
+            _hotS += _p.period_s;
+            if (_hotS >= _p.park_after_s) {
+                _out.workers--;
+                _integ = FULL / 2;   // one worker less: the rest may run harder
+                _hotS = 0;
+            }
+        } else {
+            _hotS = 0;
+        }
+        if (_out.workers < _p.workers && _out.duty >= FULL && _filt < sp - _p.hyst_c) {
+            _coolS += _p.period_s;
+            if (_coolS >= _p.unpark_after_s) {
+                _out.workers++;
+                _integ = FULL / 2;
+                _coolS = 0;
+            }
+        } else {
+            _coolS = 0;
+        }
+
+        // Release once flat out, all workers back and well below the band.
+        if (_out.duty >= FULL && _out.workers == _p.workers && _filt < sp - 2.0f * _p.hyst_c) {
+            _out.active = false;
+        }
+        return _out;
+    }
+
+private:
+    float clamp(float u) const {
+        if (u > FULL) return FULL;
+        if (u < _p.min_duty) return _p.min_duty;
+        return u;
+    }
+
+    Params _p;
+    Output _out;
+    float _filt = 0.0f;
+    float _integ = FULL;
+    float _hotS = 0.0f;
+    float _coolS = 0.0f;
+    bool _primed = false;
+};
+
+#endif
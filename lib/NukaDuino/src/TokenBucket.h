@@ -0,0 +1,82 @@
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+// Duty-cycle limiter for the hash loop (adapted for NukaMiner).
+//
+// The bucket holds CPU time, in microseconds. Wall time refills it at the
+// target duty and hashing drains it at full rate, so a worker limited to 40%
+// earns 0.4 us of hashing per microsecond that passes. The hash loop reports
+// every ~64 hashes (well under a millisecond) and blocks only once it owes at
+// least one RTOS tick, which spreads the idle time into short, frequent gaps
+// instead of long on/off bursts.
+//
+// Plain integer code with no Arduino dependencies, so tools/ can benchmark
+// it on the host.
+
+#include <stdint.h>
+
+class TokenBucket {
+public:
+    static constexpr uint16_t FULL = 1000;   // permille
+
+    // duty: target share of wall time spent hashing (permille, FULL = off).
+    // burstUs: how much unused time may be banked (e.g. after a network wait).
+    void configure(uint16_t duty, uint32_t burstUs = 2000) {
+        _duty = duty > FULL ? FULL : duty;
+        _burst = (int64_t)burstUs * FULL;
+        if (_tokens > _burst) _tokens = _burst;
+    }
+
+    uint16_t duty() const { return _duty; }
+    bool limiting() const { return _duty < FULL; }
+
+    // Start of a hashing run (new job). Forgets the previous run's debt and
+    // resets the achieved-duty window.
+    void start(uint32_t nowUs) {
+        _last = nowUs;
+        _tokens = 0;
+        _busyUs = 0;
+        _wallUs = 0;
+    }
+
+    // The time since the last mark was spent hashing (busy) or blocked
+    // (yield, limiter sleep).
+    void mark(uint32_t nowUs, bool busy) {
+        const uint32_t dt = nowUs - _last;
+        _last = nowUs;
+        _wallUs += dt;
+        if (busy) _busyUs += dt;
+        _tokens += (int64_t)dt * _duty - (busy ? (int64_t)dt * FULL : 0);
+        if (_tokens > _burst) _tokens = _burst;
+    }
+
+    // Microseconds to block now to get back on target; 0 until the debt
+    // reaches minSleepUs (one RTOS tick on the device).
+    uint32_t owedUs(uint32_t minSleepUs) const {
+        if (_tokens >= 0 || _duty >= FULL) return 0;
+        // Duty 0 means paused: the miners stop hashing rather than sleep here
+        // (MiningJob::paused()); a bounded step keeps other callers sane.
+        if (_duty == 0) return minSleepUs * 100;
+        const uint64_t us = ((uint64_t)(-_tokens) + _duty - 1) / _duty;
+        return us >= minSleepUs ? (uint32_t)(us > 0xFFFFFFFFu ? 0xFFFFFFFFu : us) : 0;
+    }
+
+    // Achieved duty since start() in permille.
+    uint16_t achieved() const {
+        if (_wallUs == 0) return FULL;
+        return (uint16_t)((_busyUs * FULL + _wallUs / 2) / _wallUs);
+    }
+
+    uint64_t busyUs() const { return _busyUs; }
+    uint64_t wallUs() const { return _wallUs; }
+
+private:
+    uint16_t _duty = FULL;
+    int64_t _burst = 2000LL * FULL;
+    int64_t _tokens = 0;      // us * FULL
+    uint32_t _last = 0;
+    uint64_t _busyUs = 0;
+    uint64_t _wallUs = 0;
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "Trace.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+volatile bool NM_trace_on = false;
+
+namespace {
+
+constexpr uint16_t NAME_SLOTS = 48;
+constexpr size_t NAME_LEN = 24;
+constexpr uint8_t THREAD_SLOTS = 12;
+
+const char *const kCatNames[NM_TC_CATS] = {"miner", "net", "web", "lcd", "sd"};
+
+char s_names[NAME_SLOTS][NAME_LEN] = {{'?'}};   // id 0: unnamed / table full
+uint16_t s_nameCount = 1;
+
+struct Thread {
+    void *handle;
+    char name[16];
+};
+Thread s_threads[THREAD_SLOTS];
+uint8_t s_threadCount = 1;                       // slot 0: everything else
+
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+NMTraceEvent *s_ring = nullptr;
+uint16_t s_cap = 0;
+uint32_t s_writers = 0;                          // tasks inside NM_trace_span()
+uint32_t s_head = 0;                             // events claimed since start
+int64_t s_t0 = 0;                                // time base, set once: spans may outlive a session
+uint32_t s_session = 0;                          // NM_trace_now() at the last start
+
+uint8_t threadSlot() {
+    void *h = xTaskGetCurrentTaskHandle();
+    const uint8_t n = __atomic_load_n(&s_threadCount, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 1; i < n; i++) {
+        if (s_threads[i].handle == h) return i;
+    }
+    uint8_t slot = 0;
+    portENTER_CRITICAL(&s_mux);
+    for (uint8_t i = 1; i < s_threadCount; i++) {
+        if (s_threads[i].handle == h) { slot = i; break; }
+    }
+    if (!slot && s_threadCount < THREAD_SLOTS) {
+        slot = s_threadCount;
+        s_threads[slot].handle = h;
+        strlcpy(s_threads[slot].name, pcTaskGetName(nullptr), sizeof(s_threads[slot].name));
+        __atomic_store_n(&s_threadCount, (uint8_t)(slot + 1), __ATOMIC_RELEASE);
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return slot;
+}
+
+// Names go into JSON strings as-is: keep them printable and quote-free.
+void copyName(char *dst, const char *src) {
+    size_t i = 0;
+    for (; src[i] && i < NAME_LEN - 1; i++) {
+        const char ch = src[i];
+        dst[i] = (ch == '"' || ch == '\\' || (uint8_t)ch < 0x20) ? '_' : ch;
+    }
+    dst[i] = 0;
+}
+
+bool nameEquals(const char *slot, const char *name) {
+    return strncmp(slot, name, NAME_LEN - 1) == 0;
+}
+
+// Stop recording and wait for writers that got past the NM_trace_on check.
+// False if one has not left after ~100 ms (a task preempted or suspended
+// mid-write): the ring must then stay where it is.
+bool quiesce() {
+    __atomic_store_n(&NM_trace_on, false, __ATOMIC_SEQ_CST);
+    for (uint8_t i = 0; i < 100; i++) {
+        if (__atomic_load_n(&s_writers, __ATOMIC_SEQ_CST) == 0) return true;
+        delay(1);
+    }
+    return false;
+}
+
+}  // namespace
+
+uint16_t NM_trace_intern(const char *name) {
+    if (!name || !*name) return 0;
+    const uint16_t n = __atomic_load_n(&s_nameCount, __ATOMIC_ACQUIRE);
+    for (uint16_t i = 1; i < n; i++) {
+        if (nameEquals(s_names[i], name)) return i;
+    }
+    uint16_t id = 0;
+    portENTER_CRITICAL(&s_mux);
+    for (uint16_t i = 1; i < s_nameCount; i++) {
+        if (nameEquals(s_names[i], name)) { id = i; break; }
+    }
+    if (!id && s_nameCount < NAME_SLOTS) {
+        id = s_nameCount;
+        copyName(s_names[id], name);
+        __atomic_store_n(&s_nameCount, (uint16_t)(id + 1), __ATOMIC_RELEASE);
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return id;
+}
+
+uint32_t NM_trace_now() {
+    return (uint32_t)(esp_timer_get_time() - s_t0);
+}
+
+void NM_trace_span(NMTraceCat cat, uint16_t name, uint32_t start_us) {
+    if (!NM_trace_on) return;
+    // Announce the write before looking at the ring: quiesce() clears
+    // NM_trace_on first and then waits for the count to drop.
+    __atomic_fetch_add(&s_writers, 1, __ATOMIC_SEQ_CST);
+    NMTraceEvent *ring = s_ring;
+    const uint16_t cap = s_cap;
+    // A span begun before this session (e.g. a hash run across a restart)
+    // belongs to no dump: drop it.
+    if (__atomic_load_n(&NM_trace_on, __ATOMIC_SEQ_CST) && ring && cap &&
+        (int32_t)(start_us - s_session) >= 0) {
+        const uint32_t now = NM_trace_now();
+        const uint32_t idx = __atomic_fetch_add(&s_head, 1, __ATOMIC_RELAXED);
+        NMTraceEvent &e = ring[idx % cap];
+        e.ts_us = start_us;
+        e.dur_us = now - start_us;
+        e.name = name;
+        e.tid = threadSlot();
+        e.cat = cat;
+    }
+    __atomic_fetch_sub(&s_writers, 1, __ATOMIC_RELEASE);
+}
+
+bool NM_trace_start(uint16_t events) {
+    if (events < 64) events = 64;
+    if (events > NM_TRACE_MAX_EVENTS) events = NM_TRACE_MAX_EVENTS;
+    // Also when the size is unchanged: s_head must not move under a writer.
+    if (!quiesce()) return false;
+    if (s_cap != events) {
+        NMTraceEvent *old = s_ring;
+        s_ring = nullptr;
+        s_cap = 0;
+        free(old);
+        NMTraceEvent *ring = (NMTraceEvent *)calloc(events, sizeof(NMTraceEvent));
+        if (!ring) return false;
+        s_ring = ring;
+        s_cap = events;
+    }
+    s_head = 0;
+    if (s_t0 == 0) s_t0 = esp_timer_get_time();
+    s_session = NM_trace_now();
+    NM_trace_on = true;
+    return true;
+}
+
+void NM_trace_stop() {
+    NM_trace_on = false;
+}
+
+bool NM_trace_free() {
+    if (!quiesce()) return false;
+    NMTraceEvent *old = s_ring;
+    s_ring = nullptr;
+    s_cap = 0;
+    s_head = 0;
+    free(old);
+    return true;
+}
+
+void NM_trace_info(NMTraceInfo &out) {
+    out.on = NM_trace_on;
+    out.capacity = s_cap;
+    out.recorded = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+    out.span_us = s_ring ? NM_trace_now() - s_session : 0;
+}
+
+size_t NM_trace_dump(NMTraceCursor &c, char *buf, size_t cap) {
+    size_t o = 0;
+    auto put = [&](int n) -> bool {
+        if (n < 0 || o + (size_t)n >= cap) return false;
+        o += (size_t)n;
+        return true;
+    };
+    if (c.stage == 0) {
+        if (!put(snprintf(buf + o, cap - o,
+                          "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["
+                          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                          "\"args\":{\"name\":\"NukaMiner\"}}")))
+            return 0;
+        c.stage = 1;
+        c.pos = 0;
+    }
+    // Thread names; slot numbers double as Chrome tids.
+    if (c.stage == 1) {
+        for (; c.pos < s_threadCount; c.pos++) {
+            const size_t mark = o;
+            if (!put(snprintf(buf + o, cap - o,
+                              ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                              "\"args\":{\"name\":\"%s\"}}",
+                              (unsigned)c.pos, c.pos ? s_threads[c.pos].name : "other"))) {
+                o = mark;
+                return o;
+            }
+        }
+        const uint32_t head = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+        c.end = head;
+        c.pos = (s_cap && head > s_cap) ? head - s_cap : 0;
+        c.stage = 2;
+    }
+    if (c.stage == 2) {
+        for (; c.pos != c.end && s_ring && s_cap; c.pos++) {
+            const NMTraceEvent &e = s_ring[c.pos % s_cap];
+            const uint8_t cat = e.cat < NM_TC_CATS ? e.cat : 0;
+            const uint16_t name = e.name < s_nameCount ? e.name : 0;
+            const size_t mark = o;
+            if (!put(snprintf(buf + o, cap - o,
+                              ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,"
+                              "\"pid\":1,\"tid\":%u}",
+                              s_names[name], kCatNames[cat], (unsigned long)(e.ts_us - s_session),
+                              (unsigned long)e.dur_us, (unsigned)e.tid))) {
+                o = mark;
+                return o;
+            }
+        }
+        c.stage = 3;
+    }
+    if (c.stage == 3) {
+        if (!put(snprintf(buf + o, cap - o, "]}"))) return o;
+        c.stage = 4;
+    }
+    return o;
+}
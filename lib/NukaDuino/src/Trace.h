@@ -0,0 +1,126 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Span tracer with a Chrome trace (about://tracing, Perfetto) dump.
+//
+// A span is recorded once, when it ends, as one complete event: start and
+// duration in microseconds, an interned name, a category and the thread slot
+// of the calling task. Events go into a ring that NM_trace_start() allocates
+// and NM_trace_stop() keeps for download; writers claim a slot with one atomic
+// add and never block. Writers are counted, and the ring is only resized or
+// freed once none is inside NM_trace_span(). Thread slots are assigned on a task's first event and
+// carry the FreeRTOS task name.
+//
+// With NM_TRACE undefined the NM_TRACE_* macros compile to nothing. With it
+// defined and tracing stopped, a span costs one load and a branch.
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum NMTraceCat : uint8_t {
+    NM_TC_MINER = 0,   // hash loop
+    NM_TC_NET,         // node connect, job request, share submit
+    NM_TC_WEB,         // one web request (route as the name)
+    NM_TC_LCD,         // page draw, fbPush
+    NM_TC_SD,          // SD mount and file I/O
+    NM_TC_CATS
+};
+
+struct NMTraceEvent {
+    uint32_t ts_us;    // start, NM_trace_now() time base
+    uint32_t dur_us;
+    uint16_t name;     // NM_trace_intern() id
+    uint8_t tid;       // thread slot
+    uint8_t cat;       // NMTraceCat
+};
+
+static constexpr uint32_t NM_TRACE_NONE = 0xFFFFFFFFu;
+static constexpr uint16_t NM_TRACE_DEFAULT_EVENTS = 1024;
+static constexpr uint16_t NM_TRACE_MAX_EVENTS = 4096;
+
+extern volatile bool NM_trace_on;
+
+// Id for a span name (copied, at most 23 chars). Same name, same id; 0 once
+// the table is full.
+uint16_t NM_trace_intern(const char *name);
+
+// Microseconds on the trace time base. It is set by the first
+// NM_trace_start() and kept across sessions, so a span begun before a restart
+// still measures correctly (and is dropped, not misdated).
+uint32_t NM_trace_now();
+
+// Complete event from start_us to now for the calling task.
+void NM_trace_span(NMTraceCat cat, uint16_t name, uint32_t start_us);
+
+// (Re)allocate the ring for `events` spans and start recording from empty.
+// Fails while a writer is stuck mid-span. Dumped timestamps count from here.
+bool NM_trace_start(uint16_t events = NM_TRACE_DEFAULT_EVENTS);
+// Stop recording; the ring stays for download until the next start/free.
+void NM_trace_stop();
+// Stop and release the ring; false (ring kept) while a writer is stuck.
+bool NM_trace_free();
+
+struct NMTraceInfo {
+    bool on;
+    uint16_t capacity;
+    uint32_t recorded;   // since start, including overwritten ones
+    uint32_t span_us;    // now - start of this session
+};
+void NM_trace_info(NMTraceInfo &out);
+
+// Chrome trace JSON of the ring, oldest event first, in pieces: call with a
+// zeroed cursor until it returns 0 (buf of at least 256 bytes). Pause
+// recording around the dump (NM_trace_on = false) so the ring holds still.
+struct NMTraceCursor {
+    uint8_t stage;
+    uint32_t pos;
+    uint32_t end;
+};
+size_t NM_trace_dump(NMTraceCursor &c, char *buf, size_t cap);
+
+class NMTraceScope {
+public:
+    NMTraceScope(NMTraceCat cat, uint16_t &id, const char *name) {
+        if (!NM_trace_on) return;
+        if (!id) id = NM_trace_intern(name);
+        _id = id;
+        _cat = cat;
+        _t0 = NM_trace_now();
+    }
+    ~NMTraceScope() {
+        if (_t0 != NM_TRACE_NONE) NM_trace_span(_cat, _id, _t0);
+    }
+
+private:
+    uint32_t _t0 = NM_TRACE_NONE;
+    uint16_t _id = 0;
+    NMTraceCat _cat = NM_TC_MINER;
+};
+
+#define NM_TRACE_CAT2(a, b) a##b
+#define NM_TRACE_CAT(a, b) NM_TRACE_CAT2(a, b)
+
+#ifdef NM_TRACE
+// Span for the rest of the enclosing block.
+#define NM_TRACE_SCOPE(cat, name)                                   \
+    static uint16_t NM_TRACE_CAT(_nmTrId, __LINE__) = 0;            \
+    NMTraceScope NM_TRACE_CAT(_nmTr, __LINE__)(cat, NM_TRACE_CAT(_nmTrId, __LINE__), name)
+// Span between two points of one function; END may be reached more than
+// once (only the first records) or not at all.
+#define NM_TRACE_BEGIN(var) uint32_t var = NM_trace_on ? NM_trace_now() : NM_TRACE_NONE
+#define NM_TRACE_END(var, cat, name)                                \
+    do {                                                            \
+        if (var != NM_TRACE_NONE) {                                 \
+            static uint16_t _nmTrId = 0;                            \
+            if (!_nmTrId) _nmTrId = NM_trace_intern(name);          \
+            NM_trace_span(cat, _nmTrId, var);                       \
+            var = NM_TRACE_NONE;                                    \
+        }                                                           \
+    } while (0)
+#else
+#define NM_TRACE_SCOPE(cat, name) do {} while (0)
+#define NM_TRACE_BEGIN(var) do {} while (0)
+#define NM_TRACE_END(var, cat, name) do {} while (0)
+#endif
+
+#endif
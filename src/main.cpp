@@ -1,5 +1,10 @@
 #include <Arduino.h>
 #include <esp_system.h>
+#include <esp_freertos_hooks.h>
+#include <freertos/event_groups.h>
+#include <freertos/timers.h>
+#include <esp_wifi.h>
+#include <lwip/sockets.h>
 #include <WiFi.h>
 #include <Preferences.h>
 #include <WebServer.h>
@@ -27,6 +32,12 @@ static String regenerateDucoGroupId();
 #include "web_assets.h"  // Frozen web UI JS assets (DO NOT inline-edit in main.cpp)
 #include <MiningJob.h>
 #include <Settings.h>
+#include <LogRing.h>
+#include <ThermalGovernor.h>
+#include <AllocStats.h>
+#include <CrashLog.h>
+#include <Trace.h>
+#include <Profiler.h>
 
 // -----------------------------
 // NukaMiner (T-Dongle-S3)
@@ -136,6 +147,15 @@ struct AppConfig {
   bool core2_enabled = true;
   uint8_t core2_hash_limit_pct = 100; // Shown as 100%
 
+  // Thermal governor: hold the chip under thermal_max_c (0 = off) by lowering
+  // the miners' duty, releasing thermal_hyst_c below the setpoint.
+  uint8_t thermal_max_c = 80;
+  uint8_t thermal_hyst_c = 3;
+
+  // Power profile (index into kPowerProfiles): 0 = Max throughput,
+  // 1 = Balanced, 2 = Efficiency.
+  uint8_t power_profile = 0;
+
   uint8_t primary_core = 2;
 
   // Built-in RGB LED
@@ -159,6 +179,28 @@ struct AppConfig {
   // Pool lookup cache (seconds). 0 = disable caching.
   uint32_t pool_cache_s = 900;
 
+  // Background roaming to a stronger AP / higher-priority saved profile.
+  bool wifi_roam = true;
+
+  // Responsiveness target for the adaptive yield controller (ms). 0 = use the
+  // fixed hand-tuned yield intervals.
+  uint16_t yield_target_ms = 50;
+
+  // Task placement: CPU core and FreeRTOS priority per task. Applied without
+  // a reboot; a core change respawns the task. loop() (LCD rendering) stays
+  // on the core Arduino started it on, only its priority is adjustable.
+  uint8_t task_m0_core = 0;       // "duco0", the Core 1 miner
+  uint8_t task_m1_core = 1;       // "duco1", the Core 2 miner
+  uint8_t task_miner_prio = 1;
+  uint8_t task_pool_core = 0;
+  uint8_t task_pool_prio = 1;
+  uint8_t task_svc_core = 0;
+  uint8_t task_svc_prio = 3;
+  uint8_t task_loop_prio = 1;
+
+  // Console/Serial log level (NM_LOG_LEVEL_*); applied on save.
+  uint8_t log_level = NM_LOG_LEVEL_INFO;
+
   // Scheduled reboot
   // reboot_mode: 0=Off, 1=Daily, 2=Weekly, 3=Monthly
   uint8_t reboot_mode = 0;
@@ -181,6 +223,9 @@ struct WifiProfile {
 
 static std::vector<WifiProfile> wifiProfiles;
 static String wifiLastSsid; // last successfully connected SSID (hint)
+// AP we last associated with on wifiLastSsid; lets reconnects skip the scan.
+static uint8_t wifiLastBssid[6] = {0};
+static int32_t wifiLastChannel = 0; // 0 = unknown
 
 static void wifiProfilesLoad();
 static void wifiProfilesSave();
@@ -194,10 +239,222 @@ static WifiProfile* wifiBestProfileForVisibleNetworks(const std::vector<String>&
 static Preferences prefs;
 static AppConfig cfg;
 
+// Keep user task priorities above IDLE (0) and well below the Wi-Fi/lwIP and
+// esp_timer tasks (18+), which must always preempt us.
+static constexpr uint8_t TASK_PRIO_MIN = 1;
+static constexpr uint8_t TASK_PRIO_MAX = 10;
+
+// Published copy of cfg for code outside the service task (loop()/LCD on
+// CPU1, the pool task). Web handlers edit cfg in place; every edit ends in
+// saveConfig(), which republishes, so a reader on the other core pins a
+// consistent snapshot instead of touching Strings that are being reassigned.
+static SnapshotCell<AppConfig> g_cfgSnap;
+
+static void cfgPublish() {
+  NM_log_level = (cfg.log_level <= NM_LOG_LEVEL_VERBOSE) ? cfg.log_level : NM_LOG_LEVEL_VERBOSE;
+  g_cfgSnap.publish(cfg);
+}
+
+// Changes to cfg from other tasks go through the service task, which owns it:
+// they post a request here and the service task applies and republishes.
+enum CfgRequestKind : uint8_t { CFG_REQ_WIFI_MIRROR = 1 };
+struct CfgRequest {
+  CfgRequestKind kind;
+  char ssid[33];
+  char pass[65];
+};
+static QueueHandle_t g_cfgReq = nullptr;   // created in setup()
+
+// Any task: mirror the WiFi profile in use into cfg.wifi_ssid/pass (UI, backups).
+static void cfgRequestWifiMirror(const String &ssid, const String &pass) {
+  if (!g_cfgReq) return;
+  CfgRequest r = {};
+  r.kind = CFG_REQ_WIFI_MIRROR;
+  strlcpy(r.ssid, ssid.c_str(), sizeof(r.ssid));
+  strlcpy(r.pass, pass.c_str(), sizeof(r.pass));
+  xQueueSend(g_cfgReq, &r, 0);
+}
+
+// Service task: apply queued requests.
+static void cfgServiceRequests() {
+  if (!g_cfgReq) return;
+  CfgRequest r;
+  bool changed = false;
+  while (xQueueReceive(g_cfgReq, &r, 0) == pdTRUE) {
+    if (r.kind == CFG_REQ_WIFI_MIRROR && (cfg.wifi_ssid != r.ssid || cfg.wifi_pass != r.pass)) {
+      cfg.wifi_ssid = r.ssid;
+      cfg.wifi_pass = r.pass;
+      changed = true;
+    }
+  }
+  if (changed) cfgPublish();
+}
+
+struct CfgView {
+  SnapshotCell<AppConfig>::Ref ref;
+  // Before the first publish (early setup) fall back to cfg itself.
+  const AppConfig *operator->() const { return ref ? ref.get() : &cfg; }
+};
+static CfgView cfgView() { return CfgView{g_cfgSnap.pin()}; }
+
+// Power profiles: CPU clock, Wi-Fi modem sleep between shares, LCD/LED policy
+// and a miner duty cap, applied on top of the user's own settings (a profile
+// only ever lowers them). Energy accounting lives in the "Power profiles"
+// section further down.
+struct PowerProfile {
+  const char *key;
+  const char *label;
+  uint16_t cpu_mhz;
+  bool modem_sleep;        // radio sleeps whenever no miner is talking to its node
+  uint8_t lcd_max_pct;     // backlight cap
+  uint16_t lcd_sleep_s;    // display sleep cap (0 = user setting)
+  bool led;                // RGB LED allowed
+  uint16_t duty;           // miner duty cap, permille
+};
+static const PowerProfile kPowerProfiles[] = {
+  {"max",        "Max throughput", 240, false, 100, 0,  true,  1000},
+  {"balanced",   "Balanced",       160, true,  40,  60, true,  1000},
+  {"efficiency", "Efficiency",     80,  true,  10,  15, false, 800},
+};
+static constexpr uint8_t POWER_PROFILE_COUNT = sizeof(kPowerProfiles) / sizeof(kPowerProfiles[0]);
+static const PowerProfile &powerProfile(uint8_t idx) {
+  return kPowerProfiles[idx < POWER_PROFILE_COUNT ? idx : 0];
+}
+
+static void taskPlacementSanitize() {
+  auto core = [](uint8_t &c) { if (c > 1) c = 1; };
+  auto prio = [](uint8_t &p) { p = (uint8_t)constrain((int)p, (int)TASK_PRIO_MIN, (int)TASK_PRIO_MAX); };
+  core(cfg.task_m0_core);
+  core(cfg.task_m1_core);
+  core(cfg.task_pool_core);
+  core(cfg.task_svc_core);
+  prio(cfg.task_miner_prio);
+  prio(cfg.task_pool_prio);
+  prio(cfg.task_svc_prio);
+  prio(cfg.task_loop_prio);
+}
+
 // True while the SD file manager is actively uploading/downloading/deleting.
 // Used to temporarily pause mining and keep the web server responsive.
+// Write it through setSdBusy() so the NM_GATE_SD_IDLE bit stays in sync.
 static volatile bool sdBusy = false;
 
+// -----------------------------
+// Run gates (event group)
+// -----------------------------
+// Conditions the miner and pool tasks wait on, one bit each, set/cleared only
+// by the code that owns the condition. Tasks block in xEventGroupWaitBits()
+// until every bit they need is set, so they resume the moment e.g. an SD
+// transfer or a WiFi reconnect finishes instead of on their next poll.
+static constexpr EventBits_t NM_GATE_WIFI_UP   = (1u << 0); // STA has an IP (WiFi events)
+static constexpr EventBits_t NM_GATE_SD_IDLE   = (1u << 1); // no SD transfer (setSdBusy)
+static constexpr EventBits_t NM_GATE_NO_PORTAL = (1u << 2); // AP/portal not running (portalStart/Stop)
+static constexpr EventBits_t NM_GATE_MINER_RUN = (1u << 3); // miners wanted (minerStart/Stop)
+static constexpr uint8_t NM_GATE_BITS = 4;
+static constexpr EventBits_t NM_GATES_MINER = NM_GATE_WIFI_UP | NM_GATE_SD_IDLE | NM_GATE_NO_PORTAL | NM_GATE_MINER_RUN;
+static constexpr EventBits_t NM_GATES_POOL  = NM_GATE_WIFI_UP | NM_GATE_SD_IDLE | NM_GATE_MINER_RUN;
+
+static EventGroupHandle_t g_gates = nullptr;
+static volatile uint32_t g_gateSetMs[NM_GATE_BITS] = {0};
+
+// Time-to-resume per waiting task: from the last missing bit being set to the
+// task running again.
+struct NMGateStats {
+  uint32_t blockedSinceMs;
+  uint32_t pauses;
+  uint32_t pausedLastMs;
+  uint32_t resumeLastMs;
+  uint32_t resumeMaxMs;
+};
+static NMGateStats g_gateStats[3] = {}; // miner0, miner1, pool
+
+static void nmGateSet(EventBits_t bits, bool on) {
+  if (!g_gates) return;
+  if (on) {
+    const EventBits_t before = xEventGroupGetBits(g_gates);
+    const uint32_t now = millis();
+    for (uint8_t i = 0; i < NM_GATE_BITS; i++) {
+      if ((bits & (1u << i)) && !(before & (1u << i))) g_gateSetMs[i] = now;
+    }
+    xEventGroupSetBits(g_gates, bits);
+  } else {
+    xEventGroupClearBits(g_gates, bits);
+  }
+}
+
+static void setSdBusy(bool busy) {
+  sdBusy = busy;
+  nmGateSet(NM_GATE_SD_IDLE, !busy);
+}
+
+// Safety net, called from loop() about once a second: re-derive the bits from
+// their source state in case an owner's update (e.g. a WiFi event) was missed.
+static void nmGateSync() {
+  static uint32_t lastMs = 0;
+  const uint32_t now = millis();
+  if ((uint32_t)(now - lastMs) < 1000 || !g_gates) return;
+  lastMs = now;
+  const EventBits_t want = (WiFi.isConnected() ? NM_GATE_WIFI_UP : 0) |
+                           (!sdBusy ? NM_GATE_SD_IDLE : 0) |
+                           (!portalRunning ? NM_GATE_NO_PORTAL : 0);
+  const EventBits_t mask = NM_GATE_WIFI_UP | NM_GATE_SD_IDLE | NM_GATE_NO_PORTAL;
+  const EventBits_t have = xEventGroupGetBits(g_gates) & mask;
+  if (have == want) return;
+  nmGateSet(want & ~have, true);
+  nmGateSet(have & ~want, false);
+}
+
+// Block until all `need` bits are set or `timeout` expires. Returns true when
+// the gate is open.
+static bool nmGateWait(EventBits_t need, TickType_t timeout, NMGateStats &gs) {
+  if (!g_gates) { vTaskDelay(timeout); return false; }
+  if ((xEventGroupGetBits(g_gates) & need) == need) return true;
+  if (!gs.blockedSinceMs) gs.blockedSinceMs = millis() | 1;
+  const EventBits_t have = xEventGroupWaitBits(g_gates, need, pdFALSE, pdTRUE, timeout);
+  if ((have & need) != need) return false;
+
+  const uint32_t now = millis();
+  uint32_t openedAt = gs.blockedSinceMs;
+  for (uint8_t i = 0; i < NM_GATE_BITS; i++) {
+    if ((need & (1u << i)) && (int32_t)(g_gateSetMs[i] - openedAt) > 0) openedAt = g_gateSetMs[i];
+  }
+  gs.pauses++;
+  gs.pausedLastMs = now - gs.blockedSinceMs;
+  gs.resumeLastMs = now - openedAt;
+  if (gs.resumeLastMs > gs.resumeMaxMs) gs.resumeMaxMs = gs.resumeLastMs;
+  gs.blockedSinceMs = 0;
+  return true;
+}
+
+// -----------------------------
+// Boot timeline
+// -----------------------------
+// Uptime (ms) at which each boot stage was first reached, 0 = not yet. Any
+// task may mark a stage. After setup() the stages are event driven: WiFi
+// association, the pool lookup and the first share run alongside each other
+// and the LCD. `after` is the stage each one waits for, so /boot.json can show
+// what every step cost on its own.
+enum BootStage : uint8_t {
+  BOOT_SETUP = 0, BOOT_DISPLAY, BOOT_CONFIG, BOOT_MINERS, BOOT_WIFI_BEGIN, BOOT_SETUP_DONE,
+  BOOT_WIFI_UP, BOOT_WEB, BOOT_NTP, BOOT_POOL, BOOT_NODE, BOOT_FIRST_HASH, BOOT_FIRST_SHARE,
+  BOOT_FIRST_ACCEPT, BOOT_STAGES
+};
+struct BootStageDef { const char *key; BootStage after; };
+static const BootStageDef kBootStages[BOOT_STAGES] = {
+  {"setup", BOOT_SETUP},          {"display", BOOT_SETUP},        {"config", BOOT_SETUP},
+  {"miners", BOOT_CONFIG},        {"wifi_begin", BOOT_CONFIG},    {"setup_done", BOOT_SETUP},
+  {"wifi_up", BOOT_WIFI_BEGIN},   {"web", BOOT_WIFI_UP},          {"ntp", BOOT_WIFI_UP},
+  {"pool", BOOT_WIFI_UP},         {"node", BOOT_POOL},            {"first_hash", BOOT_NODE},
+  {"first_share", BOOT_FIRST_HASH}, {"first_accept", BOOT_FIRST_HASH},
+};
+static volatile uint32_t g_bootMs[BOOT_STAGES] = {0};
+
+static inline void bootMark(BootStage s) {
+  if (g_bootMs[s]) return;
+  const uint32_t now = millis();
+  g_bootMs[s] = now ? now : 1;
+}
+
 // Restore upload (no-SD) state
 static String g_restoreUploadMsg;
 static String g_restoreUploadErr;
@@ -208,6 +465,24 @@ static uint8_t wifiReconnectFails = 0;
 static uint32_t lastWifiCheckMs = 0;
 static uint32_t lastWifiAttemptMs = 0;
 
+// Outage accounting (STA_DISCONNECTED -> GOT_IP), fed from WiFi events.
+// Histogram upper bounds in ms; the last bucket is open-ended.
+static const uint32_t WIFI_OUTAGE_BOUNDS_MS[] = {500, 1000, 2000, 5000, 10000, 30000};
+static constexpr uint8_t WIFI_OUTAGE_BUCKETS = sizeof(WIFI_OUTAGE_BOUNDS_MS) / sizeof(WIFI_OUTAGE_BOUNDS_MS[0]) + 1;
+static volatile uint32_t wifiOutageHist[WIFI_OUTAGE_BUCKETS] = {0};
+static volatile bool wifiEverUp = false;        // outages only count after the first GOT_IP
+static volatile uint32_t wifiDownAtMs = 0;      // 0 = link up
+static volatile uint32_t wifiOutageCount = 0;
+static volatile uint32_t wifiOutageLastMs = 0;
+static volatile uint32_t wifiOutageMaxMs = 0;
+static const char *wifiRecoverVia = "";         // how the last outage ended
+
+// Background roaming stats (see wifiRoamService()).
+static volatile bool wifiRoaming = false;       // a roam is in progress
+static uint32_t wifiRoamCount = 0;
+static uint32_t wifiRoamSweeps = 0;
+static int wifiRoamLastGainDb = 0;
+
 // Web UI session gating (used when web_always_on == false)
 static volatile bool webSessionActive = false;
 static volatile uint32_t webSessionDeadlineMs = 0;
@@ -241,8 +516,18 @@ static inline bool webSessionAllowed(uint32_t nowMs) {
 // running at high duty cycle. WebServer is synchronous; it must be pumped
 // frequently. Pin to CPU0 so CPU1 can focus on mining + display.
 static TaskHandle_t serviceTask = nullptr;
+// Loop heartbeats of the service and pool tasks (health supervisor).
+static volatile uint32_t g_svcBeatMs = 0;
+static volatile uint32_t g_poolBeatMs = 0;
 static void serviceTaskFn(void *arg);
 
+// Task stack sizes in bytes (ESP-IDF sizes stacks in bytes, not words).
+// /tasks.json reports how much of each one has ever been used.
+static constexpr uint32_t SVC_TASK_STACK = 4096;
+static constexpr uint32_t MINER_TASK_STACK = 8192;
+// fetchPoolCached() can involve TLS + JSON parsing and is stack-hungry.
+static constexpr uint32_t POOL_TASK_STACK = 12288;
+
 // -----------------------------
 // Duino miner task handles (needed for suspend/resume during AP/Portal)
 // -----------------------------
@@ -256,23 +541,176 @@ static void minerResumeAfterPortal();
 // -----------------------------
 // Log ring buffer (for Web UI live console)
 // -----------------------------
-static constexpr size_t LOG_LINES_MAX = 220;
-static String logLines[LOG_LINES_MAX];
-static size_t logHead = 0;
-static size_t logCount = 0;
-static uint32_t logSeq = 0;
+// Lock-free byte arena shared by every task that logs (see LogRing.h). NM_log
+// never touches Serial: a low-priority drain task prints committed lines, so
+// a slow or disconnected USB console cannot stall a miner or the pool task.
+static constexpr uint32_t LOG_ARENA_BYTES = 16384;
+static LogRing<LOG_ARENA_BYTES> g_logRing;
+using LogRingT = LogRing<LOG_ARENA_BYTES>;
+static TaskHandle_t g_logDrainTask = nullptr;
+static volatile uint32_t g_logDrainLost = 0;   // records overwritten before they reached Serial
+static constexpr uint8_t LOG_FLAG_EVENT = 0x02;  // payload is an NMEventHdr + args, not text
+
+// A record still READ_PENDING after this long belongs to a producer that was
+// preempted or suspended mid-write (the portal suspends miners): skip it.
+static constexpr uint32_t LOG_PENDING_SKIP_MS = 250;
+
+// One per reader: how long the record at `pos` has been pending.
+struct LogPendingWait {
+  uint32_t pos = 0;
+  uint32_t sinceMs = 0;
+
+  bool expired(uint32_t at) {
+    const uint32_t now = millis();
+    if (sinceMs == 0 || at != pos) {
+      pos = at;
+      sinceMs = now | 1;
+      return false;
+    }
+    return (uint32_t)(now - sinceMs) >= LOG_PENDING_SKIP_MS;
+  }
+};
+
+// Renders an event record with its format from LogEvents.h. Arguments are
+// passed one conversion at a time so each gets the C type its spec expects.
+static size_t logEventFormat(const uint8_t *rec, size_t len, char *out, size_t cap) {
+  NMEventHdr h;
+  if (cap == 0) return 0;
+  if (len < sizeof(h)) { out[0] = 0; return 0; }
+  memcpy(&h, rec, sizeof(h));
+  const size_t argc = std::min<size_t>((len - sizeof(h)) / 4, NM_EVENT_MAX_ARGS);
+  uint32_t args[NM_EVENT_MAX_ARGS] = {};
+  memcpy(args, rec + sizeof(h), argc * 4);
+  if (h.id >= NM_EV_COUNT) {
+    const int n = snprintf(out, cap, "[event %u]", (unsigned)h.id);
+    return (n < 0) ? 0 : std::min<size_t>((size_t)n, cap - 1);
+  }
+
+  const char *f = NM_event_defs[h.id].fmt;
+  size_t o = 0;
+  size_t ai = 0;
+  while (*f && o + 1 < cap) {
+    if (*f != '%') { out[o++] = *f++; continue; }
+    if (f[1] == '%') { out[o++] = '%'; f += 2; continue; }
+    char spec[16];
+    size_t sl = 0;
+    spec[sl++] = *f++;
+    while (*f && !strchr("diouxXfFeEgG", *f) && sl < sizeof(spec) - 2) spec[sl++] = *f++;
+    if (!*f) break;
+    const char conv = *f++;
+    spec[sl++] = conv;
+    spec[sl] = 0;
+    const uint8_t type = (h.types >> (2 * ai)) & 3;
+    const uint32_t raw = (ai < argc) ? args[ai] : 0;
+    ai++;
+    int n;
+    if (strchr("fFeEgG", conv)) {
+      float fv;
+      memcpy(&fv, &raw, sizeof(fv));
+      const double v = (type == NM_EVARG_F32) ? (double)fv : (type == NM_EVARG_I32) ? (double)(int32_t)raw : (double)raw;
+      n = snprintf(out + o, cap - o, spec, v);
+    } else if (strchr(spec, 'l')) {
+      n = (type == NM_EVARG_I32) ? snprintf(out + o, cap - o, spec, (long)(int32_t)raw)
+                                 : snprintf(out + o, cap - o, spec, (unsigned long)raw);
+    } else {
+      n = snprintf(out + o, cap - o, spec, (unsigned)raw);
+    }
+    if (n < 0) break;
+    o += std::min<size_t>((size_t)n, cap - o - 1);
+  }
+  out[o] = 0;
+  return o;
+}
+
+// Turns the record just read into text in place (events are formatted here,
+// on the reader's time, never by the task that logged them).
+static uint16_t logRecordText(char *buf, uint16_t len, uint8_t flags) {
+  if (!(flags & LOG_FLAG_EVENT)) return len;
+  uint8_t rec[LogRingT::MAX_TEXT];
+  memcpy(rec, buf, len);
+  return (uint16_t)logEventFormat(rec, len, buf, LogRingT::MAX_TEXT);
+}
+
+static void logDrainTaskFn(void *) {
+  NM_alloc_register(NM_ALLOC_LOG);
+  static char line[LogRingT::MAX_TEXT + 1];
+  uint32_t cursor = 0;   // resyncs to the oldest line if the arena already wrapped
+  LogPendingWait pending;
+  for (;;) {
+    bool wrote = false;
+    for (int i = 0; i < 32; i++) {
+      uint16_t len = 0;
+      uint8_t level = 0;
+      uint8_t flags = 0;
+      const LogRingT::ReadResult r = g_logRing.read(cursor, line, len, level, &flags);
+      if (r == LogRingT::READ_OK) {
+        len = logRecordText(line, len, flags);
+        line[len] = '\n';
+        Serial.write((const uint8_t *)line, len + 1);
+        wrote = true;
+        continue;
+      }
+      if (r == LogRingT::READ_LOST) {
+        g_logDrainLost++;
+        cursor = g_logRing.resync(cursor);
+        continue;
+      }
+      if (r == LogRingT::READ_PENDING && pending.expired(cursor)) {
+        g_logDrainLost++;
+        cursor = g_logRing.skip(cursor);
+        continue;
+      }
+      break;   // empty, or a producer is mid-commit
+    }
+    // Pending commits are usually microseconds away; the timeout also
+    // brings a stuck one up for skipping.
+    if (!wrote) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+  }
+}
+
+static void logDrainStart() {
+  if (g_logDrainTask) return;
+  xTaskCreatePinnedToCore(logDrainTaskFn, "logDrain", 3072, nullptr, 1, &g_logDrainTask, 0);
+}
 
-static void pushLogLine(const String &line) {
-  logLines[logHead] = line;
-  logHead = (logHead + 1) % LOG_LINES_MAX;
-  if (logCount < LOG_LINES_MAX) logCount++;
-  logSeq++;
+static void logPush(uint8_t level, const char *text, size_t len) {
+  g_logRing.write(text, len, level);
+  if (g_logDrainTask) xTaskNotifyGive(g_logDrainTask);
+}
+
+static void logPushV(uint8_t level, const char *fmt, va_list ap) {
+  char buf[LogRingT::MAX_TEXT + 1];
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  if (n < 0) return;
+  if ((size_t)n >= sizeof(buf)) n = sizeof(buf) - 1;
+  logPush(level, buf, (size_t)n);
 }
 
 // Declared in lib/NukaDuino/src/Settings.h
 void NM_log(const String &line) {
-  Serial.println(line);
-  pushLogLine(line);
+  if (!NM_LOG_ENABLED(NM_LOG_LEVEL_INFO)) return;
+  logPush(NM_LOG_LEVEL_INFO, line.c_str(), line.length());
+}
+
+void NM_logf(const char *fmt, ...) {
+  if (!NM_LOG_ENABLED(NM_LOG_LEVEL_INFO)) return;
+  va_list ap;
+  va_start(ap, fmt);
+  logPushV(NM_LOG_LEVEL_INFO, fmt, ap);
+  va_end(ap);
+}
+
+void NM_logl(uint8_t level, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  logPushV(level, fmt, ap);
+  va_end(ap);
+}
+
+// Declared in lib/NukaDuino/src/LogEvents.h
+void NM_event_write(uint8_t level, const void *rec, size_t len) {
+  g_logRing.write((const char *)rec, len, level, LOG_FLAG_EVENT);
+  if (g_logDrainTask) xTaskNotifyGive(g_logDrainTask);
 }
 
 // Stored under NVS namespace "nukaminer"
@@ -303,6 +741,18 @@ static void loadConfig() {
   cfg.ntp_server = getStr("ntp_server", "pool.ntp.org");
   cfg.tz_name = getStr("tz", "UTC");
   cfg.pool_cache_s = getUInt("pool_cache_s", 900);
+  cfg.wifi_roam = getBool("wifi_roam", true);
+  cfg.yield_target_ms = (uint16_t)std::min<uint32_t>(getUInt("yield_tgt", 50), 1000);
+  cfg.task_m0_core = (uint8_t)getUInt("t_m0_core", 0);
+  cfg.task_m1_core = (uint8_t)getUInt("t_m1_core", 1);
+  cfg.task_miner_prio = (uint8_t)getUInt("t_m_prio", 1);
+  cfg.task_pool_core = (uint8_t)getUInt("t_pool_core", 0);
+  cfg.task_pool_prio = (uint8_t)getUInt("t_pool_prio", 1);
+  cfg.task_svc_core = (uint8_t)getUInt("t_svc_core", 0);
+  cfg.task_svc_prio = (uint8_t)getUInt("t_svc_prio", 3);
+  cfg.task_loop_prio = (uint8_t)getUInt("t_loop_prio", 1);
+  taskPlacementSanitize();
+  cfg.log_level = (uint8_t)std::min<uint32_t>(getUInt("log_level", NM_LOG_LEVEL_INFO), NM_LOG_LEVEL_VERBOSE);
   cfg.reboot_mode = (uint8_t)getUInt("rb_mode", 0);
   cfg.reboot_hour = (uint8_t)getUInt("rb_h", 3);
   cfg.reboot_min  = (uint8_t)getUInt("rb_m", 0);
@@ -320,13 +770,15 @@ static void loadConfig() {
   cfg.display_sleep_s = (int)getUInt("disp_sleep", 30);
   cfg.lcd_brightness = (uint8_t)getUInt("lcd_br", 50);
   cfg.lcd_rot180 = getBool("lcd_r180", false);
-  // Mining speed is system-managed. We keep the stored keys for backwards
-  // compatibility but ignore them (always show 100%).
-  cfg.hash_limit_pct = 100;
+  // Per-worker hash-rate limit (token-bucket duty cycle in the hash loop).
+  cfg.hash_limit_pct = (uint8_t)std::min<uint32_t>(getUInt("hash_lim", 100), 100);
   cfg.core1_enabled = getBool("c1_en", false);
 
   cfg.core2_enabled = getBool("c2_en", true);
-  cfg.core2_hash_limit_pct = 100;
+  cfg.core2_hash_limit_pct = (uint8_t)std::min<uint32_t>(getUInt("c2_lim", 100), 100);
+  cfg.thermal_max_c = (uint8_t)std::min<uint32_t>(getUInt("th_max", 80), 110);
+  cfg.thermal_hyst_c = (uint8_t)constrain((int)getUInt("th_hyst", 3), 1, 15);
+  cfg.power_profile = (uint8_t)std::min<uint32_t>(getUInt("pwr_prof", 0), POWER_PROFILE_COUNT - 1);
 
   cfg.led_enabled = getBool("led_en", true);
   cfg.led_brightness = (uint8_t)getUInt("led_br", 50);
@@ -344,6 +796,7 @@ static void loadConfig() {
   cfg.web_pass    = getStr("web_pass", "nukaminer");
 
   prefs.end();
+  cfgPublish();
 }
 
 
@@ -357,6 +810,17 @@ static void saveConfig() {
   prefs.putString("ntp_server", cfg.ntp_server);
   prefs.putString("tz", cfg.tz_name);
   prefs.putUInt("pool_cache_s", cfg.pool_cache_s);
+  prefs.putBool("wifi_roam", cfg.wifi_roam);
+  prefs.putUInt("yield_tgt", cfg.yield_target_ms);
+  prefs.putUInt("t_m0_core", cfg.task_m0_core);
+  prefs.putUInt("t_m1_core", cfg.task_m1_core);
+  prefs.putUInt("t_m_prio", cfg.task_miner_prio);
+  prefs.putUInt("t_pool_core", cfg.task_pool_core);
+  prefs.putUInt("t_pool_prio", cfg.task_pool_prio);
+  prefs.putUInt("t_svc_core", cfg.task_svc_core);
+  prefs.putUInt("t_svc_prio", cfg.task_svc_prio);
+  prefs.putUInt("t_loop_prio", cfg.task_loop_prio);
+  prefs.putUInt("log_level", cfg.log_level);
   prefs.putUInt("rb_mode", cfg.reboot_mode);
   prefs.putUInt("rb_h", cfg.reboot_hour);
   prefs.putUInt("rb_m", cfg.reboot_min);
@@ -370,6 +834,9 @@ static void saveConfig() {
 
   prefs.putBool("c2_en", cfg.core2_enabled);
   prefs.putUInt("c2_lim", cfg.core2_hash_limit_pct);
+  prefs.putUInt("th_max", cfg.thermal_max_c);
+  prefs.putUInt("th_hyst", cfg.thermal_hyst_c);
+  prefs.putUInt("pwr_prof", cfg.power_profile);
   prefs.putBool("led_en", cfg.led_enabled);
   prefs.putUInt("led_br", cfg.led_brightness);
 
@@ -383,6 +850,7 @@ static void saveConfig() {
   prefs.putString("web_user", cfg.web_user);
   prefs.putString("web_pass", cfg.web_pass);
   prefs.end();
+  cfgPublish();
 }
 
 // -----------------------------
@@ -415,6 +883,10 @@ static void wifiProfilesLoad() {
 
   Preferences p; p.begin("nukaminer", false);
   wifiLastSsid = p.getString("wifi_last", "");
+  wifiLastChannel = p.getInt("wifi_chan", 0);
+  if (p.getBytes("wifi_bssid", wifiLastBssid, sizeof(wifiLastBssid)) != sizeof(wifiLastBssid)) {
+    wifiLastChannel = 0;
+  }
   String raw = p.getString("wifi_profiles", "");
   p.end();
 
@@ -445,6 +917,10 @@ static void wifiProfilesSave() {
   Preferences p; p.begin("nukaminer", false);
   p.putString("wifi_profiles", wifiProfilesToJson());
   if (wifiLastSsid.length()) p.putString("wifi_last", wifiLastSsid);
+  if (wifiLastChannel > 0) {
+    p.putBytes("wifi_bssid", wifiLastBssid, sizeof(wifiLastBssid));
+    p.putInt("wifi_chan", wifiLastChannel);
+  }
   p.end();
 }
 
@@ -466,7 +942,7 @@ static void wifiProfilesMigrateLegacy() {
 
 static bool wifiHasAnyConfig() {
   if (!wifiProfiles.empty()) return true;
-  return cfg.wifi_ssid.length() > 0;
+  return cfgView()->wifi_ssid.length() > 0;
 }
 
 static void wifiProfilesUpsert(const String& ssid, const String& pass, int16_t prio, bool keepExistingPrioIfPresent) {
@@ -542,6 +1018,9 @@ static constexpr int PIN_SDMMC_D3  = 18;
 
 static bool sdBegin() {
   if (sdMounted) return true;
+  // A bad card or file system is a classic crash loop; leave it alone.
+  if (NM_crash_safe_mode()) return false;
+  NM_TRACE_SCOPE(NM_TC_SD, "sd mount");
 
   // Try 4-bit first.
   SD_MMC.setPins(PIN_SDMMC_CLK, PIN_SDMMC_CMD, PIN_SDMMC_D0,
@@ -609,11 +1088,13 @@ static bool timeInited = false;
 static void timeSyncOnce() {
   if (timeInited) return;
   if (!WiFi.isConnected()) return;
-  NM_log(String("[NukaMiner] NTP sync using ") + cfg.ntp_server);
-  configTime(0, 0, cfg.ntp_server.c_str(), "time.nist.gov", "time.google.com");
+  const CfgView c = cfgView();
+  NM_log(String("[NukaMiner] NTP sync using ") + c->ntp_server);
+  configTime(0, 0, c->ntp_server.c_str(), "time.nist.gov", "time.google.com");
   struct tm t; 
   if (getLocalTime(&t, 2000)) {
     timeInited = true;
+    bootMark(BOOT_NTP);
   }
 }
 
@@ -730,6 +1211,9 @@ static String makeBackupName() {
 }
 
 static void buildBackupJson(JsonDocument& doc) {
+  // Also built on loop() (last-known-good snapshots): read the published copy.
+  const CfgView view = cfgView();
+  const AppConfig &ac = *view.operator->();
   // Schema header
   doc["schema_version"] = 2;
 
@@ -751,49 +1235,66 @@ static void buildBackupJson(JsonDocument& doc) {
   JsonObject c = doc.createNestedObject("config");
 
   // Main
-  c["wifi_ssid"]    = cfg.wifi_ssid;
-  c["wifi_pass"]    = cfg.wifi_pass;
-  c["duco_user"]    = cfg.duco_user;
-  c["rig_id"]       = cfg.rig_id;
-  c["miner_key"]    = cfg.miner_key;
-  c["ntp_server"]   = cfg.ntp_server;
-  c["tz"]           = cfg.tz_name;
-  c["pool_cache_s"] = cfg.pool_cache_s;
+  c["wifi_ssid"]    = ac.wifi_ssid;
+  c["wifi_pass"]    = ac.wifi_pass;
+  c["duco_user"]    = ac.duco_user;
+  c["rig_id"]       = ac.rig_id;
+  c["miner_key"]    = ac.miner_key;
+  c["ntp_server"]   = ac.ntp_server;
+  c["tz"]           = ac.tz_name;
+  c["pool_cache_s"] = ac.pool_cache_s;
+  c["wifi_roam"]    = ac.wifi_roam;
 
   // Mining (performance mode replaces old per-core toggles)
-  const bool maxPerf = (cfg.core1_enabled && cfg.core2_enabled);
+  const bool maxPerf = (ac.core1_enabled && ac.core2_enabled);
   c["performance_mode"] = maxPerf ? "c12" : "c2";
-  c["duco_enabled"] = cfg.duino_enabled;
+  c["duco_enabled"] = ac.duino_enabled;
+  c["yield_target_ms"] = ac.yield_target_ms;
+  c["hash_limit_pct"]  = ac.hash_limit_pct;
+  c["core2_hash_limit_pct"] = ac.core2_hash_limit_pct;
+  c["thermal_max_c"]   = ac.thermal_max_c;
+  c["thermal_hyst_c"]  = ac.thermal_hyst_c;
+  c["power_profile"]   = powerProfile(ac.power_profile).key;
+  c["task_m0_core"]    = ac.task_m0_core;
+  c["task_m1_core"]    = ac.task_m1_core;
+  c["task_miner_prio"] = ac.task_miner_prio;
+  c["task_pool_core"]  = ac.task_pool_core;
+  c["task_pool_prio"]  = ac.task_pool_prio;
+  c["task_svc_core"]   = ac.task_svc_core;
+  c["task_svc_prio"]   = ac.task_svc_prio;
+  c["task_loop_prio"]  = ac.task_loop_prio;
+  c["log_level"]       = ac.log_level;
 
   // Display
-  c["display_sleep_s"]  = cfg.display_sleep_s;
-  c["lcd_brightness"]   = cfg.lcd_brightness;
-  c["lcd_rot180"]       = cfg.lcd_rot180;
-  c["carousel_enabled"] = cfg.carousel_enabled;
-  c["carousel_seconds"] = cfg.carousel_seconds;
+  c["display_sleep_s"]  = ac.display_sleep_s;
+  c["lcd_brightness"]   = ac.lcd_brightness;
+  c["lcd_rot180"]       = ac.lcd_rot180;
+  c["carousel_enabled"] = ac.carousel_enabled;
+  c["carousel_seconds"] = ac.carousel_seconds;
 
   // LED
-  c["led_enabled"]      = cfg.led_enabled;
-  c["led_brightness"]   = cfg.led_brightness;
+  c["led_enabled"]      = ac.led_enabled;
+  c["led_brightness"]   = ac.led_brightness;
 
   // Web
-  c["web_enabled"]      = cfg.web_enabled;
-  c["web_always_on"]    = cfg.web_always_on;
-  c["web_timeout_s"]    = cfg.web_timeout_s;
-  c["web_user"]         = cfg.web_user;
-  c["web_pass"]         = cfg.web_pass;
+  c["web_enabled"]      = ac.web_enabled;
+  c["web_always_on"]    = ac.web_always_on;
+  c["web_timeout_s"]    = ac.web_timeout_s;
+  c["web_user"]         = ac.web_user;
+  c["web_pass"]         = ac.web_pass;
 
   // Scheduled reboot
   JsonObject rb = c.createNestedObject("scheduled_reboot");
-  rb["mode"] = cfg.reboot_mode;   // 0=Off,1=Daily,2=Weekly,3=Monthly
-  rb["hour"] = cfg.reboot_hour;   // 0-23
-  rb["min"]  = cfg.reboot_min;    // 0-59
-  rb["wday"] = cfg.reboot_wday;   // 0-6 (Sun-Sat)
-  rb["mday"] = cfg.reboot_mday;   // 1-31
+  rb["mode"] = ac.reboot_mode;   // 0=Off,1=Daily,2=Weekly,3=Monthly
+  rb["hour"] = ac.reboot_hour;   // 0-23
+  rb["min"]  = ac.reboot_min;    // 0-59
+  rb["wday"] = ac.reboot_wday;   // 0-6 (Sun-Sat)
+  rb["mday"] = ac.reboot_mday;   // 1-31
 }
 
 static bool sdBackupConfigToFile(const String& fullPath) {
   if (!ensureBackupDir()) return false;
+  NM_TRACE_SCOPE(NM_TC_SD, "sd backup");
   if (SD_MMC.exists(fullPath.c_str())) SD_MMC.remove(fullPath.c_str());
   File f = SD_MMC.open(fullPath.c_str(), FILE_WRITE);
   if (!f) return false;
@@ -806,7 +1307,8 @@ static bool sdBackupConfigToFile(const String& fullPath) {
   return true;
 }
 
-static bool applyConfigFromJson(JsonDocument& doc) {
+// persist=false only changes the running settings (safe mode's last known good).
+static bool applyConfigFromJson(JsonDocument& doc, bool persist = true) {
   // Start from sane defaults (like a fresh device), then apply any fields that exist.
   cfg = AppConfig();
   cfg.rig_id = "NukaMiner"; // struct default is empty; match loadConfig() default
@@ -832,7 +1334,7 @@ static bool applyConfigFromJson(JsonDocument& doc) {
     }
     wifiProfilesSort();
     wifiLastSsid = String((const char*)(doc["wifi_last"] | ""));
-    wifiProfilesSave();
+    if (persist) wifiProfilesSave();
     if (!wifiProfiles.empty()) { cfg.wifi_ssid = wifiProfiles[0].ssid; cfg.wifi_pass = wifiProfiles[0].pass; }
   }
 
@@ -848,6 +1350,7 @@ static bool applyConfigFromJson(JsonDocument& doc) {
   cfg.tz_name     = src["tz"] | (src["tz_name"] | cfg.tz_name);
   cfg.pool_cache_s = (uint32_t)(src["pool_cache_s"] | cfg.pool_cache_s);
   if (cfg.pool_cache_s > 86400) cfg.pool_cache_s = 86400;
+  cfg.wifi_roam = src["wifi_roam"] | cfg.wifi_roam;
 
   // Mining / performance mode
   String pm = String((const char*)(src["performance_mode"] | (src["core_mode"] | "")));
@@ -860,6 +1363,27 @@ static bool applyConfigFromJson(JsonDocument& doc) {
     cfg.core2_enabled = src["core2_enabled"] | (src["c2_en"] | cfg.core2_enabled);
   }
   cfg.duino_enabled = src["duco_enabled"] | (src["duino_enabled"] | cfg.duino_enabled);
+  cfg.yield_target_ms = (uint16_t)std::min<uint32_t>((uint32_t)(src["yield_target_ms"] | cfg.yield_target_ms), 1000);
+  cfg.hash_limit_pct = (uint8_t)std::min<uint32_t>((uint32_t)(src["hash_limit_pct"] | cfg.hash_limit_pct), 100);
+  cfg.core2_hash_limit_pct = (uint8_t)std::min<uint32_t>((uint32_t)(src["core2_hash_limit_pct"] | cfg.core2_hash_limit_pct), 100);
+  cfg.thermal_max_c = (uint8_t)std::min<uint32_t>((uint32_t)(src["thermal_max_c"] | cfg.thermal_max_c), 110);
+  cfg.thermal_hyst_c = (uint8_t)constrain((int)(src["thermal_hyst_c"] | cfg.thermal_hyst_c), 1, 15);
+  {
+    const char *pp = src["power_profile"] | "";
+    for (uint8_t i = 0; i < POWER_PROFILE_COUNT; i++) {
+      if (strcmp(pp, kPowerProfiles[i].key) == 0) cfg.power_profile = i;
+    }
+  }
+  cfg.task_m0_core    = src["task_m0_core"]    | cfg.task_m0_core;
+  cfg.task_m1_core    = src["task_m1_core"]    | cfg.task_m1_core;
+  cfg.task_miner_prio = src["task_miner_prio"] | cfg.task_miner_prio;
+  cfg.task_pool_core  = src["task_pool_core"]  | cfg.task_pool_core;
+  cfg.task_pool_prio  = src["task_pool_prio"]  | cfg.task_pool_prio;
+  cfg.task_svc_core   = src["task_svc_core"]   | cfg.task_svc_core;
+  cfg.task_svc_prio   = src["task_svc_prio"]   | cfg.task_svc_prio;
+  cfg.task_loop_prio  = src["task_loop_prio"]  | cfg.task_loop_prio;
+  taskPlacementSanitize();
+  cfg.log_level       = std::min<uint8_t>(src["log_level"] | cfg.log_level, NM_LOG_LEVEL_VERBOSE);
 
   // Display
   cfg.display_sleep_s  = (uint32_t)(src["display_sleep_s"] | (src["disp_sleep"] | cfg.display_sleep_s));
@@ -907,12 +1431,14 @@ static bool applyConfigFromJson(JsonDocument& doc) {
   // Clamp LCD brightness
   if (cfg.lcd_brightness > 100) cfg.lcd_brightness = 100;
 
-  saveConfig();
+  if (persist) saveConfig();
+  else cfgPublish();   // saveConfig() publishes; the running copy must match either way
   return true;
 }
 
 static bool sdRestoreConfigFromFile(const String& fullPath) {
   if (!sdBegin()) return false;
+  NM_TRACE_SCOPE(NM_TC_SD, "sd restore");
   if (!SD_MMC.exists(fullPath.c_str())) return false;
   File f = SD_MMC.open(fullPath.c_str(), FILE_READ);
   if (!f) return false;
@@ -965,15 +1491,17 @@ static void blInitOnce() {
   blInited = true;
 }
 
-// If updateConfig==true, also keep cfg.lcd_brightness in sync (used when the user
-// changes brightness). For temporary actions, pass updateConfig=false.
-static void blSet(uint8_t percent, bool updateConfig = true) {
+// Sets the panel brightness only; cfg.lcd_brightness is the saved setting and
+// is changed by the settings handlers.
+static void blSet(uint8_t percent) {
+  const CfgView c = cfgView();
   blInitOnce();
   if (percent > 100) percent = 100;
   blRuntimePercent = percent;
-  if (updateConfig) {
-    cfg.lcd_brightness = percent; // keep in sync for immediate UI effect
-  }
+
+  // The power profile caps what reaches the panel, not the saved setting.
+  const uint8_t cap = powerProfile(c->power_profile).lcd_max_pct;
+  if (percent > cap) percent = cap;
 
   // Backlight is often active-low: LOW = on, HIGH = off.
   // PWM duty is inverted so 100% brightness => duty 0 (always LOW)
@@ -1014,14 +1542,15 @@ static void ledSetMode(LedMode m) {
 }
 
 static void ledApplyNow() {
-  if (!cfg.led_enabled) {
+  const CfgView c = cfgView();
+  if (!c->led_enabled || !powerProfile(c->power_profile).led) {
     rgb.setBrightness(0);
     rgb.clear();
     rgb.show();
     ledModeLast = LED_OFF;
     return;
   }
-  uint8_t b = cfg.led_brightness;
+  uint8_t b = c->led_brightness;
   if (b > 100) b = 100;
   uint8_t b255 = (uint8_t)((uint32_t)b * 255 / 100);
   if (b255 != ledBrightnessLast) {
@@ -1036,13 +1565,14 @@ static void ledApplyNow() {
 }
 
 static void ledService() {
+  const CfgView c = cfgView();
   // Locate mode overrides all other LED behavior
   if (locateMode) {
     const bool on = ((millis() / 450UL) % 2UL) == 0UL;
 
     // Locate must work even if the RGB LED is disabled in settings.
     // We deliberately bypass cfg.led_enabled here for the duration of locate mode.
-    uint8_t b = cfg.led_brightness;
+    uint8_t b = c->led_brightness;
     if (b < 15) b = 15;
     if (b > 100) b = 100;
     uint8_t b255 = (uint8_t)((uint32_t)b * 255 / 100);
@@ -1067,7 +1597,7 @@ static void ledService() {
     if (sdBusy) {
       m = LED_YELLOW;
     } else {
-    const bool wantMining = cfg.duino_enabled;
+    const bool wantMining = c->duino_enabled;
     const bool wifiOk = WiFi.isConnected();
     const bool mining = minerIsRunning();
 
@@ -1184,6 +1714,7 @@ static void fbTextClip(const String& s, int x, int y, uint16_t color, uint8_t si
 
 static void fbPush() {
   if (!fbBack) return;
+  NM_TRACE_SCOPE(NM_TC_LCD, "fbPush");
 
   // Push the completed back buffer to the physical LCD.
   // This avoids some ESP32-S3 + TFT_eSPI combinations crashing when using pushImage
@@ -1221,8 +1752,12 @@ static bool portalAuto=false;
 // If the user disables the Web UI, AP/Portal mode must still bring up HTTP so the
 // device can be recovered. We force-enable Web UI at runtime while the portal is
 // running. This is NOT persisted unless the user saves settings.
-static bool portalForcedWeb = false;
-static bool webEnabledBeforePortal = true;
+static volatile bool portalForcedWeb = false;   // web UI on for the portal despite cfg.web_enabled
+
+// The web UI serves requests: the user's setting, or forced on by the portal.
+static bool webUiOn(const AppConfig *c) {
+  return c->web_enabled || portalForcedWeb;
+}
 static IPAddress apIP(192,168,4,1);
 
 // Forward declarations (used in route lambdas before definitions)
@@ -1230,6 +1765,59 @@ static IPAddress apIP(192,168,4,1);
 static void minerStart();
 static void minerStop();
 static bool minerIsRunning();
+static void minerPublishLive();
+// Pool manager / warm standby (defined with the pool task further below)
+static void poolFillStatus(JsonDocument &doc);
+#ifdef NM_TEST_HOOKS
+static void webHandlePoolOverride();
+#endif
+
+// Total hashrate as shown on the LCD/status: first miner plus Core 2 when enabled.
+static inline uint32_t minerTotalHashrate(const MinerStatsSnapshot &st) {
+  return st.worker[0].hashrate + (cfgView()->core2_enabled ? st.worker[1].hashrate : 0U);
+}
+// Network quality monitor (defined before the WiFi section)
+static void webHandleNetJson();
+// Task telemetry (defined before the WiFi section)
+static void webHandleTasksJson();
+static void taskFillStatus(JsonDocument &doc);
+// Task placement (defined after task telemetry)
+static String taskPlacementString();
+static void taskPlacementApply(const String &before);
+// Thermal governor (defined after task placement)
+static float thermalLastC();
+static void thermalFillStatus(JsonDocument &doc);
+// Power profiles (defined after the thermal governor)
+static void powerRadioApply();
+static void powerRadioService();
+static void powerProfileApply();
+static void powerFillStatus(JsonDocument &doc);
+// Health supervisor (defined after WiFi)
+static void healthFillStatus(JsonDocument &doc);
+// Heap telemetry (defined before the miner task)
+static void heapFillStatus(JsonDocument &doc);
+static void allocNoteStatusPoll(uint32_t allocs);
+// Crash-loop safe mode (defined after the health supervisor)
+static void crashFillStatus(JsonDocument &doc);
+static void webHandleCrashJson();
+// Boot sequence (defined after the health supervisor)
+static void bootFillStatus(JsonDocument &doc);
+static void webHandleBootJson();
+// Tracing and CPU profiler (defined before the boot sequence)
+static void webHandleTraceJson();
+static void webHandleProfile();
+#ifdef NM_TRACE
+static void traceWebSpan(uint32_t t0);
+static void traceWebRegister();
+#endif
+static bool taskRespawnSelf(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                            uint8_t prio, uint8_t core, TaskHandle_t *handle);
+// Adaptive yield controller (defined next to the service task)
+static void yieldFillStatus(JsonDocument &doc);
+// Event-driven service task wakeups (defined next to the service task)
+static void svcFillStatus(JsonDocument &doc);
+static void webHandleSvcMode();
+static void svcWakeFromTimerTask(void *arg, uint32_t arg2);
 
 static void portalRenderRoot();
 static void portalHandleSave();
@@ -1269,7 +1857,7 @@ static String urlEncode(const String& s) {
 static bool requireAuthOrPortal() {
   if (portalRunning) return true; // captive portal shouldn't require auth
   const uint32_t nowMs = millis();
-  if (!cfg.web_enabled) { web.send(404, "text/plain", "Not found"); return false; }
+  if (!webUiOn(&cfg)) { web.send(404, "text/plain", "Not found"); return false; }
   if (!webSessionAllowed(nowMs)) {
     web.sendHeader("Cache-Control", "no-store");
     web.send(403, "text/plain", "Web UI is disabled. Press the BOOT button on the device to enable it temporarily.");
@@ -1514,9 +2102,63 @@ page += F("<label>NTP server</label><input name='ntp_server' value='");
   page += String("<option value='c2' ") + (!maxPerf ? "selected" : "") + ">Core 2 only (Default)</option>";
   page += String("<option value='c12' ") + (maxPerf ? "selected" : "") + ">Core 1 and 2 (Max Performance)</option>";
   page += F("</select></div>"
-            "<div></div>"
+            "<div><label>Responsiveness target (ms)</label>"
+            "<input type='number' min='0' max='1000' name='yield_tgt' value='");
+  page += String(cfg.yield_target_ms);
+  page += F("'><div class='muted'>Miners yield just enough to keep Web/WiFi/LCD latency under this. Lower = snappier, higher = more hashrate. 0 = fixed defaults.</div></div>"
             "</div>");
 
+  page += F("<div class='row'><div><label>Hashrate limit Core 1 / Core 2 (%)</label><div style='display:flex;gap:10px'>"
+            "<input type='number' min='0' max='100' name='hash_lim' value='");
+  page += String(cfg.hash_limit_pct);
+  page += F("'><input type='number' min='0' max='100' name='c2_lim' value='");
+  page += String(cfg.core2_hash_limit_pct);
+  page += F("'></div><div class='muted'>Share of time each miner spends hashing, for heat and power. 100 = unlimited, 0 = paused. Applies immediately.</div></div>"
+            "<div><label>Temperature limit / hysteresis (&deg;C)</label><div style='display:flex;gap:10px'>"
+            "<input type='number' min='0' max='110' name='th_max' value='");
+  page += String(cfg.thermal_max_c);
+  page += F("'><input type='number' min='1' max='15' name='th_hyst' value='");
+  page += String(cfg.thermal_hyst_c);
+  page += F("'></div><div class='muted'>Miners slow down smoothly to stay under the limit, and park Core 1 if that is not enough. 0 = off.</div></div></div>");
+
+  page += F("<div class='row'><div><label>Power profile</label><select name='pwr_prof'>");
+  for (uint8_t i = 0; i < POWER_PROFILE_COUNT; i++) {
+    const PowerProfile &pp = kPowerProfiles[i];
+    page += String("<option value='") + i + "'" + (cfg.power_profile == i ? " selected" : "") + ">" + pp.label +
+            " (" + pp.cpu_mhz + " MHz)</option>";
+  }
+  page += F("</select><div class='muted'>Balanced and Efficiency lower the CPU clock, let WiFi sleep between shares and cap LCD/LED and miner duty. "
+            "Compare hashes per joule in /status.json (power).</div></div><div></div></div>");
+
+  // Task placement (core + priority), applied live.
+  {
+    auto coreSel = [&](const char *name, uint8_t v) {
+      page += String("<select name='") + name + "'>";
+      page += String("<option value='0' ") + (v == 0 ? "selected" : "") + ">CPU0</option>";
+      page += String("<option value='1' ") + (v == 1 ? "selected" : "") + ">CPU1</option></select>";
+    };
+    auto prioIn = [&](const char *name, uint8_t v) {
+      page += String("<input type='number' min='") + TASK_PRIO_MIN + "' max='" + TASK_PRIO_MAX +
+              "' name='" + name + "' value='" + v + "'>";
+    };
+    page += F("<div class='row'><div><label>Miner \"Core 1\" / \"Core 2\" CPU</label><div style='display:flex;gap:10px'>");
+    coreSel("t_m0_core", cfg.task_m0_core);
+    coreSel("t_m1_core", cfg.task_m1_core);
+    page += F("</div></div><div><label>Miner priority</label>");
+    prioIn("t_m_prio", cfg.task_miner_prio);
+    page += F("</div></div>");
+    page += F("<div class='row'><div><label>Pool task CPU / priority</label><div style='display:flex;gap:10px'>");
+    coreSel("t_pool_core", cfg.task_pool_core);
+    prioIn("t_pool_prio", cfg.task_pool_prio);
+    page += F("</div></div><div><label>Web/button task CPU / priority</label><div style='display:flex;gap:10px'>");
+    coreSel("t_svc_core", cfg.task_svc_core);
+    prioIn("t_svc_prio", cfg.task_svc_prio);
+    page += F("</div></div></div>");
+    page += F("<div class='row'><div><label>LCD/loop priority</label>");
+    prioIn("t_loop_prio", cfg.task_loop_prio);
+    page += F("<div class='muted'>Changes apply without a reboot. Hashrate and CPU0 lateness before/after are logged and shown in /tasks.json.</div></div><div></div></div>");
+  }
+
   // Dashboard grouping id (shared across workers)
   page += F("<div class='row'><div><label>Group ID (threads)</label>"
             "<div style='display:flex;gap:10px;align-items:center'>"
@@ -1550,6 +2192,13 @@ page += F("<label>NTP server</label><input name='ntp_server' value='");
   page += String(cfg.pool_cache_s);
   page += F("'>"
             "<div class='muted'>Caches the HTTPS <code>/getPool</code> lookup to reduce TLS/JSON overhead. Set 0 to disable.</div>"
+            "</div><div><label>WiFi roaming</label><select name='wifi_roam'>"
+            "<option value='1' ");
+  page += (cfg.wifi_roam ? "selected" : "");
+  page += F(">Enabled</option><option value='0' ");
+  page += (!cfg.wifi_roam ? "selected" : "");
+  page += F(">Disabled</option></select>"
+            "<div class='muted'>Background scan between shares; moves to a clearly stronger AP of a saved network</div>"
             "</div></div>");
 
   page += F("</div>"); // section
@@ -1628,7 +2277,16 @@ page += F("<label>NTP server</label><input name='ntp_server' value='");
 
   page += F("<div class='row'><div><label>Web UI timeout (seconds)</label><input name='web_to' type='number' min='30' max='86400' value='");
   page += String(cfg.web_timeout_s);
-  page += F("'><div class='muted'>Used only when &quot;Web UI always on&quot; is No (press BOOT to enable temporarily).</div></div><div></div></div>");
+  page += F("'><div class='muted'>Used only when &quot;Web UI always on&quot; is No (press BOOT to enable temporarily).</div></div>"
+            "<div><label>Log level</label><select name='log_level'>");
+  {
+    static const char *const names[] = {"Off", "Error", "Warning", "Info", "Debug", "Verbose"};
+    for (uint8_t i = 0; i <= NM_LOG_LEVEL_VERBOSE; i++) {
+      page += String("<option value='") + i + "'" + (cfg.log_level == i ? " selected" : "") + ">" + names[i] +
+              (i > NM_LOG_MAX_LEVEL ? " (not built in)" : "") + "</option>";
+    }
+  }
+  page += F("</select><div class='muted'>Console and Serial. Debug adds job requests, Verbose adds raw jobs. Applies immediately.</div></div></div>");
 
   page += F("<div class='row'><div><label>Web UI username</label><input name='web_user' value='");
   page += htmlEscape(cfg.web_user);
@@ -2001,7 +2659,7 @@ static void webHandleWifiProfileConnect() {
   delay(50);
   if (portalRunning) WiFi.mode(WIFI_AP_STA);
   else WiFi.mode(WIFI_STA);
-  WiFi.setSleep(false);
+  powerRadioApply();
   WiFi.begin(p->ssid.c_str(), p->pass.c_str());
 
   String page = htmlHeader("Connecting");
@@ -2570,7 +3228,7 @@ static void webHandleFileDownload() {
   // Large downloads can stall if the device is busy (mining, SD latency) and the
   // browser will report "connection error". Stream manually with yields and a
   // longer socket timeout.
-  sdBusy = true;
+  setSdBusy(true);
   ledService();
   WiFiClient client = web.client();
   client.setTimeout(120000);
@@ -2582,7 +3240,11 @@ static void webHandleFileDownload() {
 
   static uint8_t buf[2048];
   while (client.connected()) {
-    int n = f.read(buf, sizeof(buf));
+    int n;
+    {
+      NM_TRACE_SCOPE(NM_TC_SD, "sd read");
+      n = f.read(buf, sizeof(buf));
+    }
     if (n <= 0) break;
     size_t w = client.write(buf, (size_t)n);
     if (w != (size_t)n) {
@@ -2594,7 +3256,7 @@ static void webHandleFileDownload() {
     delay(0);
   }
   f.close();
-  sdBusy = false;
+  setSdBusy(false);
   ledService();
 }
 
@@ -2616,6 +3278,9 @@ static void webHandleSaveSettings() {
   const String old_rig_id    = cfg.rig_id;
   const String old_miner_key = cfg.miner_key;
   const String old_ntp_server = cfg.ntp_server;
+  const uint8_t old_m0_core   = cfg.task_m0_core;
+  const uint8_t old_m1_core   = cfg.task_m1_core;
+  const String old_task_place = taskPlacementString();
 
   {
     // WiFi password field on /config is intentionally not pre-filled.
@@ -2641,6 +3306,7 @@ static void webHandleSaveSettings() {
     if (v > 86400) v = 86400;
     cfg.pool_cache_s = (uint32_t)v;
   }
+  if (web.hasArg("wifi_roam")) cfg.wifi_roam = (web.arg("wifi_roam") != "0");
 
   if (web.hasArg("rb_mode")) {
     int m = web.arg("rb_mode").toInt();
@@ -2676,9 +3342,22 @@ static void webHandleSaveSettings() {
   cfg.display_sleep_s = (uint32_t) web.arg("disp_sleep").toInt();
   cfg.lcd_brightness = (uint8_t) constrain(web.arg("lcd_br").toInt(), 0, 100);
   cfg.lcd_rot180 = (web.arg("lcd_r180") != "0");
-  // Mining speed is system-managed; ignore any legacy limiter inputs.
-  cfg.hash_limit_pct = 100;
+  if (web.hasArg("hash_lim")) cfg.hash_limit_pct = (uint8_t) constrain(web.arg("hash_lim").toInt(), 0, 100);
+  if (web.hasArg("c2_lim")) cfg.core2_hash_limit_pct = (uint8_t) constrain(web.arg("c2_lim").toInt(), 0, 100);
+  if (web.hasArg("th_max")) cfg.thermal_max_c = (uint8_t) constrain(web.arg("th_max").toInt(), 0, 110);
+  if (web.hasArg("th_hyst")) cfg.thermal_hyst_c = (uint8_t) constrain(web.arg("th_hyst").toInt(), 1, 15);
+  if (web.hasArg("pwr_prof")) cfg.power_profile = (uint8_t) constrain(web.arg("pwr_prof").toInt(), 0L, (long)POWER_PROFILE_COUNT - 1);
   // Friendly performance mode selector (new). Keep legacy c1_en/c2_en for backwards compatibility.
+  if (web.hasArg("yield_tgt")) cfg.yield_target_ms = (uint16_t)constrain(web.arg("yield_tgt").toInt(), 0L, 1000L);
+  if (web.hasArg("t_m0_core")) cfg.task_m0_core = (uint8_t)web.arg("t_m0_core").toInt();
+  if (web.hasArg("t_m1_core")) cfg.task_m1_core = (uint8_t)web.arg("t_m1_core").toInt();
+  if (web.hasArg("t_m_prio")) cfg.task_miner_prio = (uint8_t)web.arg("t_m_prio").toInt();
+  if (web.hasArg("t_pool_core")) cfg.task_pool_core = (uint8_t)web.arg("t_pool_core").toInt();
+  if (web.hasArg("t_pool_prio")) cfg.task_pool_prio = (uint8_t)web.arg("t_pool_prio").toInt();
+  if (web.hasArg("t_svc_core")) cfg.task_svc_core = (uint8_t)web.arg("t_svc_core").toInt();
+  if (web.hasArg("t_svc_prio")) cfg.task_svc_prio = (uint8_t)web.arg("t_svc_prio").toInt();
+  if (web.hasArg("t_loop_prio")) cfg.task_loop_prio = (uint8_t)web.arg("t_loop_prio").toInt();
+  taskPlacementSanitize();
   if (web.hasArg("core_mode")) {
     const String mode = web.arg("core_mode");
     cfg.core2_enabled = true;               // Core 2 is always available
@@ -2689,7 +3368,6 @@ static void webHandleSaveSettings() {
   }
   // Primary miner selection removed from UI; Core 2 is always treated as the primary.
   cfg.primary_core = 2;
-  cfg.core2_hash_limit_pct = 100;
   cfg.led_enabled = (web.arg("led_en") != "0");
   cfg.led_brightness = (uint8_t) constrain(web.arg("led_br").toInt(), 0, 100);
   cfg.carousel_enabled = (web.arg("car_en") != "0");
@@ -2698,6 +3376,7 @@ static void webHandleSaveSettings() {
   cfg.web_enabled = (web.arg("web_en") != "0");
   cfg.web_always_on = (web.arg("web_always") != "0");
   if (web.hasArg("web_to")) cfg.web_timeout_s = (uint16_t) std::max<long>(30L, web.arg("web_to").toInt());
+  if (web.hasArg("log_level")) cfg.log_level = (uint8_t)constrain(web.arg("log_level").toInt(), 0L, (long)NM_LOG_LEVEL_VERBOSE);
   cfg.web_user = web.arg("web_user");
   cfg.web_pass = web.arg("web_pass");
 
@@ -2717,6 +3396,7 @@ static void webHandleSaveSettings() {
     wifiProfilesUpsert(cfg.wifi_ssid, cfg.wifi_pass, prioForNew, /*keepExistingPrioIfPresent=*/true);
   }
   saveConfig();
+  powerProfileApply();   // no-op unless the profile changed
 
   // If the user turned off "always on", immediately require a physical BOOT press.
   if (!cfg.web_always_on && (old_web_always != cfg.web_always_on || old_web_to != cfg.web_timeout_s)) {
@@ -2745,7 +3425,7 @@ static void webHandleSaveSettings() {
   }
 
   // Apply the user-selected brightness immediately (cfg already updated + saved above).
-  blSet(cfg.lcd_brightness, false);
+  blSet(cfg.lcd_brightness);
   NM_hash_limit_pct = cfg.hash_limit_pct; // alias
   NM_hash_limit_pct_job0 = cfg.hash_limit_pct;
   NM_hash_limit_pct_job1 = cfg.core2_enabled ? cfg.core2_hash_limit_pct : 100;
@@ -2756,10 +3436,21 @@ static void webHandleSaveSettings() {
 // NOTE: Performance mode (core enable/disable) changes can require a full reboot on some builds,
 // so we avoid stopping/starting miners here when perfChanged is true. The user will be prompted
 // to reboot instead.
+  // Rig id, group id and limiter reach running workers through the live
+  // snapshot; only user/key and core placement need a restart.
+  if (minerIsRunning()) {
+    minerPublishLive();
+    if (cfg.rig_id != old_rig_id) NM_log(String("[NukaMiner] Rig id is now ") + cfg.rig_id + " (applied without reconnect)");
+  }
   const bool minerConfigChanged =
             (cfg.duco_user != old_duco_user) ||
-      (cfg.rig_id != old_rig_id) ||
-      (cfg.miner_key != old_miner_key);
+      (cfg.miner_key != old_miner_key) ||
+      (cfg.task_m0_core != old_m0_core) ||
+      (cfg.task_m1_core != old_m1_core);
+
+  // Priorities apply in place; pool/service tasks move themselves to a new
+  // core, miners move through the restart below.
+  if (taskPlacementString() != old_task_place) taskPlacementApply(old_task_place);
 
   if (minerConfigChanged && !perfChanged && !miningToggled) {
     minerStop();
@@ -2797,6 +3488,7 @@ static void webHandleSaveSettings() {
 
 static void webHandleStatusJson() {
   if (!requireAuthOrPortal()) return;
+  const uint32_t allocs0 = NM_alloc_count(NM_ALLOC_SVC);
 
   // Cache the rendered JSON briefly to keep aggressive polling from stealing
   // CPU time from mining. This endpoint is often hit multiple times per second.
@@ -2805,6 +3497,7 @@ static void webHandleStatusJson() {
   const uint32_t nowMs = millis();
   if (cached.length() && (uint32_t)(nowMs - cachedAtMs) < 500) {
     web.send(200, "application/json", cached);
+    allocNoteStatusPoll(NM_alloc_count(NM_ALLOC_SVC) - allocs0);
     return;
   }
 
@@ -2819,12 +3512,18 @@ static void webHandleStatusJson() {
   doc["reset_reason"] = (int)g_resetReason;
   doc["heap"] = (uint32_t)ESP.getFreeHeap();
   doc["heap_total"] = (uint32_t)ESP.getHeapSize();
+  heapFillStatus(doc);
 
   // Internal temperature sensor (ESP32-S3). Note: accuracy is limited.
   // Arduino-ESP32 exposes temperatureRead() on ESP32 targets.
 #if defined(ARDUINO_ARCH_ESP32)
-  doc["temp_c"] = (double)temperatureRead();
+  doc["temp_c"] = (double)thermalLastC();
 #endif
+  thermalFillStatus(doc);
+  powerFillStatus(doc);
+  healthFillStatus(doc);
+  crashFillStatus(doc);
+  bootFillStatus(doc);
 
   uint32_t up = millis()/1000;
   char upbuf[32];
@@ -2840,6 +3539,18 @@ static void webHandleStatusJson() {
   doc["sn"] = WiFi.isConnected() ? WiFi.subnetMask().toString() : "";
   doc["mac"] = WiFi.macAddress();
 
+  doc["wifi_outages"] = (uint32_t)wifiOutageCount;
+  doc["wifi_outage_last_ms"] = (uint32_t)wifiOutageLastMs;
+  doc["wifi_outage_max_ms"] = (uint32_t)wifiOutageMaxMs;
+  doc["wifi_recover_via"] = wifiRecoverVia;
+  doc["wifi_roams"] = wifiRoamCount;
+  doc["wifi_roam_sweeps"] = wifiRoamSweeps;
+  doc["wifi_roam_last_gain_db"] = wifiRoamLastGainDb;
+  {
+    JsonArray h = doc.createNestedArray("wifi_outage_hist");
+    for (uint8_t i = 0; i < WIFI_OUTAGE_BUCKETS; i++) h.add((uint32_t)wifiOutageHist[i]);
+  }
+
   // Time / NTP
   doc["ntp_server"] = cfg.ntp_server;
   time_t nowUtc = time(nullptr);
@@ -2867,19 +3578,45 @@ static void webHandleStatusJson() {
   doc["led_brightness"] = (uint32_t)cfg.led_brightness; // 0-100
   doc["led_on"] = (bool)(cfg.led_enabled && (cfg.led_brightness > 0) && (ledMode != LED_OFF));
   doc["core2_hash_limit_pct"] = cfg.core2_hash_limit_pct;
+  // One consistent snapshot of both workers (seqlock, no locking).
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  const MinerStatsData &latest = st.worker[st.latest];
   // Expose hashrates in kH/s for UI consistency.
-  const double hr1_khs = ((double)(cfg.core1_enabled ? hashrate : 0.0)) / 1000.0;
-  const double hr2_khs = ((double)(cfg.core2_enabled ? hashrate_core_two : 0.0)) / 1000.0;
+  const double hr1_khs = ((double)(cfg.core1_enabled ? st.worker[0].hashrate : 0.0)) / 1000.0;
+  const double hr2_khs = ((double)(cfg.core2_enabled ? st.worker[1].hashrate : 0.0)) / 1000.0;
   const double hrt_khs = hr1_khs + hr2_khs;
   doc["hashrate1"] = hr1_khs;
   doc["hashrate2"] = hr2_khs;
   doc["hashrate"]  = hrt_khs;
   doc["hashrate_unit"] = "kH/s";
-  doc["difficulty"] = difficulty;
-  doc["shares"] = share_count;
-  doc["accepted"] = accepted_share_count;
-  doc["rejected"] = (share_count >= accepted_share_count) ? (share_count - accepted_share_count) : 0;
-  doc["node"] = node_id;
+  doc["difficulty"] = latest.difficulty;
+  doc["shares"] = st.shares;
+  doc["accepted"] = st.accepted;
+  doc["rejected"] = (st.shares >= st.accepted) ? (st.shares - st.accepted) : 0;
+  doc["node"] = latest.node;
+  doc["ping"] = latest.ping_ms;
+  // Limiter: target vs achieved hashing duty over each worker's last run.
+  doc["duty1_target_pct"] = st.worker[0].duty_target / 10.0f;
+  doc["duty1_pct"] = st.worker[0].duty_permille / 10.0f;
+  doc["duty2_target_pct"] = st.worker[1].duty_target / 10.0f;
+  doc["duty2_pct"] = st.worker[1].duty_permille / 10.0f;
+  poolFillStatus(doc);
+  yieldFillStatus(doc);
+  svcFillStatus(doc);
+  taskFillStatus(doc);
+  {
+    static const char *const kGateNames[3] = {"miner0", "miner1", "pool"};
+    doc["gates"] = g_gates ? (uint32_t)xEventGroupGetBits(g_gates) : 0;
+    JsonObject g = doc.createNestedObject("gate_resume");
+    for (uint8_t i = 0; i < 3; i++) {
+      JsonObject o = g.createNestedObject(kGateNames[i]);
+      o["pauses"] = g_gateStats[i].pauses;
+      o["paused_last_ms"] = g_gateStats[i].pausedLastMs;
+      o["resume_last_ms"] = g_gateStats[i].resumeLastMs;
+      o["resume_max_ms"] = g_gateStats[i].resumeMaxMs;
+    }
+  }
 
   // Web UI gating status (useful when Web UI always-on is disabled)
   doc["web_enabled"] = cfg.web_enabled;
@@ -2898,6 +3635,7 @@ static void webHandleStatusJson() {
   serializeJson(doc, cached);
   cachedAtMs = nowMs;
   web.send(200, "application/json", cached);
+  allocNoteStatusPoll(NM_alloc_count(NM_ALLOC_SVC) - allocs0);
 }
 
 
@@ -3096,8 +3834,8 @@ static void webHandleLcdScreenshot() {
   const String mode = web.arg("mode"); // 'sd' or 'download'
   const bool toSd = (mode == "sd");
 
-  // Pause mining during SD writes (minerTaskFn watches sdBusy).
-  sdBusy = true;
+  // Pause mining during SD writes (miners wait on NM_GATE_SD_IDLE).
+  setSdBusy(true);
   ledService();
 
   const uint32_t w = WIDTH;
@@ -3133,7 +3871,7 @@ static void webHandleLcdScreenshot() {
 
   if (toSd) {
     if (!sdBegin()) {
-      sdBusy = false; ledService();
+      setSdBusy(false); ledService();
       web.send(500, "application/json", "{\"error\":\"sd_not_available\"}");
       return;
     }
@@ -3141,14 +3879,14 @@ static void webHandleLcdScreenshot() {
     const String full = String("/screenshots/") + fname;
     File f = SD_MMC.open(full.c_str(), FILE_WRITE);
     if (!f) {
-      sdBusy = false; ledService();
+      setSdBusy(false); ledService();
       web.send(500, "application/json", "{\"error\":\"open_failed\"}");
       return;
     }
     f.write(hdr, sizeof(hdr));
     writeFramebufferBmpToStream(f, asleep);
     f.close();
-    sdBusy = false; ledService();
+    setSdBusy(false); ledService();
     web.sendHeader("Cache-Control", "no-store");
     web.send(200, "application/json", String("{\"saved\":\"") + full + "\"}");
     return;
@@ -3162,7 +3900,7 @@ static void webHandleLcdScreenshot() {
   WiFiClient c = web.client();
   c.write(hdr, sizeof(hdr));
   writeFramebufferBmpToStream(c, asleep);
-  sdBusy = false; ledService();
+  setSdBusy(false); ledService();
 }
 
 // Upload a PNG (generated by the browser) and save it to SD.
@@ -3227,11 +3965,11 @@ static void webHandleLcdUploadPngUpload() {
     if (!lcdPngUploadAuthOk) return;
 
     // Pause mining during SD writes.
-    sdBusy = true;
+    setSdBusy(true);
     ledService();
 
     if (!sdBegin()) {
-      sdBusy = false; ledService();
+      setSdBusy(false); ledService();
       return;
     }
     if (!SD_MMC.exists("/screenshots")) { SD_MMC.mkdir("/screenshots"); }
@@ -3243,7 +3981,7 @@ static void webHandleLcdUploadPngUpload() {
 
     lcdPngUploadFile = SD_MMC.open(lcdPngUploadPath.c_str(), FILE_WRITE);
     if (!lcdPngUploadFile) {
-      sdBusy = false; ledService();
+      setSdBusy(false); ledService();
       lcdPngUploadPath = "";
       return;
     }
@@ -3256,13 +3994,13 @@ static void webHandleLcdUploadPngUpload() {
       lcdPngUploadFile.close();
       lcdPngUploadOk = true;
     }
-    sdBusy = false;
+    setSdBusy(false);
     ledService();
   } else if (up.status == UPLOAD_FILE_ABORTED) {
     if (lcdPngUploadFile) lcdPngUploadFile.close();
     lcdPngUploadOk = false;
     lcdPngUploadPath = "";
-    sdBusy = false;
+    setSdBusy(false);
     ledService();
   }
 }
@@ -3385,47 +4123,152 @@ static void webHandleRestartMiner() {
   minerStart();
 }
 
+// Appends `n` bytes of log text as a JSON string body (no quotes).
+static size_t logJsonEscape(char *dst, size_t cap, const char *src, size_t n) {
+  static const char hex[] = "0123456789abcdef";
+  size_t o = 0;
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t c = (uint8_t)src[i];
+    if (c == '"' || c == '\\') {
+      if (o + 2 > cap) break;
+      dst[o++] = '\\';
+      dst[o++] = (char)c;
+    } else if (c < 0x20) {
+      if (o + 6 > cap) break;
+      dst[o++] = '\\'; dst[o++] = 'u'; dst[o++] = '0'; dst[o++] = '0';
+      dst[o++] = hex[c >> 4]; dst[o++] = hex[c & 15];
+    } else {
+      if (o + 1 > cap) break;
+      dst[o++] = (char)c;
+    }
+  }
+  return o;
+}
+
 static void webHandleLogsJson() {
   if (!requireAuthOrPortal()) return;
-  uint32_t since = (uint32_t) web.arg("since").toInt();
+  // seq is a byte position in the log arena; clients echo it back as `since`.
+  uint32_t since = (uint32_t) strtoul(web.arg("since").c_str(), nullptr, 10);
+  const uint32_t head = g_logRing.head();
 
-  // Fast path: nothing new. Avoid JSON building/allocations.
-  if (since >= logSeq) {
+  // Fast path: nothing new. Avoid JSON building.
+  if (since == head) {
     char buf[96];
-    snprintf(buf, sizeof(buf), "{\"seq\":%lu,\"lines\":[]}", (unsigned long)logSeq);
-    web.send(200, "application/json", buf);
+    int n = snprintf(buf, sizeof(buf), "{\"seq\":%lu,\"lines\":[]}", (unsigned long)head);
+    web.send_P(200, "application/json", buf, (size_t)n);
     return;
   }
 
-  // Copy out up to 60 newest lines newer than `since`.
-  StaticJsonDocument<2048> doc;
-  doc["seq"] = logSeq;
-  JsonArray arr = doc["lines"].to<JsonArray>();
-
-  // If client is too far behind, just send the last 60 lines.
-  uint32_t available = logCount;
-  uint32_t oldestSeq = (logSeq > available) ? (logSeq - available) : 0;
-  if (since < oldestSeq) since = oldestSeq;
-
-  uint32_t startSeq = since;
-  uint32_t endSeq = logSeq;
-  uint32_t maxSend = 60;
-  uint32_t toSend = endSeq - startSeq;
-  if (toSend > maxSend) startSeq = endSeq - maxSend;
-
-  for (uint32_t s = startSeq; s < endSeq; s++) {
-    // Map sequence to ring index
-    uint32_t offsetFromEnd = (endSeq - 1) - s;
-    if (offsetFromEnd >= logCount) continue;
-    int idx = (int)logHead - 1 - (int)offsetFromEnd;
-    while (idx < 0) idx += (int)LOG_LINES_MAX;
-    idx %= (int)LOG_LINES_MAX;
-    arr.add(logLines[idx]);
+  // Walk from `since` (or the oldest surviving line if the client fell
+  // behind) remembering where the newest 60 lines start.
+  static constexpr uint32_t MAX_SEND = 60;
+  static char text[LogRingT::MAX_TEXT];
+  uint32_t starts[MAX_SEND];
+  static LogPendingWait pending;   // across polls: a stuck line is skipped on a later one
+  uint32_t found = 0;
+  uint32_t pos = since;
+  uint16_t len = 0;
+  uint8_t level = 0;
+  uint8_t flags = 0;
+  for (;;) {
+    const uint32_t at = pos;
+    const LogRingT::ReadResult r = g_logRing.read(pos, text, len, level);
+    if (r == LogRingT::READ_OK) {
+      starts[found % MAX_SEND] = at;
+      found++;
+      continue;
+    }
+    // Stale or bogus `since`: restart at the oldest boundary still intact.
+    if (r == LogRingT::READ_LOST || (r == LogRingT::READ_PENDING && found == 0 && at == since)) {
+      const uint32_t next = g_logRing.resync(at);
+      if (next == at) break;
+      pos = next;
+      continue;
+    }
+    if (r == LogRingT::READ_PENDING && pending.expired(at)) {
+      pos = g_logRing.skip(at);
+      continue;
+    }
+    break;
+  }
+  const uint32_t end = pos;
+
+  // Lines that do not fit are left for the next poll (seq stops before them).
+  static char out[8192];
+  size_t o = 0;
+  char seqField[40];
+  const size_t seqCap = sizeof(seqField);
+  o += sizeof("{\"lines\":[") - 1;   // header written last, once seq is known
+  memcpy(out, "{\"lines\":[", o);
+  const uint32_t n = (found > MAX_SEND) ? MAX_SEND : found;
+  pos = (n == 0) ? end : starts[(found - n) % MAX_SEND];
+  uint32_t seq = pos;
+  for (uint32_t i = 0; i < n && pos != end;) {
+    const uint32_t at = pos;
+    const LogRingT::ReadResult r = g_logRing.read(pos, text, len, level, &flags);
+    if (r == LogRingT::READ_PENDING && pending.expired(at)) {   // skipped in the walk above
+      pos = g_logRing.skip(at);
+      continue;
+    }
+    if (r != LogRingT::READ_OK) break;
+    len = logRecordText(text, len, flags);
+    if (o + (size_t)len * 6 + 4 + seqCap > sizeof(out)) break;
+    if (i) out[o++] = ',';
+    out[o++] = '"';
+    o += logJsonEscape(out + o, sizeof(out) - o, text, len);
+    out[o++] = '"';
+    seq = pos;
+    i++;
+  }
+  if (n == 0) seq = end;
+  const int sn = snprintf(seqField, seqCap, "],\"seq\":%lu}", (unsigned long)seq);
+  memcpy(out + o, seqField, (size_t)sn);
+  o += (size_t)sn;
+  web.send_P(200, "application/json", out, o);
+}
+
+// Raw dump of the log ring for tools/nm_events.py. Layout (little endian):
+//   "NMEV", u8 version (1), 3 reserved bytes, u32 millis() at dump, u32 head
+//   then per record: u8 level, u8 flags, u16 len, len payload bytes
+// flags bit 0x02 marks an event (NMEventHdr + u32 args), otherwise UTF-8 text.
+static void webHandleEventsBin() {
+  if (!requireAuthOrPortal()) return;
+  static uint8_t chunk[1024];
+  static char rec[LogRingT::MAX_TEXT];
+  const uint32_t head = g_logRing.head();
+  const uint32_t now = millis();
+  size_t o = 0;
+  memcpy(chunk, "NMEV\x01\0\0\0", 8);
+  memcpy(chunk + 8, &now, 4);
+  memcpy(chunk + 12, &head, 4);
+  o = 16;
+
+  web.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  web.send(200, "application/octet-stream", "");
+  uint32_t pos = g_logRing.resync(0);
+  while ((int32_t)(head - pos) > 0) {
+    uint16_t len = 0;
+    uint8_t level = 0;
+    uint8_t flags = 0;
+    const uint32_t at = pos;
+    const LogRingT::ReadResult r = g_logRing.read(pos, rec, len, level, &flags);
+    if (r == LogRingT::READ_LOST) { pos = g_logRing.resync(pos); continue; }
+    // One-shot dump: a line still uncommitted behind the head is skipped.
+    if (r == LogRingT::READ_PENDING) { pos = g_logRing.skip(at); continue; }
+    if (r != LogRingT::READ_OK) break;
+    if (o + 4 + len > sizeof(chunk)) {
+      web.sendContent((const char *)chunk, o);
+      o = 0;
+    }
+    chunk[o++] = level;
+    chunk[o++] = flags;
+    memcpy(chunk + o, &len, 2);
+    o += 2;
+    memcpy(chunk + o, rec, len);
+    o += len;
   }
-
-  String out;
-  serializeJson(doc, out);
-  web.send(200, "application/json", out);
+  if (o) web.sendContent((const char *)chunk, o);
+  web.sendContent("");
 }
 
 static void webRenderConsole() {
@@ -3436,6 +4279,31 @@ static void webRenderConsole() {
             "<form method='post' action='/miner/restart'><button type='submit'>Restart miner</button></form>"
             "<form method='post' action='/reboot' onsubmit=\"return confirm('Reboot device?');\"><button type='submit'>Reboot</button></form>"
             "</div>");
+  page += F("<div class='section'><b>Trace</b> <span id='trInfo' class='muted'></span><div>"
+            "<button type='button' onclick=\"tr('start')\">Start</button> "
+            "<button type='button' onclick=\"tr('stop')\">Stop</button> "
+            "<button type='button' onclick=\"tr('sd')\">Save to SD</button> "
+            "<a class='smallBtn' href='/trace.json'>Download</a>"
+            "</div></div>"
+            "<script>"
+            "function tr(a){fetch('/trace.json',{method:'POST',body:new URLSearchParams({action:a})})"
+              ".then(r=>r.json()).then(j=>{document.getElementById('trInfo').textContent="
+              "(j.on?'recording':'stopped')+', '+j.kept+'/'+j.capacity+' spans, '+(j.span_ms/1000).toFixed(1)+' s'+(j.path?', saved '+j.path:'');})"
+              ".catch(()=>{});}"
+            "tr('');"
+            "</script>");
+  page += F("<div class='section'><b>CPU profile</b> <span id='pfInfo' class='muted'></span><div>"
+            "<button type='button' onclick=\"pf('start')\">Start</button> "
+            "<button type='button' onclick=\"pf('stop')\">Stop</button> "
+            "<a class='smallBtn' href='/profile?download=1'>Download</a>"
+            "</div><div class='muted'>Flame graph: python3 tools/nm_profile.py nukaminer-profile.bin --elf firmware.elf</div></div>"
+            "<script>"
+            "function pf(a){fetch('/profile',a?{method:'POST',body:new URLSearchParams({action:a})}:{})"
+              ".then(r=>r.json()).then(j=>{document.getElementById('pfInfo').textContent=!j.compiled?'not compiled in':"
+              "(j.on?'sampling':'stopped')+' at '+j.hz+' Hz, '+j.samples+' samples, '+j.stacks+' stacks'+(j.dropped?', '+j.dropped+' dropped':'');})"
+              ".catch(()=>{});}"
+            "pf('');"
+            "</script>");
   page += F("<pre id='log' style='height:360px'>Loading...</pre>");
   page += F(
     "<script>"
@@ -3511,6 +4379,9 @@ static void webHandleUpdateDone() {
 }
 
 static void registerWebHandlers() {
+#ifdef NM_TRACE
+  traceWebRegister();
+#endif
   // Root: redirect to the right section
   web.on("/", HTTP_GET, [](){
     if (portalRunning) { web.sendHeader("Location", "/config"); web.send(302, "text/plain", ""); }
@@ -3536,6 +4407,7 @@ static void registerWebHandlers() {
   web.on("/duco_gid/regenerate", HTTP_POST, [](){
     if (!requireAuthOrPortal()) return;
     String gid = regenerateDucoGroupId();
+    if (minerIsRunning()) minerPublishLive();
     web.send(200, "application/json", String("{\"duco_gid\":\"") + gid + "\"}");
   });
 
@@ -3727,7 +4599,7 @@ web.on("/files/mkdir", HTTP_POST, [](){
 
   web.on("/files/upload", HTTP_POST, [](){
     if (!requireAuthOrPortal()) return;
-    sdBusy = false;
+    setSdBusy(false);
     ledService();
     String redir = web.arg("redir");
     if (redir.length()) {
@@ -3747,7 +4619,7 @@ web.on("/files/mkdir", HTTP_POST, [](){
     static File uploadFile;
     static uint32_t uploadBytesSinceFlush = 0;
     if (up.status == UPLOAD_FILE_START) {
-      sdBusy = true;
+      setSdBusy(true);
       ledService();
       web.client().setTimeout(120000);
       String fname = up.filename;
@@ -3761,6 +4633,7 @@ web.on("/files/mkdir", HTTP_POST, [](){
       NM_log(String("[NukaMiner] SD upload start: " ) + norm);
     } else if (up.status == UPLOAD_FILE_WRITE) {
       if (uploadFile) {
+        NM_TRACE_SCOPE(NM_TC_SD, "sd write");
         size_t w = uploadFile.write(up.buf, up.currentSize);
         if (w != (size_t)up.currentSize) {
           NM_log(String("[NukaMiner] SD upload write short: wrote=") + String((unsigned long)w) + String(" expected=") + String((unsigned long)up.currentSize));
@@ -3771,11 +4644,11 @@ web.on("/files/mkdir", HTTP_POST, [](){
       }
     } else if (up.status == UPLOAD_FILE_END) {
       if (uploadFile) { uploadFile.flush(); uploadFile.close(); NM_log(String("[NukaMiner] SD upload done, bytes=") + up.totalSize); }
-      sdBusy = false;
+      setSdBusy(false);
       ledService();
     } else if (up.status == UPLOAD_FILE_ABORTED) {
       if (uploadFile) uploadFile.close();
-      sdBusy = false;
+      setSdBusy(false);
       ledService();
       NM_log("[NukaMiner] SD upload aborted");
     }
@@ -3803,6 +4676,14 @@ web.on("/files/mkdir", HTTP_POST, [](){
   // Legacy BMP screenshot endpoint (kept for backward compatibility)
   web.on("/lcd/screenshot", HTTP_POST, webHandleLcdScreenshot);
   web.on("/logs.json", HTTP_GET, webHandleLogsJson);
+  web.on("/events.bin", HTTP_GET, webHandleEventsBin);
+  web.on("/crash.json", HTTP_GET, webHandleCrashJson);
+  web.on("/crash.json", HTTP_POST, webHandleCrashJson);
+  web.on("/boot.json", HTTP_GET, webHandleBootJson);
+  web.on("/trace.json", HTTP_GET, webHandleTraceJson);
+  web.on("/trace.json", HTTP_POST, webHandleTraceJson);
+  web.on("/profile", HTTP_GET, webHandleProfile);
+  web.on("/profile", HTTP_POST, webHandleProfile);
   web.on("/btn/boot", HTTP_POST, webHandleBootPress);
   web.on("/locate", HTTP_POST, webHandleLocate);
   web.on("/locate", HTTP_GET,  webHandleLocate);
@@ -3810,6 +4691,14 @@ web.on("/files/mkdir", HTTP_POST, [](){
   web.on("/device_control", HTTP_GET,  webHandleDeviceControl);
   web.on("/ap/start", HTTP_POST, webHandleStartAP);
   web.on("/miner/restart", HTTP_POST, webHandleRestartMiner);
+#ifdef NM_TEST_HOOKS
+  web.on("/pool/override", HTTP_GET, webHandlePoolOverride);
+  web.on("/pool/override", HTTP_POST, webHandlePoolOverride);
+#endif
+  web.on("/net.json", HTTP_GET, webHandleNetJson);
+  web.on("/tasks.json", HTTP_GET, webHandleTasksJson);
+  web.on("/svc/mode", HTTP_GET, webHandleSvcMode);
+  web.on("/svc/mode", HTTP_POST, webHandleSvcMode);
 
   // WiFi helpers
   web.on("/wifi", HTTP_GET, webRenderWifiPage);
@@ -4019,14 +4908,10 @@ static void portalStart(bool isAutoStart) {
   }
 
   // Even if the user disabled the Web UI, AP/Portal mode must still expose HTTP
-  // so they can recover the device. Force-enable at runtime (not persisted).
-  portalForcedWeb = false;
-  if (!cfg.web_enabled) {
-    webEnabledBeforePortal = cfg.web_enabled;
-    cfg.web_enabled = true;
-    portalForcedWeb = true;
-    NM_log("[NukaMiner] Portal forcing Web UI enabled (runtime)");
-  }
+  // so they can recover the device. Force-enable at runtime; cfg is not
+  // touched (portalStart() may run on loop()).
+  portalForcedWeb = !cfgView()->web_enabled;
+  if (portalForcedWeb) NM_log("[NukaMiner] Portal forcing Web UI enabled (runtime)");
 
   // If we have saved WiFi credentials, keep STA enabled so the device can
   // still connect while the portal is running (AP+STA fallback).
@@ -4048,6 +4933,7 @@ static void portalStart(bool isAutoStart) {
   if (!webBegun) { web.begin(); webBegun = true; }
 
   portalRunning = true;
+  nmGateSet(NM_GATE_NO_PORTAL, false);
 }
 
 static void portalLoop() {
@@ -4055,6 +4941,80 @@ static void portalLoop() {
   dns.processNextRequest();
 }
 
+// -----------------------------
+// Heap telemetry
+// -----------------------------
+// Free heap, low-water mark and largest free block, plus allocation counts per
+// subsystem (lib/NukaDuino/src/AllocStats.h; needs the NM_ALLOC_STATS build
+// with the malloc wrappers). Steady-state share cycles, i.e. a share on an
+// already connected socket, are expected to allocate nothing: every one that
+// does is counted and logged, so a regression shows up in /status.json and
+// in tools/alloc_check.py instead of as fragmentation days later.
+struct AllocCycleStats {
+  uint32_t last;      // allocations in the last measured cycle
+  uint32_t max;       // worst cycle so far
+  uint32_t cycles;    // cycles measured
+  uint32_t dirty;     // cycles that allocated
+};
+static AllocCycleStats g_allocShare[2];   // per worker, steady-state share cycles only
+static AllocCycleStats g_allocStatus;     // /status.json requests (cached replies included)
+
+static void allocCycleNote(AllocCycleStats &s, uint32_t allocs) {
+  s.last = allocs;
+  if (allocs > s.max) s.max = allocs;
+  s.cycles++;
+  if (allocs) s.dirty++;
+}
+
+// Miner task: one mine() call. Only steady-state cycles are judged; connects,
+// failovers and job errors allocate by design.
+static void allocNoteShare(uint8_t w, uint32_t allocs, bool steady) {
+  if (!steady || !NM_alloc_enabled()) return;
+  AllocCycleStats &s = g_allocShare[w];
+  const uint32_t prevMax = s.max;
+  allocCycleNote(s, allocs);
+  if (allocs > prevMax) {
+    NM_LOGW("[NukaMiner] Core %u share cycle allocated %lu heap blocks (steady state should be 0)",
+            (unsigned)(w + 1), (unsigned long)allocs);
+  }
+}
+
+static void allocNoteStatusPoll(uint32_t allocs) {
+  if (NM_alloc_enabled()) allocCycleNote(g_allocStatus, allocs);
+}
+
+static void heapFillStatus(JsonDocument &doc) {
+  const uint32_t freeHeap = ESP.getFreeHeap();
+  const uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  doc["heap_min"] = (uint32_t)ESP.getMinFreeHeap();
+  doc["heap_largest"] = largest;
+  // 0 = one contiguous free region, towards 100 = free memory in crumbs.
+  doc["heap_frag_pct"] = freeHeap ? (uint32_t)(100 - std::min<uint32_t>(100, (uint64_t)largest * 100 / freeHeap)) : 0;
+
+  JsonObject a = doc.createNestedObject("alloc");
+  a["enabled"] = NM_alloc_enabled();
+  if (!NM_alloc_enabled()) return;
+  JsonObject tags = a.createNestedObject("tags");
+  for (uint8_t i = 0; i < NM_ALLOC_TAGS; i++) {
+    NMAllocCounters c;
+    NM_alloc_read((NMAllocTag)i, c);
+    JsonObject t = tags.createNestedObject(NM_alloc_tag_names[i]);
+    t["allocs"] = c.allocs;
+    t["live"] = (int32_t)(c.allocs - c.frees);
+    t["bytes"] = c.bytes;
+    if (c.fails) t["fails"] = c.fails;
+  }
+  auto cycle = [](JsonObject o, const AllocCycleStats &s) {
+    o["last"] = s.last;
+    o["max"] = s.max;
+    o["cycles"] = s.cycles;
+    o["dirty"] = s.dirty;
+  };
+  JsonArray sh = a.createNestedArray("share_cycle");
+  for (uint8_t w = 0; w < 2; w++) cycle(sh.createNestedObject(), g_allocShare[w]);
+  cycle(a.createNestedObject("status_poll"), g_allocStatus);
+}
+
 // -----------------------------
 // Duino miner task
 // -----------------------------
@@ -4064,10 +5024,31 @@ static bool minerIsRunning() {
   return ((minerTask0 != nullptr) || (minerTask1 != nullptr)) && minerRun;
 }
 
-static MiningConfig* ducoConfig0 = nullptr;
-static MiningConfig* ducoConfig1 = nullptr;
+// Each miner task owns its job (and the job's MiningConfig) and frees both on
+// exit; these pointers are only used to request a stop. g_minerLock guards
+// them and minerTask0/1: an exiting task clears its own pair under the lock
+// before it frees the job, so whoever holds the lock and sees a non-null
+// handle may use it and the job until it gives the lock back.
 static MiningJob* ducoJob0 = nullptr;
 static MiningJob* ducoJob1 = nullptr;
+static SemaphoreHandle_t g_minerLock = nullptr;   // recursive, created in setup()
+
+struct MinerLock {
+  MinerLock() { xSemaphoreTakeRecursive(g_minerLock, portMAX_DELAY); }
+  ~MinerLock() { xSemaphoreGiveRecursive(g_minerLock); }
+};
+
+// Stop/join protocol between minerStop() and the miner tasks.
+static constexpr EventBits_t MINER_EV_STOP  = (1u << 0);   // interrupts miner sleeps
+static constexpr EventBits_t MINER_EV_EXIT0 = (1u << 1);   // duco0 has exited
+static constexpr EventBits_t MINER_EV_EXIT1 = (1u << 2);   // duco1 has exited
+static constexpr EventBits_t MINER_EV_WAKE0 = (1u << 3);   // interrupts duco0's sleeps only
+static constexpr EventBits_t MINER_EV_WAKE1 = (1u << 4);   // interrupts duco1's sleeps only
+static constexpr uint32_t MINER_JOIN_TIMEOUT_MS = 5000;
+static EventGroupHandle_t g_minerEvents = nullptr;
+static uint32_t g_minerJoinMs = 0;        // last stop: time until both tasks exited
+static uint32_t g_minerJoinTimeouts = 0;
+static uint8_t g_minerRespawn = 0;        // bit w: respawn worker w when it exits
 
 static String ducoGroupId = ""; // shared group-id to aggregate workers on Duino-Coin dashboard
 
@@ -4140,7 +5121,8 @@ static void invalidatePoolCache() {
 }
 
 static bool fetchPoolCached(String &host, int &port) {
-  const uint32_t ttlMs = (cfg.pool_cache_s > 0) ? (cfg.pool_cache_s * 1000UL) : 0UL;
+  const uint32_t cacheS = cfgView()->pool_cache_s;
+  const uint32_t ttlMs = (cacheS > 0) ? (cacheS * 1000UL) : 0UL;
 
   if (ttlMs > 0 && g_cachedPoolHost.length() > 0) {
     if ((uint32_t)(millis() - g_cachedPoolAtMs) < ttlMs) {
@@ -4172,8 +5154,48 @@ static SemaphoreHandle_t poolMutex = nullptr;
 static String g_poolHost;
 static int    g_poolPort = 0;
 static volatile uint32_t g_poolUpdatedMs = 0;
+static volatile uint32_t g_poolVersion = 0;   // bumped when host/port change
 static volatile bool poolInvalidateReq = false;
 
+// Warm standby: the pool task keeps one pre-connected, greeted socket to a
+// second node so a worker whose node dies can switch over without waiting for
+// connect retries, backoff and a fresh /getPool lookup.
+// Candidates are the most recent distinct nodes /getPool handed out (it only
+// returns one node per call), so the standby is "the node we were on before".
+static constexpr uint8_t  STANDBY_CANDIDATES_MAX = 3;
+static constexpr uint32_t STANDBY_RETRY_MS       = 30000;  // min gap between standby connects
+static constexpr uint32_t STANDBY_DISCOVER_MS    = 300000; // uncached /getPool to find a second node
+static String   g_standbyCandHost[STANDBY_CANDIDATES_MAX];
+static int      g_standbyCandPort[STANDBY_CANDIDATES_MAX] = {0};
+static WiFiClient g_standbyClient;
+static String   g_standbyHost;
+static int      g_standbyPort = 0;
+static String   g_standbyGreeting;
+static uint32_t g_standbyAtMs = 0;
+static uint32_t g_standbyTryMs = 0;   // last connect attempt (pool task only)
+static uint32_t g_standbyDiscoverMs = 0;
+
+// Test hook: pin the primary and/or standby node (e.g. a local fake node, see
+// tools/fake_duco_node.py). Runtime only, cleared on reboot. Set through
+// /pool/override, which only builds with -D NM_TEST_HOOKS; empty otherwise.
+static String g_overridePrimaryHost;
+static int    g_overridePrimaryPort = 0;
+static String g_overrideStandbyHost;
+static int    g_overrideStandbyPort = 0;
+
+// Failover metrics (time from losing a node to the first job on the next one).
+static volatile uint32_t g_failoverCount = 0;
+static volatile uint32_t g_failoverStandbyCount = 0;
+static volatile uint32_t g_failoverLastMs = 0;
+static volatile uint32_t g_failoverMaxMs = 0;
+
+// Retry state (RetryPolicy.h): miner workers back off on connect/job failures,
+// the pool task on failed /getPool lookups. Exposed in /status.json.
+static Backoff g_minerBackoff[2] = {Backoff(NM_RETRY_MINER), Backoff(NM_RETRY_MINER)};
+static Backoff g_poolBackoff(NM_RETRY_POOL);
+static volatile uint32_t g_minerRetryMs[2] = {0, 0};
+static volatile uint32_t g_poolRetryMs = 0;
+
 static bool getSharedPool(String &host, int &port) {
   if (!poolMutex) return false;
   if (xSemaphoreTake(poolMutex, pdMS_TO_TICKS(20)) != pdTRUE) return false;
@@ -4186,135 +5208,532 @@ static bool getSharedPool(String &host, int &port) {
 static void setSharedPool(const String &host, int port) {
   if (!poolMutex) return;
   if (xSemaphoreTake(poolMutex, pdMS_TO_TICKS(50)) != pdTRUE) return;
+  if (g_poolHost.length() && (g_poolHost != host || g_poolPort != port)) {
+    // Remember the node we are leaving as a standby candidate (newest first).
+    for (int i = STANDBY_CANDIDATES_MAX - 1; i > 0; i--) {
+      g_standbyCandHost[i] = g_standbyCandHost[i - 1];
+      g_standbyCandPort[i] = g_standbyCandPort[i - 1];
+    }
+    g_standbyCandHost[0] = g_poolHost;
+    g_standbyCandPort[0] = g_poolPort;
+  }
+  if (g_poolHost != host || g_poolPort != port) g_poolVersion = g_poolVersion + 1;
   g_poolHost = host;
   g_poolPort = port;
   g_poolUpdatedMs = millis();
   xSemaphoreGive(poolMutex);
 }
 
-static void poolTaskFn(void *arg) {
-  (void)arg;
+static bool parseHostPort(const String &in, String &host, int &port) {
+  const int colon = in.lastIndexOf(':');
+  if (colon <= 0) return false;
+  host = in.substring(0, colon);
+  port = in.substring(colon + 1).toInt();
+  return host.length() > 0 && port > 0 && port < 65536;
+}
+
+// Pick the standby target: override first, else the newest candidate that is
+// not the current primary. Caller holds poolMutex.
+static bool pickStandbyTargetLocked(String &host, int &port) {
+  if (g_overrideStandbyHost.length()) {
+    host = g_overrideStandbyHost;
+    port = g_overrideStandbyPort;
+    return true;
+  }
+  for (uint8_t i = 0; i < STANDBY_CANDIDATES_MAX; i++) {
+    if (g_standbyCandHost[i].length() == 0) continue;
+    if (g_standbyCandHost[i] == g_poolHost && g_standbyCandPort[i] == g_poolPort) continue;
+    host = g_standbyCandHost[i];
+    port = g_standbyCandPort[i];
+    return true;
+  }
+  return false;
+}
+
+static void standbyDropLocked() {
+  g_standbyClient.stop();
+  g_standbyHost = "";
+  g_standbyPort = 0;
+  g_standbyGreeting = "";
+  g_standbyAtMs = 0;
+}
+
+// Keep the standby socket connected and greeted; reconnect only once it is
+// gone or the target changed, never on a timer. Runs on the pool task.
+static void standbyService() {
+  String host; int port = 0;
+  bool have = false, current = false;
+  if (xSemaphoreTake(poolMutex, pdMS_TO_TICKS(50)) != pdTRUE) return;
+  have = pickStandbyTargetLocked(host, port);
+  if (!have) {
+    if (g_standbyHost.length()) standbyDropLocked();
+  } else {
+    // Keep the socket for as long as it lives: connected() peeks it without
+    // blocking, so a FIN/RST from the node shows up here. Stray bytes on an
+    // idle socket mean it is not in a state a worker can use.
+    const bool alive = g_standbyHost.length() && g_standbyClient.connected() && !g_standbyClient.available();
+    current = alive && g_standbyHost == host && g_standbyPort == port;
+    if (!alive && g_standbyHost.length()) standbyDropLocked();   // a live one stays until replaced
+  }
+  xSemaphoreGive(poolMutex);
+  if (!have || current) return;
+  // A node that closes idle sockets quickly must not turn this into churn.
+  const uint32_t now = millis();
+  if (g_standbyTryMs != 0 && (uint32_t)(now - g_standbyTryMs) < STANDBY_RETRY_MS) return;
+  g_standbyTryMs = now ? now : 1;
+
+  // Connect and read the version greeting outside the lock; workers only
+  // ever see a fully greeted socket.
+  if (!NM_breakers.allow(host.c_str(), port)) return;
+  WiFiClient c;
+  c.setTimeout(5000);
+  if (!c.connect(host.c_str(), port, 3000)) {
+    NM_breakers.record(host.c_str(), port, false);
+    return;
+  }
+  c.setNoDelay(true);
+  const uint32_t t0 = millis();
+  while (c.connected() && !c.available() && (uint32_t)(millis() - t0) < 5000) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  if (!c.available()) {
+    c.stop();
+    NM_breakers.record(host.c_str(), port, false);
+    return;
+  }
+  String greeting = c.readStringUntil('\n');
+  NM_breakers.record(host.c_str(), port, true);
+
+  if (xSemaphoreTake(poolMutex, pdMS_TO_TICKS(50)) != pdTRUE) { c.stop(); return; }
+  g_standbyClient.stop();
+  g_standbyClient = c;
+  g_standbyHost = host;
+  g_standbyPort = port;
+  g_standbyGreeting = greeting;
+  g_standbyAtMs = millis();
+  xSemaphoreGive(poolMutex);
+}
+
+// Declared in lib/NukaDuino/src/MiningJob.h. Hands the standby socket to a
+// worker whose node died and promotes the standby node to primary.
+bool NM_take_standby(WiFiClient &client, String &host, int &port, String &greeting) {
+  if (!poolMutex) return false;
+  if (xSemaphoreTake(poolMutex, pdMS_TO_TICKS(20)) != pdTRUE) return false;
+  if (g_standbyHost.length() == 0 || !g_standbyClient.connected()) {
+    xSemaphoreGive(poolMutex);
+    return false;
+  }
+  client.stop();
+  client = g_standbyClient;
+  host = g_standbyHost;
+  port = g_standbyPort;
+  greeting = g_standbyGreeting;
+
+  // The old primary is dead: forget it instead of keeping it as a candidate.
+  for (uint8_t i = 0; i < STANDBY_CANDIDATES_MAX; i++) {
+    if (g_standbyCandHost[i] == g_poolHost && g_standbyCandPort[i] == g_poolPort) {
+      g_standbyCandHost[i] = "";
+      g_standbyCandPort[i] = 0;
+    }
+  }
+  if (g_poolHost != host || g_poolPort != port) g_poolVersion = g_poolVersion + 1;
+  g_poolHost = host;
+  g_poolPort = port;
+  g_poolUpdatedMs = millis();
+  if (g_overrideStandbyHost.length()) {
+    g_overridePrimaryHost = g_overrideStandbyHost;
+    g_overridePrimaryPort = g_overrideStandbyPort;
+    g_overrideStandbyHost = "";
+    g_overrideStandbyPort = 0;
+  }
+  g_standbyClient = WiFiClient();
+  g_standbyHost = "";
+  g_standbyPort = 0;
+  g_standbyGreeting = "";
+  g_standbyAtMs = 0;
+  xSemaphoreGive(poolMutex);
+  return true;
+}
+
+// Declared in lib/NukaDuino/src/MiningJob.h.
+void NM_failover_done(int core, uint32_t elapsed_ms, bool via_standby) {
+  g_failoverCount++;
+  if (via_standby) g_failoverStandbyCount++;
+  g_failoverLastMs = elapsed_ms;
+  if (elapsed_ms > g_failoverMaxMs) g_failoverMaxMs = elapsed_ms;
+  NM_LOGW("[NukaMiner] Core [%d] failover %s took %lu ms", core,
+          via_standby ? "via standby" : "via reconnect", (unsigned long)elapsed_ms);
+}
+
+static void poolFillStatus(JsonDocument &doc) {
+  doc["failover_count"] = (uint32_t)g_failoverCount;
+  doc["failover_standby_count"] = (uint32_t)g_failoverStandbyCount;
+  doc["failover_last_ms"] = (uint32_t)g_failoverLastMs;
+  doc["failover_max_ms"] = (uint32_t)g_failoverMaxMs;
+
+  doc["retry_miner0_attempts"] = g_minerBackoff[0].attempts();
+  doc["retry_miner0_ms"] = (uint32_t)g_minerRetryMs[0];
+  doc["retry_miner1_attempts"] = g_minerBackoff[1].attempts();
+  doc["retry_miner1_ms"] = (uint32_t)g_minerRetryMs[1];
+  doc["retry_pool_attempts"] = g_poolBackoff.attempts();
+  doc["retry_pool_ms"] = (uint32_t)g_poolRetryMs;
+  doc["miner_join_ms"] = g_minerJoinMs;
+  doc["miner_join_timeouts"] = g_minerJoinTimeouts;
+  doc["log_drain_lost"] = g_logDrainLost;
+  doc["log_level"] = NM_log_level;
+  {
+    // Average share-path CPU cost per log level, for comparing levels.
+    JsonObject sc = doc.createNestedObject("share_cost_us");
+    static const char *const names[] = {"off", "error", "warn", "info", "debug", "verbose"};
+    for (uint8_t i = 0; i <= NM_LOG_LEVEL_VERBOSE; i++) {
+      const uint32_t n = __atomic_load_n(&NM_share_cost[i].shares, __ATOMIC_RELAXED);
+      if (!n) continue;
+      sc[names[i]] = (float)__atomic_load_n(&NM_share_cost[i].total_us, __ATOMIC_RELAXED) / n;
+    }
+  }
+
+  NodeBreakers::Entry br[NodeBreakers::SLOTS];
+  const uint8_t n = NM_breakers.snapshot(br, NodeBreakers::SLOTS);
+  JsonArray arr = doc.createNestedArray("breakers");
+  const uint32_t nowMs = millis();
+  for (uint8_t i = 0; i < n; i++) {
+    JsonObject o = arr.createNestedObject();
+    o["node"] = String(br[i].host) + ":" + String(br[i].port);
+    o["state"] = NodeBreakers::stateName(br[i].state);
+    o["failures"] = br[i].failures;
+    o["trips"] = br[i].trips;
+    o["open_s"] = (br[i].state == NodeBreakers::OPEN && (int32_t)(br[i].openUntilMs - nowMs) > 0)
+                    ? (uint32_t)((br[i].openUntilMs - nowMs) / 1000) : 0;
+  }
+  if (!poolMutex || xSemaphoreTake(poolMutex, pdMS_TO_TICKS(20)) != pdTRUE) return;
+  doc["standby_node"] = g_standbyHost.length() ? (g_standbyHost + ":" + String(g_standbyPort)) : String("");
+  doc["standby_age_s"] = g_standbyHost.length() ? (uint32_t)((millis() - g_standbyAtMs) / 1000) : 0;
+  xSemaphoreGive(poolMutex);
+}
+
+static void poolTaskFn(void *arg);
+
+// Returns only when the task moved to another core (taskRespawnSelf()).
+static void poolTaskLoop() {
   String host; int port = 0;
+  uint32_t nextFetchMs = 0;
 
   // Create mutex lazily in case start order changes
   if (!poolMutex) poolMutex = xSemaphoreCreateMutex();
 
+  NM_alloc_register(NM_ALLOC_POOL);
+  static uint8_t failedCore = 0xFF;   // respawn there failed; survives respawns
   while (true) {
-    if (!minerRun) { vTaskDelay(pdMS_TO_TICKS(250)); continue; }
-
-    if (sdBusy) { vTaskDelay(pdMS_TO_TICKS(100)); continue; }
-
-    if (!WiFi.isConnected()) { vTaskDelay(pdMS_TO_TICKS(500)); continue; }
+    g_poolBeatMs = millis();
+    uint8_t core, prio;
+    {
+      const CfgView pc = cfgView();
+      core = pc->task_pool_core;
+      prio = pc->task_pool_prio;
+    }
+    if (xPortGetCoreID() != (BaseType_t)core && core != failedCore) {
+      if (taskRespawnSelf(poolTaskFn, "ducoPool", POOL_TASK_STACK, nullptr, prio, core, &poolTask)) return;
+      failedCore = core;
+    }
+    // Miners wanted, SD idle and WiFi up; re-check at least once a second.
+    if (!nmGateWait(NM_GATES_POOL, pdMS_TO_TICKS(1000), g_gateStats[2])) continue;
 
     if (poolInvalidateReq) {
       invalidatePoolCache();
       poolInvalidateReq = false;
+      nextFetchMs = millis();
     }
 
     // Refresh pool periodically; if caching enabled, fetchPoolCached will return quickly.
-    if (fetchPoolCached(host, port)) {
-      setSharedPool(host, port);
-      node_id = host + ":" + String(port);
-      // Refresh every 60s, but respond quickly if caching TTL is shorter.
-      vTaskDelay(pdMS_TO_TICKS(60000));
-    } else {
-      vTaskDelay(pdMS_TO_TICKS(5000));
+    const uint32_t now = millis();
+    if ((int32_t)(now - nextFetchMs) >= 0) {
+      bool ok = false, overridden = false;
+      if (xSemaphoreTake(poolMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+        if (g_overridePrimaryHost.length()) {
+          host = g_overridePrimaryHost;
+          port = g_overridePrimaryPort;
+          overridden = ok = true;
+        }
+        xSemaphoreGive(poolMutex);
+      }
+      if (!overridden) ok = fetchPoolCached(host, port);
+      if (ok) {
+        setSharedPool(host, port);
+        bootMark(BOOT_POOL);
+        // Refresh every 60s, but respond quickly if caching TTL is shorter.
+        nextFetchMs = now + 60000;
+        g_poolBackoff.reset();
+        g_poolRetryMs = 0;
+      } else {
+        g_poolRetryMs = g_poolBackoff.next();
+        nextFetchMs = now + g_poolRetryMs;
+      }
+    }
+
+    // With no second node known yet, occasionally bypass the cache: /getPool
+    // load-balances, so a fresh lookup may name a different node.
+    String sbHost; int sbPort = 0;
+    bool haveTarget = false;
+    if (xSemaphoreTake(poolMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+      haveTarget = pickStandbyTargetLocked(sbHost, sbPort);
+      xSemaphoreGive(poolMutex);
+    }
+    if (!haveTarget && port != 0 &&
+        (g_standbyDiscoverMs == 0 || (uint32_t)(now - g_standbyDiscoverMs) >= STANDBY_DISCOVER_MS)) {
+      g_standbyDiscoverMs = now ? now : 1;
+      String h; int p = 0;
+      if (fetchPool(h, p) && (h != host || p != port)) {
+        // Keep mining on the current node; just record the new one as a candidate.
+        if (xSemaphoreTake(poolMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+          for (int i = STANDBY_CANDIDATES_MAX - 1; i > 0; i--) {
+            g_standbyCandHost[i] = g_standbyCandHost[i - 1];
+            g_standbyCandPort[i] = g_standbyCandPort[i - 1];
+          }
+          g_standbyCandHost[0] = h;
+          g_standbyCandPort[0] = p;
+          xSemaphoreGive(poolMutex);
+        }
+      }
+    }
+
+    standbyService();
+    vTaskDelay(pdMS_TO_TICKS(1000));
+  }
+}
+
+static void poolTaskFn(void *arg) {
+  (void)arg;
+  poolTaskLoop();
+  vTaskDelete(nullptr);
+}
+
+#ifdef NM_TEST_HOOKS
+static void webHandlePoolOverride() {
+  if (!requireAuthOrPortal()) return;
+  // primary=host:port / standby=host:port; an empty value clears the override.
+  if (web.hasArg("primary") || web.hasArg("standby")) {
+    String ph, sh; int pp = 0, sp = 0;
+    const bool okP = web.hasArg("primary") && parseHostPort(web.arg("primary"), ph, pp);
+    const bool okS = web.hasArg("standby") && parseHostPort(web.arg("standby"), sh, sp);
+    if (poolMutex && xSemaphoreTake(poolMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+      if (web.hasArg("primary")) { g_overridePrimaryHost = okP ? ph : String(""); g_overridePrimaryPort = okP ? pp : 0; }
+      if (web.hasArg("standby")) { g_overrideStandbyHost = okS ? sh : String(""); g_overrideStandbyPort = okS ? sp : 0; }
+      xSemaphoreGive(poolMutex);
     }
+    poolInvalidateReq = true;
+  }
+  StaticJsonDocument<256> doc;
+  if (poolMutex && xSemaphoreTake(poolMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+    doc["primary"] = g_overridePrimaryHost.length() ? (g_overridePrimaryHost + ":" + String(g_overridePrimaryPort)) : String("");
+    doc["standby"] = g_overrideStandbyHost.length() ? (g_overrideStandbyHost + ":" + String(g_overrideStandbyPort)) : String("");
+    xSemaphoreGive(poolMutex);
   }
+  String out;
+  serializeJson(doc, out);
+  web.send(200, "application/json", out);
 }
+#endif
 
 
 
+// Sleep of worker `w` that ends early when minerStop() raises MINER_EV_STOP
+// or its own wake bit is set (minerRestartWorker()). The wake bit is consumed.
+static void minerSleep(int w, uint32_t ms) {
+  const EventBits_t wake = w ? MINER_EV_WAKE1 : MINER_EV_WAKE0;
+  xEventGroupWaitBits(g_minerEvents, MINER_EV_STOP | wake, pdFALSE, pdFALSE, pdMS_TO_TICKS(ms));
+  xEventGroupClearBits(g_minerEvents, wake);
+}
+
+// Ends both workers' current sleep, e.g. so a paused worker sees a new limit.
+static void minerWake() {
+  if (g_minerEvents) xEventGroupSetBits(g_minerEvents, MINER_EV_WAKE0 | MINER_EV_WAKE1);
+}
 
+static void minerTaskExit(int w, MiningJob *job);   // defined after minerSpawn()
 
 static void minerTaskFn(void *arg) {
   MiningJob *job = (MiningJob*)arg;
+  const int w = (job && job->core != 0) ? 1 : 0;
   if (!job || !job->config) {
-    vTaskDelete(nullptr);
+    minerTaskExit(w, job);
     return;
   }
   MiningConfig *mconf = job->config;
+  NM_alloc_register(w ? NM_ALLOC_MINER1 : NM_ALLOC_MINER0);
+  const NMAllocTag allocTag = w ? NM_ALLOC_MINER1 : NM_ALLOC_MINER0;
 
   uint8_t failCount = 0;
   String host; int port = 0;
-
-  while (minerRun) {
-    // In AP/Portal mode we pause mining entirely. This keeps the web UI and
-    // BOOT interactions responsive while the user is configuring WiFi.
-    if (portalRunning || WiFi.getMode() == WIFI_AP || WiFi.getMode() == WIFI_AP_STA) {
-      vTaskDelay(pdMS_TO_TICKS(200));
+  uint32_t poolVer = 0;
+
+  while (minerRun && !job->stopRequested()) {
+    // Block until mining may proceed: no AP/Portal (keeps the web UI and BOOT
+    // responsive while the user configures WiFi), no large SD transfer (keeps
+    // WiFi responsive), and WiFi up. The timeout only bounds how long a stop
+    // request can go unnoticed.
+    if (!nmGateWait(NM_GATES_MINER, pdMS_TO_TICKS(1000), g_gateStats[w])) continue;
+
+    // Duty 0 (hash limit 0%, or parked by the thermal governor): take no job
+    // and hold no socket. minerPublishLive() wakes the worker when it changes.
+    if (job->paused()) {
+      job->park();
+      minerSleep(w, 1000);
       continue;
     }
 
-    // Pause mining during large SD transfers (uploads/downloads/flashing) to keep WiFi responsive.
-    if (sdBusy) { vTaskDelay(pdMS_TO_TICKS(50)); continue; }
-
-    if (!WiFi.isConnected()) { vTaskDelay(pdMS_TO_TICKS(500)); continue; }
-
-    // Pool resolution is handled by poolTaskFn() on CPU0.
-    if (!getSharedPool(host, port)) { vTaskDelay(pdMS_TO_TICKS(200)); continue; }
-
-    mconf->host = host;
-    mconf->port = port;
+    // Pool resolution is handled by poolTaskFn() on CPU0; only re-read the
+    // shared node (and touch mconf) when the pool task changed it.
+    const uint32_t ver = g_poolVersion;
+    if (port == 0 || ver != poolVer) {
+      if (!getSharedPool(host, port)) { port = 0; minerSleep(w, 200); continue; }
+      poolVer = ver;
+      mconf->host = host;
+      mconf->port = port;
+    }
 
     // MiningJob::mine() performs connect->job->hash->submit.
     // If it fails repeatedly while WiFi is still up, request a pool cache refresh.
+    const uint32_t allocs0 = NM_alloc_count(allocTag);
     const bool ok = job->mine();
+    allocNoteShare(w, NM_alloc_count(allocTag) - allocs0, job->reusedSocket() && !job->networkFailed());
     if (!ok) {
       failCount++;
       if (WiFi.isConnected() && failCount >= 3) {
         poolInvalidateReq = true;
         failCount = 0;
       }
-      vTaskDelay(pdMS_TO_TICKS(200));
+      // Connect/job failures back off with jitter so a fleet doesn't retry a
+      // dead node in lockstep; a rejected share just moves on to the next job.
+      if (job->networkFailed()) {
+        g_minerRetryMs[w] = g_minerBackoff[w].next();
+        minerSleep(w, g_minerRetryMs[w]);
+      } else {
+        minerSleep(w, 200);
+      }
       continue;
     } else {
+      bootMark(BOOT_FIRST_ACCEPT);
       failCount = 0;
+      g_minerBackoff[w].reset();
+      g_minerRetryMs[w] = 0;
     }
 
     // Let the scheduler breathe (but avoid long sleeps here).
     vTaskDelay(1);
   }
 
-  vTaskDelete(nullptr);
+  // Free the job here, not in minerStop(): only this task knows it is no
+  // longer inside mine().
+  minerTaskExit(w, job);
+}
+
+// Push user/key, rig id, group id and limiter (with the JOB and submit lines
+// preformatted) to the workers. They pick the new snapshot up at the start of
+// their next share, on the same connection.
+static void minerPublishLive() {
+  const CfgView c = cfgView();
+  NMMinerLive live;
+  live.user = c->duco_user;
+  live.key = c->miner_key;
+  live.rig_id = c->rig_id.length() ? c->rig_id : c->duco_user;
+  live.group_id = getOrCreateDucoGroupId();
+  live.hash_limit_pct[0] = c->hash_limit_pct;
+  live.hash_limit_pct[1] = c->core2_enabled ? c->core2_hash_limit_pct : 100;
+  MiningJob::formatLive(live);
+  NM_live.publish(std::move(live));
+  minerWake();
+}
+
+
+// Task pinning notes (ESP32-S3):
+// - WiFi + many system tasks usually run on CPU core 0.
+// - The Arduino loop typically runs on CPU core 1.
+// For best responsiveness, keep the *default/primary* miner (Core 2) on CPU core 1.
+// If Core 1 is enabled, run it on CPU core 0 and usually limit it.
+// Both are configurable (Config -> task placement); these are the defaults.
+// Caller holds g_minerLock (the new task cannot exit and clear its handle
+// before the handle is stored).
+static void minerSpawn(uint8_t w) {
+  const CfgView c = cfgView();
+  if (w == 0) {
+    // Core 1 miner task (job0)
+    ducoJob0 = new MiningJob(0, new MiningConfig());
+    xTaskCreatePinnedToCore(minerTaskFn, "duco0", MINER_TASK_STACK, ducoJob0, c->task_miner_prio, &minerTask0, c->task_m0_core);
+  } else {
+    // Core 2 miner task (job1)
+    ducoJob1 = new MiningJob(1, new MiningConfig());
+    // Keep miner priority at 1 so it doesn't starve the Arduino loop/task.
+    // Responsiveness is protected by the serviceTaskFn running at higher priority.
+    xTaskCreatePinnedToCore(minerTaskFn, "duco1", MINER_TASK_STACK, ducoJob1, c->task_miner_prio, &minerTask1, c->task_m1_core);
+  }
 }
 
+// Last thing a miner task does: drop its handle and job pointer, start its
+// replacement if minerRestartWorker() asked for one, then free the job and
+// report the exit.
+static void minerTaskExit(int w, MiningJob *job) {
+  {
+    MinerLock lock;
+    TaskHandle_t &task = w ? minerTask1 : minerTask0;
+    MiningJob *&cur = w ? ducoJob1 : ducoJob0;
+    if (cur == job) {
+      task = nullptr;
+      cur = nullptr;
+    }
+    if (g_minerRespawn & (1u << w)) {
+      g_minerRespawn &= ~(1u << w);
+      if (minerRun && !task) {
+        minerSpawn(w);
+        // Joins the others if they were suspended for the portal meanwhile.
+        if (minerSuspendedForPortal && task) vTaskSuspend(task);
+      }
+    }
+  }
+  if (job) delete job->config;
+  delete job;
+  xEventGroupSetBits(g_minerEvents, w ? MINER_EV_EXIT1 : MINER_EV_EXIT0);
+  vTaskDelete(nullptr);
+}
 
-
+// Ask one worker to stop and start again with a fresh job and socket; the
+// other worker keeps mining. Does not wait: the exiting task spawns its own
+// replacement (minerTaskExit()). Returns false if the worker is not running.
+static bool minerRestartWorker(uint8_t w) {
+  MinerLock lock;
+  MiningJob *job = w ? ducoJob1 : ducoJob0;
+  if (!minerRun || !job) return false;
+  g_minerRespawn |= (uint8_t)(1u << w);
+  job->requestStop();
+  // A worker in connect backoff would otherwise notice only when it wakes.
+  xEventGroupSetBits(g_minerEvents, w ? MINER_EV_WAKE1 : MINER_EV_WAKE0);
+  return true;
+}
 
 static void minerStart() {
+  const CfgView c = cfgView();
+  MinerLock lock;
+  // Also while a timed-out stop is still winding down: that task clears its
+  // handle when it finally exits.
   if (minerTask0 || minerTask1) return;
-  if (!cfg.duino_enabled) return;
+  if (!c->duino_enabled) return;
   if (portalRunning || WiFi.getMode() == WIFI_AP || WiFi.getMode() == WIFI_AP_STA) return;
-  if (cfg.duco_user.length() == 0) return;
+  if (c->duco_user.length() == 0) return;
 
   // If both cores are disabled, nothing to do.
-  if (!cfg.core1_enabled && !cfg.core2_enabled) return;
-
-  // The Duino-Coin dashboard groups miners by their identifier string.
-  // To make each core appear as its own miner, append a -Core# suffix.
-  String idBase = cfg.rig_id;
-  if (idBase.length() == 0) idBase = cfg.duco_user;
+  if (!c->core1_enabled && !c->core2_enabled) return;
 
   // When using a shared group-id, Duino-Coin dashboard aggregates multiple workers into one entry
   // and shows it as a single miner with N threads.
-  // To ensure aggregation, both workers must use the SAME rig identifier and the SAME group-id.
-  String id0 = idBase;
-  String id1 = idBase;
-
-  const String groupId = getOrCreateDucoGroupId();
+  // To ensure aggregation, both workers must use the SAME rig identifier and the SAME group-id;
+  // both read them from the live snapshot.
+  minerPublishLive();
 
+  if (!g_minerEvents) g_minerEvents = xEventGroupCreate();
+  xEventGroupClearBits(g_minerEvents, MINER_EV_STOP | MINER_EV_EXIT0 | MINER_EV_EXIT1 |
+                                      MINER_EV_WAKE0 | MINER_EV_WAKE1);
 
   minerRun = true;
-
-  // Task pinning notes (ESP32-S3):
-  // - WiFi + many system tasks usually run on CPU core 0.
-  // - The Arduino loop typically runs on CPU core 1.
-  // For best responsiveness, keep the *default/primary* miner (Core 2) on CPU core 1.
-  // If Core 1 is enabled, run it on CPU core 0 and usually limit it.
-  const int pinCore1 = 0;
-  const int pinCore2 = 1;
-
+  nmGateSet(NM_GATE_MINER_RUN, true);
 
   // Start pool manager on CPU0 (single resolver for both miners).
   // IMPORTANT: fetchPoolCached() can involve TLS + JSON parsing and can be stack-hungry.
@@ -4322,41 +5741,48 @@ static void minerStart() {
   // Use a larger stack to stay safe on ESP32-S3.
   if (!poolMutex) poolMutex = xSemaphoreCreateMutex();
   if (!poolTask) {
-    constexpr uint32_t POOL_TASK_STACK = 12288; // bytes (3x default 4KB)
-    xTaskCreatePinnedToCore(poolTaskFn, "ducoPool", POOL_TASK_STACK, nullptr, 1, &poolTask, pinCore1);
+    xTaskCreatePinnedToCore(poolTaskFn, "ducoPool", POOL_TASK_STACK, nullptr, c->task_pool_prio, &poolTask, c->task_pool_core);
   }
 
-  // Core 1 miner task (job0)
-  if (cfg.core1_enabled) {
-    ducoConfig0 = new MiningConfig(cfg.duco_user, id0, cfg.miner_key, groupId);
-    ducoJob0 = new MiningJob(0, ducoConfig0);
-    xTaskCreatePinnedToCore(minerTaskFn, "duco0", 8192, ducoJob0, 1, &minerTask0, pinCore1);
-  }
-
-  // Core 2 miner task (job1)
-  if (cfg.core2_enabled) {
-    ducoConfig1 = new MiningConfig(cfg.duco_user, id1, cfg.miner_key, groupId);
-    ducoJob1 = new MiningJob(1, ducoConfig1);
-    // Keep miner priority at 1 so it doesn't starve the Arduino loop/task.
-    // Responsiveness is protected by the serviceTaskFn running at higher priority.
-    xTaskCreatePinnedToCore(minerTaskFn, "duco1", 8192, ducoJob1, 1, &minerTask1, pinCore2);
-  }
+  if (c->core1_enabled) minerSpawn(0);
+  if (c->core2_enabled) minerSpawn(1);
 }
 
 static void minerStop() {
-  minerRun = false;
-  if (minerTask0 || minerTask1) {
-    vTaskDelay(pdMS_TO_TICKS(50));
-    minerTask0 = nullptr;
-    minerTask1 = nullptr;
+  EventBits_t wait = 0;
+  {
+    // Under the lock the jobs cannot be freed: a task clears its pointers
+    // here before it deletes its job.
+    MinerLock lock;
+    if (ducoJob0) ducoJob0->requestStop();
+    if (ducoJob1) ducoJob1->requestStop();
+    minerRun = false;
+    g_minerRespawn = 0;
+    nmGateSet(NM_GATE_MINER_RUN, false);
+    if (minerTask0) wait |= MINER_EV_EXIT0;
+    if (minerTask1) wait |= MINER_EV_EXIT1;
+    if (wait && g_minerEvents) {
+      xEventGroupSetBits(g_minerEvents, MINER_EV_STOP);
+      // A task suspended for the portal would never see the stop.
+      minerResumeAfterPortal();
+    }
+  }
+  // Wait without the lock: the tasks take it on their way out.
+  if (wait && g_minerEvents) {
+    const uint32_t t0 = millis();
+    const EventBits_t got = xEventGroupWaitBits(g_minerEvents, wait, pdFALSE, pdTRUE,
+                                                pdMS_TO_TICKS(MINER_JOIN_TIMEOUT_MS));
+    g_minerJoinMs = millis() - t0;
+    if ((got & wait) != wait) {
+      // Most likely stuck in a blocking connect. It still exits, clears its
+      // handle and frees its job on its own; we just stop waiting for it.
+      g_minerJoinTimeouts++;
+      NM_LOGE("[NukaMiner] Miner task did not stop within %lu ms", (unsigned long)MINER_JOIN_TIMEOUT_MS);
+    }
   }
-  delete ducoJob0; ducoJob0=nullptr;
-  delete ducoJob1; ducoJob1=nullptr;
-  delete ducoConfig0; ducoConfig0=nullptr;
-  delete ducoConfig1; ducoConfig1=nullptr;
-
 }
 static void minerSuspendForPortal() {
+  MinerLock lock;
   if (minerSuspendedForPortal) return;
   // Suspending tasks prevents watchdog resets when switching WiFi modes while
   // a miner is mid-hash/connect on the same core as the web handler.
@@ -4366,6 +5792,7 @@ static void minerSuspendForPortal() {
 }
 
 static void minerResumeAfterPortal() {
+  MinerLock lock;
   if (!minerSuspendedForPortal) return;
   if (minerTask0) vTaskResume(minerTask0);
   if (minerTask1) vTaskResume(minerTask1);
@@ -4401,8 +5828,10 @@ static void webHandleLcdUiJson() {
   // Include page id, sleep flag, share count, and a coarse time bucket so the UI updates.
   const uint32_t nowMs = millis();
   const uint32_t coarse = nowMs / 2000U; // 2s buckets
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
   uint32_t tag = ((uint32_t)page << 24) ^ ((uint32_t)displaySleeping << 23) ^
-                 ((uint32_t)accepted_share_count << 1) ^ (uint32_t)coarse ^
+                 ((uint32_t)st.accepted << 1) ^ (uint32_t)coarse ^
                  ((uint32_t)hrHistPos << 8);
   char etag[24];
   snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)tag);
@@ -4441,11 +5870,11 @@ static void webHandleLcdUiJson() {
     char b1[48]; snprintf(b1, sizeof(b1), "User: %s", cfg.duco_user.c_str()); lines.add(b1);
     char b2[48]; snprintf(b2, sizeof(b2), "Rig: %s", cfg.rig_id.c_str()); lines.add(b2);
 
-    const uint32_t totalHash = (uint32_t)hashrate + (cfg.core2_enabled ? (uint32_t)hashrate_core_two : 0U);
+    const uint32_t totalHash = minerTotalHashrate(st);
     char b3[48]; snprintf(b3, sizeof(b3), "Hash: %.2f kH/s", (double)totalHash / 1000.0); lines.add(b3);
 
-    char b4[48]; snprintf(b4, sizeof(b4), "Diff: %u", (unsigned)difficulty); lines.add(b4);
-    char b5[48]; snprintf(b5, sizeof(b5), "Shares: %lu/%lu", (unsigned long)accepted_share_count, (unsigned long)share_count); lines.add(b5);
+    char b4[48]; snprintf(b4, sizeof(b4), "Diff: %u", (unsigned)st.worker[st.latest].difficulty); lines.add(b4);
+    char b5[48]; snprintf(b5, sizeof(b5), "Shares: %lu/%lu", (unsigned long)st.accepted, (unsigned long)st.shares); lines.add(b5);
   } else if (page == PAGE_IP) {
     if (WiFi.isConnected()) {
       char b1[48]; snprintf(b1, sizeof(b1), "SSID: %s", WiFi.SSID().c_str()); lines.add(b1);
@@ -4475,9 +5904,10 @@ static void webHandleLcdUiJson() {
 }
 
 static void displayWake() {
+  const CfgView c = cfgView();
   displaySleeping = false;
   // Restore configured brightness without mutating the config.
-  blSet(cfg.lcd_brightness, false);
+  blSet(c->lcd_brightness);
   // DISPON (0x29) is common across ST77xx/ILI9xxx controllers.
   // Using the raw command avoids relying on internal TFT_eSPI command macros
   // that some IntelliSense setups may not see.
@@ -4491,11 +5921,12 @@ static void displaySleep() {
   // DISPOFF (0x28) puts the panel into sleep mode; backlight is controlled separately.
   tft.writecommand(0x28);
   // Turn the LCD off without altering the configured brightness.
-  blSet(0, false);
+  blSet(0);
   Serial.println("[NukaMiner] Display sleep");
 }
 
 static void drawTopBar(const char* title) {
+  const CfgView c = cfgView();
   // Top status bar: title + WiFi indicator + temperature + core activity
   fbFillRect(0, 0, WIDTH, 14, TFT_BLACK);
   fbText(title, 4, 3, TFT_YELLOW, 1, false);
@@ -4508,8 +5939,8 @@ static void drawTopBar(const char* title) {
   // - Green = actively mining
   // - Red = disabled
   // - Yellow = enabled but idle
-  const uint16_t c1Col = cfg.core1_enabled ? (c1Active ? TFT_GREEN : TFT_YELLOW) : TFT_RED;
-  const uint16_t c2Col = cfg.core2_enabled ? (c2Active ? TFT_GREEN : TFT_YELLOW) : TFT_RED;
+  const uint16_t c1Col = c->core1_enabled ? (c1Active ? TFT_GREEN : TFT_YELLOW) : TFT_RED;
+  const uint16_t c2Col = c->core2_enabled ? (c2Active ? TFT_GREEN : TFT_YELLOW) : TFT_RED;
   // Add a bit more spacing so "1 2 W" are readable at a glance.
   // Reserve the right-most area for these indicators.
   const int ind1x = WIDTH - 28;
@@ -4519,7 +5950,7 @@ static void drawTopBar(const char* title) {
   fbText("2", ind2x, 3, c2Col, 1, false);
 
   // Web UI indicator (cyan "W") when available
-  const bool webOk = cfg.web_enabled && (portalRunning || cfg.web_always_on || webSessionActive);
+  const bool webOk = webUiOn(c.operator->()) && (portalRunning || c->web_always_on || webSessionActive);
   if (webOk) fbText("W", indWx, 3, TFT_CYAN, 1, false);
 
   // WiFi indicator bars + temperature (keep clear of the 1/2/W indicators, but
@@ -4553,7 +5984,7 @@ static void drawTopBar(const char* title) {
 
   // Temperature (left of WiFi bars)
   // Note: ESP32 internal temp sensor is approximate.
-  const float tc = temperatureRead();
+  const float tc = thermalLastC();
   char tbuf[10];
   snprintf(tbuf, sizeof(tbuf), "%.0fC", (double)tc);
   const uint16_t tcol = (tc >= 70.0f) ? TFT_RED : (tc >= 55.0f ? TFT_ORANGE : TFT_GREEN);
@@ -4570,18 +6001,22 @@ static void drawLogoPage() {
 }
 
 static void drawMiningPage() {
+  const CfgView c = cfgView();
   fbFill(TFT_BLACK);
   drawTopBar("Mining");
 
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+
   // Total hashrate (core1 + optional core2)
-  const uint32_t totalHash = (uint32_t)hashrate + (cfg.core2_enabled ? (uint32_t)hashrate_core_two : 0U);
+  const uint32_t totalHash = minerTotalHashrate(st);
 
   char line1[64];
-  snprintf(line1, sizeof(line1), "User: %s", cfg.duco_user.c_str());
+  snprintf(line1, sizeof(line1), "User: %s", c->duco_user.c_str());
   fbText(line1, 4, 20, TFT_WHITE, 1, false);
 
   char line2[64];
-  snprintf(line2, sizeof(line2), "Rig: %s", cfg.rig_id.c_str());
+  snprintf(line2, sizeof(line2), "Rig: %s", c->rig_id.c_str());
   fbText(line2, 4, 30, TFT_WHITE, 1, false);
 
   const double totalKh = ((double)totalHash) / 1000.0;
@@ -4591,18 +6026,18 @@ static void drawMiningPage() {
   fbText(line3, 4, 42, TFT_WHITE, 1, false);
 
   char line4[64];
-  snprintf(line4, sizeof(line4), "Diff: %u", difficulty);
+  snprintf(line4, sizeof(line4), "Diff: %u", (unsigned)st.worker[st.latest].difficulty);
   fbText(line4, 4, 52, TFT_WHITE, 1, false);
 
   char line5[64];
-  snprintf(line5, sizeof(line5), "Shares: %lu/%lu", accepted_share_count, share_count);
+  snprintf(line5, sizeof(line5), "Shares: %lu/%lu", (unsigned long)st.accepted, (unsigned long)st.shares);
   fbText(line5, 4, 62, TFT_WHITE, 1, false);
 
   // Always show both core hashrates on the Mining page (even if one core is disabled)
   // so the layout stays consistent and the user can see "0.0" for disabled cores.
   char line6[64];
-  const double c1kh = cfg.core1_enabled ? (((double)((uint32_t)hashrate)) / 1000.0) : 0.0;
-  const double c2kh = cfg.core2_enabled ? (((double)((uint32_t)hashrate_core_two)) / 1000.0) : 0.0;
+  const double c1kh = c->core1_enabled ? (((double)st.worker[0].hashrate) / 1000.0) : 0.0;
+  const double c2kh = c->core2_enabled ? (((double)st.worker[1].hashrate) / 1000.0) : 0.0;
   snprintf(line6, sizeof(line6), "C1:%.1f C2:%.1f kH/s", c1kh, c2kh);
   fbText(line6, 4, 72, TFT_WHITE, 1, false);
 }
@@ -4680,7 +6115,9 @@ static void drawHashGraphPage() {
   }
 
   // Current hashrate label (below the graph)
-  const uint32_t totalHash = (uint32_t)hashrate + (cfg.core2_enabled ? (uint32_t)hashrate_core_two : 0U);
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  const uint32_t totalHash = minerTotalHashrate(st);
   snprintf(lbl, sizeof(lbl), "%.2f kH/s", ((double)totalHash)/1000.0);
   fbText(lbl, gx, gy + gh + 2, TFT_WHITE, 1, false);
 }
@@ -4752,6 +6189,10 @@ static void IRAM_ATTR bootBtnIsr() {
   btnIsrRawPressed = (digitalRead(PIN_BUTTON) == LOW);
   btnIsrChangeMs = nowMs;
   btnIsrPending = true;
+  // Kick the service task out of its socket wait; the timer daemon does the send.
+  BaseType_t woken = pdFALSE;
+  xTimerPendFunctionCallFromISR(svcWakeFromTimerTask, nullptr, 0, &woken);
+  if (woken) portYIELD_FROM_ISR();
 }
 
 static bool btnStable = false;        // debounced pressed state
@@ -4889,29 +6330,1276 @@ static void bootButtonShortPress() {
   }
 }
 
+// -----------------------------
+// Adaptive yield controller
+// -----------------------------
+// The hash loops block for one tick every NM_yield_cfg[cpu].slice_ms, keyed by
+// the CPU a miner runs on (either worker may be pinned to either). Instead
+// of a hand-tuned constant, measure what the rest of the system actually sees
+// and adjust each slice once a second (AIMD: halve on a miss, grow slowly
+// while well inside the target):
+//  - CPU0: worst IDLE0 gap (task watchdog margin) and worst service-task
+//    wake-up overshoot (web/button/portal queueing).
+//  - CPU1: worst loop() wake-up overshoot (LCD/LED/WiFi watchdog).
+// cfg.yield_target_ms = 0 restores the fixed defaults. Only CPU1 may reach a
+// slice of 0 (never block): IDLE0 must always run.
+static constexpr uint16_t YIELD_SLICE_MIN_MS  = 2;
+static constexpr uint16_t YIELD_SLICE_MAX_MS  = 250;
+static constexpr uint16_t YIELD_SLICE_STEP_MS = 2;
+static constexpr uint16_t YIELD_DEFAULT_SLICE_MS[2] = {15, 0};   // per CPU
+static constexpr uint32_t YIELD_PERIOD_MS = 1000;
+
+static volatile uint32_t g_idle0SeenMs = 0;
+static volatile uint32_t g_idle0GapMaxMs = 0;
+static volatile uint32_t g_svcLateMaxUs = 0;
+static volatile uint32_t g_loopLateMaxMs = 0;
+
+struct YieldCtlState {
+  uint32_t metricMs;     // worst latency seen in the last period
+  uint32_t lastYieldedUs;
+  uint16_t yieldPermille;
+  uint32_t costHs;       // estimated hashrate given up to yielding on this CPU
+};
+static YieldCtlState g_yieldCtl[2] = {};
+static uint32_t g_yieldLastStepMs = 0;
+
+static bool yieldIdleHook0() {
+  g_idle0SeenMs = millis();
+  return true;
+}
+
+// Called by the service task after a sleep that ran to its timeout.
+static void yieldNoteServiceWake(uint32_t sleptUs, uint32_t wantedUs) {
+  const uint32_t late = (sleptUs > wantedUs) ? (sleptUs - wantedUs) : 0;
+  if (late > g_svcLateMaxUs) g_svcLateMaxUs = late;
+  const uint32_t gap = millis() - g_idle0SeenMs;
+  if (g_idle0SeenMs && gap > g_idle0GapMaxMs) g_idle0GapMaxMs = gap;
+}
+
+// Called by loop() around its fixed sleep.
+static void yieldNoteLoopWake(uint32_t sleptMs, uint32_t wantedMs) {
+  const uint32_t late = (sleptMs > wantedMs) ? (sleptMs - wantedMs) : 0;
+  if (late > g_loopLateMaxMs) g_loopLateMaxMs = late;
+}
+
+static void yieldControllerStep() {
+  const uint32_t now = millis();
+  const uint32_t periodMs = now - g_yieldLastStepMs;
+  if (periodMs < YIELD_PERIOD_MS) return;
+  g_yieldLastStepMs = now;
+
+  g_yieldCtl[0].metricMs = std::max<uint32_t>((uint32_t)g_idle0GapMaxMs, (uint32_t)(g_svcLateMaxUs / 1000UL));
+  g_yieldCtl[1].metricMs = g_loopLateMaxMs;
+  g_idle0GapMaxMs = 0;
+  g_svcLateMaxUs = 0;
+  g_loopLateMaxMs = 0;
+
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  const CfgView yv = cfgView();
+  const uint16_t target = yv->yield_target_ms;
+  const uint8_t workerCpu[2] = {(uint8_t)(yv->task_m0_core ? 1 : 0), (uint8_t)(yv->task_m1_core ? 1 : 0)};
+
+  for (uint8_t c = 0; c < 2; c++) {
+    YieldCtlState &ys = g_yieldCtl[c];
+    NMYieldCfg &yc = NM_yield_cfg[c];
+
+    // Cost: share of wall time spent in blocking yields, scaled to the
+    // hashrate the workers on this CPU would have had without them.
+    uint8_t miners = 0;
+    uint32_t hs = 0;
+    for (uint8_t w = 0; w < 2; w++) {
+      if (workerCpu[w] != c) continue;
+      miners++;
+      hs += st.worker[w].hashrate;
+    }
+    const uint32_t y = yc.yielded_us;
+    const uint32_t dy = y - ys.lastYieldedUs;
+    ys.lastYieldedUs = y;
+    const float frac = std::min(0.95f, (float)dy / ((float)periodMs * 1000.0f * (miners ? miners : 1)));
+    ys.yieldPermille = (uint16_t)(frac * 1000.0f);
+    ys.costHs = (uint32_t)((float)hs * frac / (1.0f - frac));
+
+    if (target == 0) {
+      yc.slice_ms = YIELD_DEFAULT_SLICE_MS[c];
+      continue;
+    }
+
+    uint32_t slice = yc.slice_ms ? yc.slice_ms : YIELD_SLICE_MAX_MS;
+    if (ys.metricMs > target) {
+      slice = std::max<uint32_t>(YIELD_SLICE_MIN_MS, slice / 2);
+    } else if (ys.metricMs * 2 < target) {
+      slice = std::min<uint32_t>(YIELD_SLICE_MAX_MS, slice + YIELD_SLICE_STEP_MS);
+    }
+    yc.slice_ms = (c == 1 && slice >= YIELD_SLICE_MAX_MS) ? 0 : (uint16_t)slice;
+  }
+}
+
+static void yieldFillStatus(JsonDocument &doc) {
+  doc["yield_target_ms"] = cfg.yield_target_ms;
+  for (uint8_t c = 0; c < 2; c++) {
+    const String k = String("yield") + c + "_";
+    doc[k + "slice_ms"] = (uint32_t)NM_yield_cfg[c].slice_ms;
+    doc[k + "latency_ms"] = g_yieldCtl[c].metricMs;
+    doc[k + "pct"] = g_yieldCtl[c].yieldPermille / 10.0;
+    doc[k + "cost_hs"] = g_yieldCtl[c].costHs;
+  }
+}
+
+// -----------------------------
+// Event-driven service task wakeups
+// -----------------------------
+// Polling with vTaskDelay(1) wakes CPU0 ~1000x/s even when nothing happens.
+// Instead the service task sleeps in select() on the WebServer's listening
+// socket plus a loopback UDP "doorbell" (rung by the BOOT button ISR via the
+// timer daemon), with a timeout for periodic work. After any activity it
+// stays on 1-tick polling for a short hot window, because WebServer keeps the
+// accepted client socket private and the captive-portal DNS server must be
+// polled.
+static constexpr uint32_t SVC_IDLE_TIMEOUT_MS = 100;   // periodic work cadence when idle
+static constexpr uint32_t SVC_HOT_MS = 2000;           // 1-tick polling after activity
+static constexpr uint32_t SVC_LISTEN_RESCAN_MS = 30000;
+static constexpr uint16_t SVC_WEB_PORT = 80;
+static constexpr uint16_t SVC_WAKE_PORT = 50080;       // loopback only
+static constexpr uint8_t SVC_WAKE_RADIO = 2;           // wake payload; anything else is the button
+
+static int g_svcWakeFd = -1;
+static int g_svcListenFd = -1;
+static uint32_t g_svcListenScanMs = 0;
+static volatile bool g_svcEventDriven = true;          // runtime A/B switch, not persisted
+
+struct SvcModeStats {
+  uint32_t wakeups;        // wakeups in the current second
+  uint32_t wakeupsPerSec;  // last full second
+  float hs0Avg;            // EMA of the core-0 miner hashrate while in this mode
+  uint32_t seconds;        // seconds sampled in this mode
+};
+static SvcModeStats g_svcModeStats[2] = {};            // [0] polling, [1] event-driven
+static uint32_t g_svcStatsSecMs = 0;
+static uint32_t g_svcSocketWakes = 0;
+static uint32_t g_svcButtonWakes = 0;
+
+static int svcFindListenFd(uint16_t port) {
+  for (int fd = LWIP_SOCKET_OFFSET; fd < LWIP_SOCKET_OFFSET + CONFIG_LWIP_MAX_SOCKETS; fd++) {
+    int listening = 0;
+    socklen_t len = sizeof(listening);
+    if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &len) != 0 || !listening) continue;
+    struct sockaddr_in sa;
+    socklen_t salen = sizeof(sa);
+    if (getsockname(fd, (struct sockaddr *)&sa, &salen) != 0) continue;
+    if (sa.sin_family == AF_INET && ntohs(sa.sin_port) == port) return fd;
+  }
+  return -1;
+}
+
+static bool svcWakeSocketOpen() {
+  if (g_svcWakeFd >= 0) return true;
+  const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return false;
+  struct sockaddr_in sa = {};
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(SVC_WAKE_PORT);
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+    close(fd);
+    return false;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  g_svcWakeFd = fd;
+  return true;
+}
+
+// Runs in the timer daemon task (pended from the button ISR).
+static void svcWakeFromTimerTask(void *arg, uint32_t arg2) {
+  (void)arg;
+  if (g_svcWakeFd < 0) return;
+  struct sockaddr_in to = {};
+  to.sin_family = AF_INET;
+  to.sin_port = htons(SVC_WAKE_PORT);
+  to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const uint8_t b = arg2 ? (uint8_t)arg2 : 1;
+  sendto(g_svcWakeFd, &b, 1, MSG_DONTWAIT, (struct sockaddr *)&to, sizeof(to));
+}
+
+// Blocks until a socket event or the timeout. Returns true on activity.
+static bool svcWaitForEvent(uint32_t timeoutMs) {
+  const uint32_t now = millis();
+  if (webBegun && webUiOn(&cfg)) {
+    if (g_svcListenFd < 0 || (now - g_svcListenScanMs) >= SVC_LISTEN_RESCAN_MS) {
+      g_svcListenFd = svcFindListenFd(SVC_WEB_PORT);
+      g_svcListenScanMs = now;
+    }
+  } else {
+    g_svcListenFd = -1;
+  }
+
+  fd_set rd;
+  FD_ZERO(&rd);
+  FD_SET(g_svcWakeFd, &rd);
+  int maxFd = g_svcWakeFd;
+  if (g_svcListenFd >= 0) {
+    FD_SET(g_svcListenFd, &rd);
+    if (g_svcListenFd > maxFd) maxFd = g_svcListenFd;
+  }
+  struct timeval tv;
+  tv.tv_sec = timeoutMs / 1000;
+  tv.tv_usec = (timeoutMs % 1000) * 1000;
+
+  const uint32_t t0 = micros();
+  const int n = select(maxFd + 1, &rd, nullptr, nullptr, &tv);
+  if (n < 0) {
+    // Most likely the web server was restarted under us; rescan next time.
+    g_svcListenFd = -1;
+    vTaskDelay(1);
+    return false;
+  }
+  if (n == 0) {
+    yieldNoteServiceWake(micros() - t0, timeoutMs * 1000UL);
+    return false;
+  }
+  bool activity = false;
+  if (FD_ISSET(g_svcWakeFd, &rd)) {
+    uint8_t buf[8];
+    int got;
+    bool button = false;
+    while ((got = recv(g_svcWakeFd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+      for (int i = 0; i < got; i++) button |= buf[i] != SVC_WAKE_RADIO;
+    }
+    // A radio wake only needs one pass (powerRadioService()), not hot polling.
+    if (button) {
+      g_svcButtonWakes++;
+      activity = true;
+    }
+  }
+  if (g_svcListenFd >= 0 && FD_ISSET(g_svcListenFd, &rd)) {
+    g_svcSocketWakes++;
+    activity = true;
+  }
+  return activity;
+}
+
+static void svcCountWakeup() {
+  const uint8_t mode = g_svcEventDriven ? 1 : 0;
+  SvcModeStats &ms = g_svcModeStats[mode];
+  ms.wakeups++;
+  const uint32_t now = millis();
+  if ((now - g_svcStatsSecMs) < 1000) return;
+  g_svcStatsSecMs = now;
+  ms.wakeupsPerSec = ms.wakeups;
+  ms.wakeups = 0;
+  g_svcModeStats[mode ^ 1].wakeups = 0;
+
+  // Compare like with like: only sample while the core-0 miner is running.
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  if (!minerIsRunning() || !st.worker[0].hashrate) return;
+  const float hs = (float)st.worker[0].hashrate;
+  ms.hs0Avg = ms.seconds ? (ms.hs0Avg * 0.95f + hs * 0.05f) : hs;
+  ms.seconds++;
+}
+
+static void svcFillStatus(JsonDocument &doc) {
+  const SvcModeStats &poll = g_svcModeStats[0];
+  const SvcModeStats &evt = g_svcModeStats[1];
+  doc["svc_event_driven"] = (bool)g_svcEventDriven;
+  doc["svc_wakeups_s"] = g_svcModeStats[g_svcEventDriven ? 1 : 0].wakeupsPerSec;
+  doc["svc_listen_fd"] = g_svcListenFd;
+  doc["svc_socket_wakes"] = g_svcSocketWakes;
+  doc["svc_button_wakes"] = g_svcButtonWakes;
+  doc["svc_poll_hs0"] = (uint32_t)poll.hs0Avg;
+  doc["svc_poll_s"] = poll.seconds;
+  doc["svc_event_hs0"] = (uint32_t)evt.hs0Avg;
+  doc["svc_event_s"] = evt.seconds;
+  if (poll.seconds && evt.seconds && poll.hs0Avg > 0.0f) {
+    doc["svc_event_gain_pct"] = (evt.hs0Avg - poll.hs0Avg) * 100.0f / poll.hs0Avg;
+  }
+}
+
+// GET reports the mode; POST ?event=0|1 switches it (for A/B hashrate runs).
+static void webHandleSvcMode() {
+  if (!requireAuthOrPortal()) return;
+  if (web.method() == HTTP_POST && web.hasArg("event")) {
+    g_svcEventDriven = web.arg("event").toInt() != 0;
+    NM_log(String("[NukaMiner] Service task wait mode: ") + (g_svcEventDriven ? "event" : "poll"));
+  }
+  StaticJsonDocument<512> doc;
+  svcFillStatus(doc);
+  String out;
+  serializeJson(doc, out);
+  web.send(200, "application/json", out);
+}
+
 // -----------------------------
 // Service task implementation
 // -----------------------------
 static void serviceTaskFn(void *arg) {
   (void)arg;
+  NM_alloc_register(NM_ALLOC_SVC);
+  const bool haveWakeFd = svcWakeSocketOpen();
+  uint32_t hotUntilMs = millis() + SVC_HOT_MS;
+  static uint8_t failedCore = 0xFF;   // respawn there failed; survives respawns
   for (;;) {
+    if (xPortGetCoreID() != (BaseType_t)cfg.task_svc_core && cfg.task_svc_core != failedCore) {
+      if (taskRespawnSelf(serviceTaskFn, "svc", SVC_TASK_STACK, nullptr, cfg.task_svc_prio,
+                          cfg.task_svc_core, &serviceTask)) break;
+      failedCore = cfg.task_svc_core;
+    }
+    g_svcBeatMs = millis();
+    cfgServiceRequests();
     handleButton();
     scheduledRebootCheck();
     portalLoop();
 
-    if (webBegun && cfg.web_enabled) {
+    if (webBegun && webUiOn(&cfg)) {
+      NM_TRACE_BEGIN(trWeb);
       web.handleClient();
+#ifdef NM_TRACE
+      traceWebSpan(trWeb);
+#endif
     }
 
-    // 1 tick keeps CPU0 responsive without eating measurable hashrate.
-    vTaskDelay(1);
+    powerRadioService();
+    yieldControllerStep();
+    svcCountWakeup();
+
+    // Stay on tick polling while something needs it: a debounce in flight,
+    // the captive portal (DNS), a recently active web client, or no sockets.
+    const bool hot = !g_svcEventDriven || !haveWakeFd || portalRunning ||
+                     btnIsrPending || btnLastRaw != btnStable ||
+                     (int32_t)(hotUntilMs - millis()) > 0;
+    if (hot) {
+      const uint32_t t0 = micros();
+      vTaskDelay(1);
+      yieldNoteServiceWake(micros() - t0, portTICK_PERIOD_MS * 1000UL);
+      continue;
+    }
+    if (svcWaitForEvent(SVC_IDLE_TIMEOUT_MS)) hotUntilMs = millis() + SVC_HOT_MS;
+  }
+  // Moved to another core; nothing here owns heap memory.
+  vTaskDelete(nullptr);
+}
+
+// -----------------------------
+// Network quality monitor
+// -----------------------------
+// Separates "bad node" from "bad WiFi": rolling round-trip samples and error
+// counters per node (fed by MiningJob via NM_net_rtt/NM_net_event), and RSSI
+// samples plus disconnect counts per BSSID. Exported at /net.json.
+static constexpr uint8_t NET_NODES = 4;
+static constexpr uint8_t NET_RTT_WINDOW = 64;   // samples per node and kind
+static constexpr uint8_t NET_APS = 6;
+static constexpr uint8_t NET_RSSI_WINDOW = 32;
+static constexpr uint32_t NET_AP_SAMPLE_MS = 10000;
+
+struct NetNodeStats {
+  char host[48];
+  int port;
+  uint32_t lastUsedMs;
+  uint16_t rtt[NM_RTT_KINDS][NET_RTT_WINDOW]; // ms, capped at 65535
+  uint8_t rttPos[NM_RTT_KINDS];
+  uint8_t rttLen[NM_RTT_KINDS];
+  uint32_t connects;
+  uint32_t connectFails;
+  uint32_t timeouts;
+  uint32_t disconnects;
+  uint32_t truncated;
+};
+
+struct NetApStats {
+  uint8_t bssid[6];
+  int32_t channel;
+  char ssid[33];
+  int8_t rssi[NET_RSSI_WINDOW];
+  uint8_t rssiPos;
+  uint8_t rssiLen;
+  uint32_t disconnects;
+  uint32_t lastSeenMs;
+};
+
+static NetNodeStats g_netNodes[NET_NODES];
+static NetApStats g_netAps[NET_APS];
+static portMUX_TYPE g_netMux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t g_netCurBssid[6] = {0};          // AP we are associated with
+static uint32_t g_netApSampleMs = 0;
+
+// Caller holds g_netMux. Reuses the least recently used slot when full.
+static NetNodeStats *netNodeSlotLocked(const String &host, int port) {
+  NetNodeStats *victim = &g_netNodes[0];
+  for (uint8_t i = 0; i < NET_NODES; i++) {
+    NetNodeStats &n = g_netNodes[i];
+    if (n.host[0] && n.port == port && host.equals(n.host)) {
+      n.lastUsedMs = millis();
+      return &n;
+    }
+    if (!n.host[0]) { if (victim->host[0]) victim = &n; }
+    else if (victim->host[0] && (int32_t)(n.lastUsedMs - victim->lastUsedMs) < 0) victim = &n;
+  }
+  memset(victim, 0, sizeof(*victim));
+  strlcpy(victim->host, host.c_str(), sizeof(victim->host));
+  victim->port = port;
+  victim->lastUsedMs = millis();
+  return victim;
+}
+
+// Caller holds g_netMux.
+static NetApStats *netApSlotLocked(const uint8_t *bssid, bool create) {
+  NetApStats *victim = &g_netAps[0];
+  for (uint8_t i = 0; i < NET_APS; i++) {
+    NetApStats &a = g_netAps[i];
+    if (a.lastSeenMs && memcmp(a.bssid, bssid, 6) == 0) return &a;
+    if (!a.lastSeenMs) { if (victim->lastSeenMs) victim = &a; }
+    else if (victim->lastSeenMs && (int32_t)(a.lastSeenMs - victim->lastSeenMs) < 0) victim = &a;
+  }
+  if (!create) return nullptr;
+  memset(victim, 0, sizeof(*victim));
+  memcpy(victim->bssid, bssid, 6);
+  return victim;
+}
+
+// Declared in lib/NukaDuino/src/MiningJob.h.
+void NM_net_rtt(const String &host, int port, uint8_t kind, uint32_t ms) {
+  if (kind >= NM_RTT_KINDS || host.length() == 0) return;
+  // A job reply starts the hash loop; a submit reply is the share's verdict.
+  if (kind == NM_RTT_CONNECT) bootMark(BOOT_NODE);
+  else if (kind == NM_RTT_JOB) bootMark(BOOT_FIRST_HASH);
+  else if (kind == NM_RTT_SUBMIT) bootMark(BOOT_FIRST_SHARE);
+  portENTER_CRITICAL(&g_netMux);
+  NetNodeStats *n = netNodeSlotLocked(host, port);
+  n->rtt[kind][n->rttPos[kind]] = (uint16_t)std::min<uint32_t>(ms, 65535);
+  n->rttPos[kind] = (n->rttPos[kind] + 1) % NET_RTT_WINDOW;
+  if (n->rttLen[kind] < NET_RTT_WINDOW) n->rttLen[kind]++;
+  portEXIT_CRITICAL(&g_netMux);
+}
+
+// Declared in lib/NukaDuino/src/MiningJob.h.
+void NM_net_event(const String &host, int port, uint8_t kind) {
+  if (host.length() == 0) return;
+  portENTER_CRITICAL(&g_netMux);
+  NetNodeStats *n = netNodeSlotLocked(host, port);
+  switch (kind) {
+    case NM_NET_CONNECT:      n->connects++; break;
+    case NM_NET_CONNECT_FAIL: n->connectFails++; break;
+    case NM_NET_TIMEOUT:      n->timeouts++; break;
+    case NM_NET_DISCONNECT:   n->disconnects++; break;
+    case NM_NET_TRUNCATED:    n->truncated++; break;
+    default: break;
+  }
+  portEXIT_CRITICAL(&g_netMux);
+}
+
+static void netApSample(const uint8_t *bssid, int32_t channel, const String &ssid, int rssi) {
+  if (!bssid) return;
+  portENTER_CRITICAL(&g_netMux);
+  NetApStats *a = netApSlotLocked(bssid, true);
+  a->channel = channel;
+  strlcpy(a->ssid, ssid.c_str(), sizeof(a->ssid));
+  a->rssi[a->rssiPos] = (int8_t)constrain(rssi, -127, 0);
+  a->rssiPos = (a->rssiPos + 1) % NET_RSSI_WINDOW;
+  if (a->rssiLen < NET_RSSI_WINDOW) a->rssiLen++;
+  a->lastSeenMs = millis() | 1;
+  portEXIT_CRITICAL(&g_netMux);
+}
+
+// Called from the WiFi event handler: charge the drop to the AP we were on.
+static void netApNoteDisconnect() {
+  portENTER_CRITICAL(&g_netMux);
+  NetApStats *a = netApSlotLocked(g_netCurBssid, false);
+  if (a) a->disconnects++;
+  portEXIT_CRITICAL(&g_netMux);
+}
+
+// Periodic RSSI sample of the associated AP. Called from loop().
+static void netSampleCurrentAp() {
+  const uint32_t now = millis();
+  if ((uint32_t)(now - g_netApSampleMs) < NET_AP_SAMPLE_MS) return;
+  g_netApSampleMs = now;
+  if (!WiFi.isConnected()) return;
+  const uint8_t *b = WiFi.BSSID();
+  if (!b) return;
+  memcpy(g_netCurBssid, b, 6);
+  netApSample(b, WiFi.channel(), WiFi.SSID(), WiFi.RSSI());
+}
+
+// Nearest-rank percentile of an already sorted array.
+static uint16_t netPercentile(const uint16_t *sorted, uint8_t n, uint8_t pct) {
+  if (n == 0) return 0;
+  uint16_t rank = (uint16_t)((pct * (uint32_t)n + 99) / 100);
+  if (rank < 1) rank = 1;
+  return sorted[rank - 1];
+}
+
+static void webHandleNetJson() {
+  if (!requireAuthOrPortal()) return;
+  static const char *const kRttNames[NM_RTT_KINDS] = {"connect", "greeting", "job", "submit"};
+
+  JsonDocument doc;
+  doc["uptime_s"] = (uint32_t)(millis() / 1000);
+
+  JsonArray nodes = doc.createNestedArray("nodes");
+  for (uint8_t i = 0; i < NET_NODES; i++) {
+    // Copy one node out so sorting/JSON work happens outside the spinlock.
+    NetNodeStats n;
+    portENTER_CRITICAL(&g_netMux);
+    n = g_netNodes[i];
+    portEXIT_CRITICAL(&g_netMux);
+    if (!n.host[0]) continue;
+
+    JsonObject o = nodes.createNestedObject();
+    o["node"] = String(n.host) + ":" + String(n.port);
+    o["last_used_s"] = (uint32_t)((millis() - n.lastUsedMs) / 1000);
+    o["connects"] = n.connects;
+    o["reconnects"] = n.connects ? n.connects - 1 : 0;
+    o["connect_fails"] = n.connectFails;
+    o["timeouts"] = n.timeouts;
+    o["disconnects"] = n.disconnects;
+    o["truncated"] = n.truncated;
+    for (uint8_t k = 0; k < NM_RTT_KINDS; k++) {
+      const uint8_t len = n.rttLen[k];
+      std::sort(n.rtt[k], n.rtt[k] + len);
+      JsonObject r = o.createNestedObject(kRttNames[k]);
+      r["n"] = len;
+      r["p50"] = netPercentile(n.rtt[k], len, 50);
+      r["p95"] = netPercentile(n.rtt[k], len, 95);
+      r["p99"] = netPercentile(n.rtt[k], len, 99);
+      r["max"] = len ? n.rtt[k][len - 1] : 0;
+    }
+  }
+
+  JsonArray aps = doc.createNestedArray("aps");
+  for (uint8_t i = 0; i < NET_APS; i++) {
+    NetApStats a;
+    portENTER_CRITICAL(&g_netMux);
+    a = g_netAps[i];
+    portEXIT_CRITICAL(&g_netMux);
+    if (!a.lastSeenMs) continue;
+
+    char mac[18];
+    snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+             a.bssid[0], a.bssid[1], a.bssid[2], a.bssid[3], a.bssid[4], a.bssid[5]);
+    int sum = 0, mn = 0, mx = -127;
+    for (uint8_t j = 0; j < a.rssiLen; j++) {
+      sum += a.rssi[j];
+      if (a.rssi[j] < mn) mn = a.rssi[j];
+      if (a.rssi[j] > mx) mx = a.rssi[j];
+    }
+    JsonObject o = aps.createNestedObject();
+    o["bssid"] = mac;
+    o["ssid"] = a.ssid;
+    o["channel"] = a.channel;
+    o["current"] = (memcmp(a.bssid, g_netCurBssid, 6) == 0) && WiFi.isConnected();
+    o["samples"] = a.rssiLen;
+    o["rssi_last"] = a.rssiLen ? a.rssi[(a.rssiPos + NET_RSSI_WINDOW - 1) % NET_RSSI_WINDOW] : 0;
+    o["rssi_avg"] = a.rssiLen ? sum / (int)a.rssiLen : 0;
+    o["rssi_min"] = a.rssiLen ? mn : 0;
+    o["rssi_max"] = a.rssiLen ? mx : 0;
+    o["disconnects"] = a.disconnects;
+    o["last_seen_s"] = (uint32_t)((millis() - a.lastSeenMs) / 1000);
+  }
+
+  JsonObject w = doc.createNestedObject("wifi");
+  w["outages"] = (uint32_t)wifiOutageCount;
+  w["outage_last_ms"] = (uint32_t)wifiOutageLastMs;
+  w["outage_max_ms"] = (uint32_t)wifiOutageMaxMs;
+  w["roams"] = wifiRoamCount;
+
+  String out;
+  serializeJson(doc, out);
+  web.sendHeader("Cache-Control", "no-store");
+  web.send(200, "application/json", out);
+}
+
+// -----------------------------
+// Task telemetry
+// -----------------------------
+// Every 2 s loop() snapshots all FreeRTOS tasks: core, priority, state,
+// stack high-water mark and run-time counter. CPU use is the counter delta
+// over a ~10 s sliding window, as a share of one core (IDF keeps one run-time
+// clock per core, so each core's tasks add up to ~100%). A task whose unused
+// stack drops under the alarm margin is logged once, and again if it keeps
+// shrinking, so a stack that is about to overflow shows up before the crash.
+static constexpr uint8_t  TASK_TELE_MAX = 32;
+static constexpr uint8_t  TASK_TELE_SLOTS = 6;          // 5 periods -> ~10 s window
+static constexpr uint32_t TASK_TELE_PERIOD_MS = 2000;
+static constexpr uint32_t TASK_STACK_ALARM_BYTES = 768;
+static constexpr uint32_t TASK_STACK_REALARM_BYTES = 128;
+
+struct TaskTele {
+  TaskHandle_t handle;
+  char name[16];
+  int8_t core;            // -1 = not pinned
+  uint8_t prio;
+  uint8_t state;          // eTaskState
+  uint32_t stackFree;     // high-water mark, bytes never touched
+  uint32_t stackSize;     // bytes, 0 = unknown (system tasks)
+  uint32_t alarmedFree;   // stackFree when last logged, 0 = never
+  uint32_t rt[TASK_TELE_SLOTS];
+  uint16_t cpuPermille;
+  bool seen;
+};
+
+// Writer-private table (loop only) and the copy readers take under g_taskMux.
+static TaskTele g_taskWork[TASK_TELE_MAX];
+static TaskTele g_taskPub[TASK_TELE_MAX];
+static uint8_t g_taskWorkCount = 0;
+static uint8_t g_taskPubCount = 0;
+static uint32_t g_taskPubWindowMs = 0;
+static portMUX_TYPE g_taskMux = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskStatus_t g_taskStatusBuf[TASK_TELE_MAX];
+static uint32_t g_taskTotalRt[TASK_TELE_SLOTS] = {};
+static uint32_t g_taskSlotMs[TASK_TELE_SLOTS] = {};
+static uint8_t g_taskSlot = 0;
+static uint8_t g_taskFilled = 0;
+static uint32_t g_taskLastSampleMs = 0;
+static uint32_t g_taskStackAlarms = 0;
+static uint8_t g_taskLowStack = 0;
+
+static uint32_t taskKnownStackSize(const char *name) {
+  if (!strcmp(name, "duco0") || !strcmp(name, "duco1")) return MINER_TASK_STACK;
+  if (!strcmp(name, "ducoPool")) return POOL_TASK_STACK;
+  if (!strcmp(name, "svc")) return SVC_TASK_STACK;
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+  if (!strcmp(name, "loopTask")) return CONFIG_ARDUINO_LOOP_STACK_SIZE;
+#endif
+  return 0;
+}
+
+static bool taskStackLow(const TaskTele &t) {
+  const uint32_t margin = std::max<uint32_t>(TASK_STACK_ALARM_BYTES, t.stackSize / 10);
+  return t.stackFree < margin;
+}
+
+static const char *taskStateName(uint8_t st) {
+  switch (st) {
+    case eRunning: return "running";
+    case eReady: return "ready";
+    case eBlocked: return "blocked";
+    case eSuspended: return "suspended";
+    case eDeleted: return "deleted";
+    default: return "invalid";
+  }
+}
+
+static void taskTelemetrySample() {
+#if configUSE_TRACE_FACILITY
+  const uint32_t now = millis();
+  if (g_taskLastSampleMs && (now - g_taskLastSampleMs) < TASK_TELE_PERIOD_MS) return;
+  g_taskLastSampleMs = now;
+
+  uint32_t totalRt = 0;
+  const UBaseType_t n = uxTaskGetSystemState(g_taskStatusBuf, TASK_TELE_MAX, &totalRt);
+  if (n == 0) return;   // more tasks than TASK_TELE_MAX
+
+  const uint8_t cur = g_taskSlot;
+  const uint8_t filled = (g_taskFilled < TASK_TELE_SLOTS) ? (uint8_t)(g_taskFilled + 1) : TASK_TELE_SLOTS;
+  const uint8_t oldest = (filled == TASK_TELE_SLOTS) ? (uint8_t)((cur + 1) % TASK_TELE_SLOTS) : 0;
+  g_taskTotalRt[cur] = totalRt;
+  g_taskSlotMs[cur] = now;
+
+  for (uint8_t i = 0; i < g_taskWorkCount; i++) g_taskWork[i].seen = false;
+
+  for (UBaseType_t k = 0; k < n; k++) {
+    const TaskStatus_t &ts = g_taskStatusBuf[k];
+    TaskTele *t = nullptr;
+    for (uint8_t i = 0; i < g_taskWorkCount; i++) {
+      if (g_taskWork[i].handle == ts.xHandle) { t = &g_taskWork[i]; break; }
+    }
+    if (!t) {
+      if (g_taskWorkCount >= TASK_TELE_MAX) continue;
+      t = &g_taskWork[g_taskWorkCount++];
+      memset(t, 0, sizeof(*t));
+      t->handle = ts.xHandle;
+      strlcpy(t->name, ts.pcTaskName ? ts.pcTaskName : "?", sizeof(t->name));
+      t->stackSize = taskKnownStackSize(t->name);
+#if configGENERATE_RUN_TIME_STATS
+      // A new task has no history: start its window at the current counter.
+      for (uint8_t j = 0; j < TASK_TELE_SLOTS; j++) t->rt[j] = ts.ulRunTimeCounter;
+#endif
+    }
+    t->seen = true;
+#if configTASKLIST_INCLUDE_COREID
+    t->core = (ts.xCoreID == tskNO_AFFINITY) ? -1 : (int8_t)ts.xCoreID;
+#else
+    t->core = -1;
+#endif
+    t->prio = (uint8_t)ts.uxCurrentPriority;
+    t->state = (uint8_t)ts.eCurrentState;
+    t->stackFree = ts.usStackHighWaterMark;
+#if configGENERATE_RUN_TIME_STATS
+    t->rt[cur] = ts.ulRunTimeCounter;
+    const uint32_t dTotal = totalRt - g_taskTotalRt[oldest];
+    const uint32_t dTask = t->rt[cur] - t->rt[oldest];
+    t->cpuPermille = dTotal ? (uint16_t)std::min<uint64_t>(1000, (uint64_t)dTask * 1000ULL / dTotal) : 0;
+#endif
+  }
+
+  // Drop deleted tasks (keeps the table compact, order otherwise stable).
+  uint8_t w = 0;
+  for (uint8_t i = 0; i < g_taskWorkCount; i++) {
+    if (g_taskWork[i].seen) {
+      if (w != i) g_taskWork[w] = g_taskWork[i];
+      w++;
+    }
+  }
+  g_taskWorkCount = w;
+
+  g_taskSlot = (uint8_t)((cur + 1) % TASK_TELE_SLOTS);
+  g_taskFilled = filled;
+
+  // Low-stack alarms: log outside the spinlock.
+  uint8_t low = 0;
+  for (uint8_t i = 0; i < g_taskWorkCount; i++) {
+    TaskTele &t = g_taskWork[i];
+    if (!taskStackLow(t)) continue;
+    low++;
+    if (t.alarmedFree && t.stackFree + TASK_STACK_REALARM_BYTES > t.alarmedFree) continue;
+    t.alarmedFree = t.stackFree;
+    g_taskStackAlarms++;
+    char line[112];
+    if (t.stackSize) {
+      snprintf(line, sizeof(line), "[NukaMiner] Low stack: task %s has %lu of %lu bytes left",
+               t.name, (unsigned long)t.stackFree, (unsigned long)t.stackSize);
+    } else {
+      snprintf(line, sizeof(line), "[NukaMiner] Low stack: task %s has %lu bytes left",
+               t.name, (unsigned long)t.stackFree);
+    }
+    NM_log(line);
+  }
+  g_taskLowStack = low;
+
+  portENTER_CRITICAL(&g_taskMux);
+  memcpy(g_taskPub, g_taskWork, sizeof(TaskTele) * g_taskWorkCount);
+  g_taskPubCount = g_taskWorkCount;
+  g_taskPubWindowMs = now - g_taskSlotMs[oldest];
+  portEXIT_CRITICAL(&g_taskMux);
+#endif
+}
+
+static void taskTuneFill(JsonObject o);
+
+static void taskFillStatus(JsonDocument &doc) {
+  doc["tasks_low_stack"] = g_taskLowStack;
+  doc["tasks_stack_alarms"] = g_taskStackAlarms;
+  taskTuneFill(doc.createNestedObject("task_tune"));
+}
+
+static void webHandleTasksJson() {
+  if (!requireAuthOrPortal()) return;
+
+  // ~2 KB: keep the copy off the service task stack.
+  static TaskTele snap[TASK_TELE_MAX];
+  uint8_t count;
+  uint32_t windowMs;
+  portENTER_CRITICAL(&g_taskMux);
+  count = g_taskPubCount;
+  windowMs = g_taskPubWindowMs;
+  memcpy(snap, g_taskPub, sizeof(TaskTele) * count);
+  portEXIT_CRITICAL(&g_taskMux);
+
+  std::sort(snap, snap + count, [](const TaskTele &a, const TaskTele &b) {
+    return a.cpuPermille > b.cpuPermille;
+  });
+
+  JsonDocument doc;
+  doc["uptime_s"] = (uint32_t)(millis() / 1000);
+  doc["window_ms"] = windowMs;
+#if configGENERATE_RUN_TIME_STATS
+  doc["runtime_stats"] = true;
+#else
+  doc["runtime_stats"] = false;
+#endif
+  doc["stack_alarm_bytes"] = TASK_STACK_ALARM_BYTES;
+  doc["stack_alarms"] = g_taskStackAlarms;
+  doc["placement"] = taskPlacementString();
+  taskTuneFill(doc.createNestedObject("tune"));
+
+  // Busy share per core = 100% minus that core's IDLE task.
+  JsonArray cores = doc.createNestedArray("cores");
+  for (uint8_t c = 0; c < portNUM_PROCESSORS; c++) {
+    char idle[8];
+    snprintf(idle, sizeof(idle), "IDLE%u", (unsigned)c);
+    uint16_t idlePermille = 1000;
+    for (uint8_t i = 0; i < count; i++) {
+      if (!strcmp(snap[i].name, idle) || (c == 0 && !strcmp(snap[i].name, "IDLE"))) {
+        idlePermille = snap[i].cpuPermille;
+      }
+    }
+    JsonObject o = cores.createNestedObject();
+    o["core"] = c;
+    o["busy_pct"] = (1000 - idlePermille) / 10.0;
+  }
+
+  JsonArray tasks = doc.createNestedArray("tasks");
+  for (uint8_t i = 0; i < count; i++) {
+    const TaskTele &t = snap[i];
+    JsonObject o = tasks.createNestedObject();
+    o["name"] = t.name;
+    if (t.core >= 0) o["core"] = t.core;
+    else o["core"] = nullptr;
+    o["prio"] = t.prio;
+    o["state"] = taskStateName(t.state);
+    o["cpu_pct"] = t.cpuPermille / 10.0;
+    o["stack_free"] = t.stackFree;
+    if (t.stackSize) {
+      o["stack_size"] = t.stackSize;
+      o["stack_used_pct"] = (t.stackSize - std::min(t.stackFree, t.stackSize)) * 100 / t.stackSize;
+    }
+    o["low_stack"] = taskStackLow(t);
+  }
+
+  String out;
+  serializeJson(doc, out);
+  web.sendHeader("Cache-Control", "no-store");
+  web.send(200, "application/json", out);
+}
+
+// -----------------------------
+// Task placement
+// -----------------------------
+// Priorities change in place with vTaskPrioritySet(). A task whose core
+// changed is respawned: miners through minerStop()/minerStart(), the pool and
+// service tasks by creating their replacement on the new core and deleting
+// themselves at the top of their loop, where they hold no locks. ESP-IDF has
+// no call to move a running task, and loopTask is created by the Arduino core,
+// so loop() keeps its core.
+//
+// Every applied change is followed by an automatic before/after comparison:
+// the "before" values are the running averages at the moment of the change,
+// the "after" values are averaged over TASK_TUNE_MEASURE_S once the new
+// layout has settled. "CPU0 lateness" is the yield controller's CPU0 metric:
+// the worse of the IDLE0 gap and the service task's wake-up overshoot per
+// second. It bounds how long a request can sit before WebServer polls, but
+// is not a measured request latency.
+static constexpr uint32_t TASK_TUNE_SETTLE_S = 20;
+static constexpr uint32_t TASK_TUNE_MEASURE_S = 60;
+
+static TaskHandle_t g_loopTask = nullptr;
+
+enum TaskTunePhase : uint8_t { TUNE_IDLE = 0, TUNE_SETTLING, TUNE_MEASURING, TUNE_DONE };
+
+struct TaskTuneCompare {
+  TaskTunePhase phase;
+  uint32_t phaseStartMs;
+  float hsBefore, latBefore;
+  float hsSum, latSum;
+  uint32_t samples;
+  float hsAfter, latAfter;
+  char before[48];
+  char after[48];
+};
+static TaskTuneCompare g_taskTune = {};
+static float g_tuneHsAvg = 0.0f;     // ~30 s EMA, total hashrate
+static float g_tuneLatAvg = 0.0f;    // ~30 s EMA, CPU0 lateness (ms)
+static bool g_tuneAvgValid = false;
+static uint32_t g_tuneLastSampleMs = 0;
+
+// Compact form used for logs and change detection: m<core0><core1>p<prio> ...
+static String taskPlacementString() {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "m%u%up%u pool%up%u svc%up%u loop-p%u",
+           cfg.task_m0_core, cfg.task_m1_core, cfg.task_miner_prio,
+           cfg.task_pool_core, cfg.task_pool_prio,
+           cfg.task_svc_core, cfg.task_svc_prio, cfg.task_loop_prio);
+  return String(buf);
+}
+
+// Starts a copy of the calling task on `target`. Returns true once the copy
+// exists: the caller then returns from its loop, so its locals (Strings, a
+// pinned CfgView) are destroyed, and its task function deletes the task.
+// Returns false (keep running here) if the copy could not be created; the
+// caller remembers the target so it does not retry every iteration.
+static bool taskRespawnSelf(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                            uint8_t prio, uint8_t target, TaskHandle_t *handle) {
+  TaskHandle_t next = nullptr;
+  if (xTaskCreatePinnedToCore(fn, name, stack, arg, prio, &next, target) != pdPASS) {
+    NM_log(String("[NukaMiner] Task ") + name + ": respawn on CPU" + target + " failed, staying on CPU" +
+           (int)xPortGetCoreID());
+    return false;
+  }
+  NM_log(String("[NukaMiner] Task ") + name + " moved to CPU" + target);
+  *handle = next;
+  return true;
+}
+
+static void taskPlacementApply(const String &before) {
+  {
+    MinerLock lock;
+    if (minerTask0) vTaskPrioritySet(minerTask0, cfg.task_miner_prio);
+    if (minerTask1) vTaskPrioritySet(minerTask1, cfg.task_miner_prio);
+  }
+  if (poolTask) vTaskPrioritySet(poolTask, cfg.task_pool_prio);
+  if (serviceTask) vTaskPrioritySet(serviceTask, cfg.task_svc_prio);
+  if (g_loopTask) vTaskPrioritySet(g_loopTask, cfg.task_loop_prio);
+
+  const String after = taskPlacementString();
+  NM_log(String("[NukaMiner] Task placement: ") + before + " -> " + after);
+
+  TaskTuneCompare &t = g_taskTune;
+  t.phase = TUNE_SETTLING;
+  t.phaseStartMs = millis();
+  t.hsBefore = g_tuneAvgValid ? g_tuneHsAvg : 0.0f;
+  t.latBefore = g_tuneAvgValid ? g_tuneLatAvg : 0.0f;
+  t.hsSum = t.latSum = 0.0f;
+  t.samples = 0;
+  t.hsAfter = t.latAfter = 0.0f;
+  strlcpy(t.before, before.c_str(), sizeof(t.before));
+  strlcpy(t.after, after.c_str(), sizeof(t.after));
+}
+
+// Called from loop(); samples once a second.
+static void taskTuneSample() {
+  const uint32_t now = millis();
+  if ((now - g_tuneLastSampleMs) < 1000) return;
+  g_tuneLastSampleMs = now;
+
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  const float hs = (float)minerTotalHashrate(st);
+  const float lat = (float)g_yieldCtl[0].metricMs;
+  if (minerIsRunning() && hs > 0.0f) {
+    if (!g_tuneAvgValid) {
+      g_tuneHsAvg = hs;
+      g_tuneLatAvg = lat;
+      g_tuneAvgValid = true;
+    } else {
+      g_tuneHsAvg += (hs - g_tuneHsAvg) / 30.0f;
+      g_tuneLatAvg += (lat - g_tuneLatAvg) / 30.0f;
+    }
+  }
+
+  TaskTuneCompare &t = g_taskTune;
+  const uint32_t inPhaseS = (now - t.phaseStartMs) / 1000;
+  if (t.phase == TUNE_SETTLING && inPhaseS >= TASK_TUNE_SETTLE_S) {
+    t.phase = TUNE_MEASURING;
+    t.phaseStartMs = now;
+  } else if (t.phase == TUNE_MEASURING) {
+    if (minerIsRunning() && hs > 0.0f) {
+      t.hsSum += hs;
+      t.latSum += lat;
+      t.samples++;
+    }
+    if (inPhaseS >= TASK_TUNE_MEASURE_S) {
+      t.phase = TUNE_DONE;
+      t.hsAfter = t.samples ? t.hsSum / t.samples : 0.0f;
+      t.latAfter = t.samples ? t.latSum / t.samples : 0.0f;
+      const float dPct = (t.hsBefore > 0.0f) ? (t.hsAfter - t.hsBefore) * 100.0f / t.hsBefore : 0.0f;
+      char line[160];
+      snprintf(line, sizeof(line),
+               "[NukaMiner] Task placement result: hashrate %.0f -> %.0f H/s (%+.1f%%), CPU0 lateness %.1f -> %.1f ms",
+               t.hsBefore, t.hsAfter, dPct, t.latBefore, t.latAfter);
+      NM_log(line);
+    }
+  }
+}
+
+static void taskTuneFill(JsonObject o) {
+  static const char *const kPhase[] = {"idle", "settling", "measuring", "done"};
+  const TaskTuneCompare &t = g_taskTune;
+  o["phase"] = kPhase[t.phase];
+  if (t.phase == TUNE_IDLE) return;
+  o["before"] = t.before;
+  o["after"] = t.after;
+  o["hs_before"] = (uint32_t)t.hsBefore;
+  o["cpu0_late_before_ms"] = t.latBefore;
+  if (t.phase == TUNE_DONE) {
+    o["hs_after"] = (uint32_t)t.hsAfter;
+    o["cpu0_late_after_ms"] = t.latAfter;
+    if (t.hsBefore > 0.0f) o["hs_delta_pct"] = (t.hsAfter - t.hsBefore) * 100.0f / t.hsBefore;
+  }
+}
+
+// -----------------------------
+// Thermal governor
+// -----------------------------
+// Samples the internal sensor once a second from loop() and feeds
+// ThermalGovernor, which sets NM_thermal_duty for the miners' limiters. With
+// both miners enabled, "Core 1" (job0, sharing CPU0 with WiFi) is the one
+// parked when lowering the duty alone is not enough: it drops its job and
+// node socket and waits in minerTaskFn() until the governor lets it run.
+static constexpr uint32_t THERMAL_PERIOD_MS = 1000;
+static ThermalGovernor g_thermal;
+static uint32_t g_thermalLastMs = 0;
+static float g_thermalLastC = 0.0f;
+static bool g_thermalWasActive = false;
+static uint8_t g_thermalWorkersLast = 0;
+static uint32_t g_thermalActiveS = 0;   // seconds spent engaged since boot
+
+static float thermalLastC() {
+  // The sensor read is slow on the S3; reuse the governor's sample.
+  if (g_thermalLastMs == 0) g_thermalLastC = temperatureRead();
+  return g_thermalLastC;
+}
+
+static void thermalSample() {
+  const uint32_t now = millis();
+  if (g_thermalLastMs != 0 && (now - g_thermalLastMs) < THERMAL_PERIOD_MS) return;
+  g_thermalLastMs = now;
+  g_thermalLastC = temperatureRead();
+
+  const CfgView c = cfgView();
+  const bool both = c->core1_enabled && c->core2_enabled;
+  ThermalGovernor::Params p = g_thermal.params();
+  p.ceiling_c = c->thermal_max_c;
+  p.hyst_c = c->thermal_hyst_c;
+  p.period_s = THERMAL_PERIOD_MS / 1000.0f;
+  p.workers = both ? 2 : 1;
+  if (p.ceiling_c != g_thermal.params().ceiling_c || p.hyst_c != g_thermal.params().hyst_c ||
+      p.workers != g_thermal.params().workers) {
+    g_thermal.configure(p);
+  }
+
+  const ThermalGovernor::Output &o = g_thermal.update(g_thermalLastC);
+  uint16_t duty = o.active ? o.duty : ThermalGovernor::FULL;
+  const uint16_t profileDuty = powerProfile(c->power_profile).duty;
+  if (duty > profileDuty) duty = profileDuty;
+  const bool parkCore1 = both && o.workers < 2;
+  // A duty of 0 parks the worker in minerTaskFn() with no job and no socket;
+  // wake it so it resumes now rather than on its next poll.
+  const bool unpark = NM_thermal_duty[0] == 0 && !parkCore1;
+  NM_thermal_duty[0] = parkCore1 ? 0 : duty;
+  NM_thermal_duty[1] = duty;
+  if (unpark) minerWake();
+  if (o.active) g_thermalActiveS++;
+
+  if (o.active != g_thermalWasActive) {
+    NM_LOGI("[NukaMiner] Thermal governor %s at %.1f C (limit %u C)", o.active ? "engaged" : "released",
+            (double)g_thermal.filtered(), (unsigned)c->thermal_max_c);
+    g_thermalWasActive = o.active;
+  }
+  if (g_thermalWorkersLast && o.workers != g_thermalWorkersLast) {
+    NM_LOGW("[NukaMiner] Thermal governor %s Core 1 miner at %.1f C", o.workers < g_thermalWorkersLast ? "parked" : "resumed",
+            (double)g_thermal.filtered());
+  }
+  g_thermalWorkersLast = o.workers;
+}
+
+static void thermalFillStatus(JsonDocument &doc) {
+  JsonObject t = doc.createNestedObject("thermal");
+  const ThermalGovernor::Output &o = g_thermal.output();
+  t["limit_c"] = cfg.thermal_max_c;
+  t["filtered_c"] = g_thermal.filtered();
+  t["active"] = o.active;
+  t["duty_pct"] = (o.active ? o.duty : ThermalGovernor::FULL) / 10.0f;
+  t["workers"] = o.workers;
+  t["core1_parked"] = (NM_thermal_duty[0] == 0);
+  t["active_s"] = g_thermalActiveS;
+}
+
+// -----------------------------
+// Power profiles
+// -----------------------------
+// Applies the selected PowerProfile (CPU clock, radio sleep; LCD/LED and
+// miner duty caps are read where they are used) and keeps an estimated
+// energy account per profile so profiles can be compared in hashes per
+// joule. The model is the web UI's calibrated current heuristic, with the
+// CPU-dependent parts scaled by clock and the mining part by achieved duty.
+static constexpr uint32_t POWER_PERIOD_MS = 1000;
+static constexpr float POWER_SUPPLY_V = 5.0f;
+static constexpr float POWER_BASE_MA = 58.0f;          // MCU + regulators at 240 MHz
+static constexpr float POWER_BASE_STATIC_FRAC = 0.55f; // part of the base that does not scale with clock
+static constexpr float POWER_WIFI_MA = 35.0f;          // associated, radio always on
+static constexpr float POWER_WIFI_SLEEP_MA = 12.0f;    // associated, modem sleep between shares
+static constexpr float POWER_WIFI_RSSI_MA = 22.0f;     // extra at -95 dBm (0 at -50 dBm)
+static constexpr float POWER_WEB_MA = 8.0f;            // web UI session active
+static constexpr float POWER_CORE_MA = 20.0f;          // one core mining flat out at 240 MHz
+
+static volatile bool g_powerModemSleep = false;
+static volatile bool g_radioAwake = true;
+static SemaphoreHandle_t g_radioLock = nullptr;   // created in setup()
+static uint8_t g_powerApplied = 0xFF;
+
+struct PowerAccount {
+  uint32_t seconds;
+  double energy_j;
+  double hashes;
+};
+static PowerAccount g_powerAcct[POWER_PROFILE_COUNT];
+static uint32_t g_powerLastMs = 0;
+static float g_powerEstMa = 0.0f;
+
+// loop() (profile changes, WiFi connect) and the service task (miner edges)
+// both set the PS mode; g_radioLock keeps them in order. Miners never take it.
+static void powerRadioApply() {
+  const CfgView c = cfgView();
+  const bool sleep = powerProfile(c->power_profile).modem_sleep;
+  xSemaphoreTake(g_radioLock, portMAX_DELAY);
+  g_powerModemSleep = sleep;
+  // With modem sleep the radio follows the miners' busy mask
+  // (powerRadioService()).
+  g_radioAwake = !sleep || NM_net_busy_mask != 0;
+  WiFi.setSleep(g_radioAwake ? WIFI_PS_NONE : WIFI_PS_MIN_MODEM);
+  xSemaphoreGive(g_radioLock);
+}
+
+// Declared in lib/NukaDuino/src/Settings.h. Called by both miner tasks on
+// every busy/idle edge, after the mask is published. Must not block: the
+// portal suspends miners wherever they are. The service task applies the PS
+// mode; a busy edge wakes it so the radio is up for the node's reply, an idle
+// edge waits for its next pass.
+void NM_radio_busy(uint32_t mask) {
+  if (!g_powerModemSleep || mask == 0 || g_radioAwake) return;
+  xTimerPendFunctionCall(svcWakeFromTimerTask, nullptr, SVC_WAKE_RADIO, 0);
+}
+
+// Service task, every pass: follow NM_net_busy_mask with the PS mode.
+static void powerRadioService() {
+  if (!g_powerModemSleep) return;
+  const bool awake = __atomic_load_n(&NM_net_busy_mask, __ATOMIC_RELAXED) != 0;
+  if (awake == g_radioAwake) return;
+  if (xSemaphoreTake(g_radioLock, 0) != pdTRUE) return;   // loop() is applying; retry next pass
+  if (g_powerModemSleep) {
+    g_radioAwake = awake;
+    esp_wifi_set_ps(awake ? WIFI_PS_NONE : WIFI_PS_MIN_MODEM);
+  }
+  xSemaphoreGive(g_radioLock);
+}
+
+static void powerProfileApply() {
+  const CfgView c = cfgView();
+  const PowerProfile &p = powerProfile(c->power_profile);
+  if (g_powerApplied == c->power_profile) return;
+  const uint32_t before = getCpuFrequencyMhz();
+  if (before != p.cpu_mhz) setCpuFrequencyMhz(p.cpu_mhz);
+  if (WiFi.getMode() != WIFI_OFF) powerRadioApply();
+  else g_powerModemSleep = p.modem_sleep;
+  blSet(c->lcd_brightness);
+  ledApplyNow();
+  g_powerApplied = c->power_profile;
+  NM_LOGI("[NukaMiner] Power profile %s: CPU %lu -> %lu MHz, WiFi %s", p.label, (unsigned long)before,
+          (unsigned long)getCpuFrequencyMhz(), p.modem_sleep ? "modem sleep between shares" : "always on");
+}
+
+// Estimated supply current for the current state (mA).
+static float powerEstimateMa(const AppConfig *c, const MinerStatsSnapshot &st) {
+  const PowerProfile &p = powerProfile(c->power_profile);
+  const float clk = getCpuFrequencyMhz() / 240.0f;
+  float ma = POWER_BASE_MA * (POWER_BASE_STATIC_FRAC + (1.0f - POWER_BASE_STATIC_FRAC) * clk);
+  if (WiFi.isConnected()) {
+    ma += p.modem_sleep ? POWER_WIFI_SLEEP_MA : POWER_WIFI_MA;
+    const int rssi = constrain((int)WiFi.RSSI(), -95, -50);
+    ma += POWER_WIFI_RSSI_MA * (float)(-50 - rssi) / 45.0f;
+  }
+  if (webSessionActive) ma += POWER_WEB_MA;
+  if (c->duino_enabled && minerIsRunning()) {
+    if (c->core1_enabled) ma += POWER_CORE_MA * clk * st.worker[0].duty_permille / 1000.0f;
+    if (c->core2_enabled) ma += POWER_CORE_MA * clk * st.worker[1].duty_permille / 1000.0f;
+  }
+  return ma;
+}
+
+static void powerSample() {
+  const uint32_t now = millis();
+  if (g_powerLastMs == 0) { g_powerLastMs = now; return; }
+  const uint32_t dtMs = now - g_powerLastMs;
+  if (dtMs < POWER_PERIOD_MS) return;
+  g_powerLastMs = now;
+
+  const CfgView c = cfgView();
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  g_powerEstMa = powerEstimateMa(c.operator->(), st);
+  const float dt = dtMs / 1000.0f;
+  PowerAccount &a = g_powerAcct[c->power_profile < POWER_PROFILE_COUNT ? c->power_profile : 0];
+  a.seconds += (dtMs + 500) / 1000;
+  a.energy_j += g_powerEstMa / 1000.0f * POWER_SUPPLY_V * dt;
+  a.hashes += (double)minerTotalHashrate(st) * dt;
+}
+
+static void powerFillStatus(JsonDocument &doc) {
+  JsonObject o = doc.createNestedObject("power");
+  const uint8_t cur = cfg.power_profile < POWER_PROFILE_COUNT ? cfg.power_profile : 0;
+  o["profile"] = kPowerProfiles[cur].key;
+  o["cpu_mhz"] = getCpuFrequencyMhz();
+  o["modem_sleep"] = (bool)g_powerModemSleep;
+  const float w = g_powerEstMa / 1000.0f * POWER_SUPPLY_V;
+  o["est_ma"] = g_powerEstMa;
+  o["est_w"] = w;
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  o["hashes_per_joule"] = (w > 0.0f) ? (float)minerTotalHashrate(st) / w : 0.0f;
+  JsonArray arr = o.createNestedArray("profiles");
+  for (uint8_t i = 0; i < POWER_PROFILE_COUNT; i++) {
+    const PowerAccount &a = g_powerAcct[i];
+    if (!a.seconds) continue;
+    JsonObject p = arr.createNestedObject();
+    p["profile"] = kPowerProfiles[i].key;
+    p["seconds"] = a.seconds;
+    p["energy_j"] = a.energy_j;
+    p["avg_w"] = a.energy_j / a.seconds;
+    p["avg_hs"] = a.hashes / a.seconds;
+    p["hashes_per_joule"] = (a.energy_j > 0.0) ? a.hashes / a.energy_j : 0.0;
   }
 }
 
 // -----------------------------
 // WiFi
 // -----------------------------
-static void wifiConnect() {
+static void wifiOnEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  (void)info;
+  if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED || event == ARDUINO_EVENT_WIFI_STA_LOST_IP) {
+    nmGateSet(NM_GATE_WIFI_UP, false);
+    if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED && wifiDownAtMs == 0) netApNoteDisconnect();
+    if (wifiEverUp && wifiDownAtMs == 0) {
+      const uint32_t now = millis();
+      wifiDownAtMs = now ? now : 1;
+    }
+  } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    nmGateSet(NM_GATE_WIFI_UP, true);
+    bootMark(BOOT_WIFI_UP);
+    wifiEverUp = true;
+    if (wifiDownAtMs == 0) { // first connect after boot, not an outage
+      wifiRoaming = false;
+      return;
+    }
+    const uint32_t ms = millis() - wifiDownAtMs;
+    wifiDownAtMs = 0;
+    uint8_t b = 0;
+    while (b < WIFI_OUTAGE_BUCKETS - 1 && ms >= WIFI_OUTAGE_BOUNDS_MS[b]) b++;
+    wifiOutageHist[b]++;
+    wifiOutageCount++;
+    wifiOutageLastMs = ms;
+    if (ms > wifiOutageMaxMs) wifiOutageMaxMs = ms;
+    // Reconnect attempts are made from loop(); 0 attempts means the driver's
+    // own auto-reconnect got there first.
+    wifiRecoverVia = wifiRoaming ? "roam"
+                   : (wifiReconnectFails == 0) ? "auto"
+                   : (wifiReconnectFails == 1) ? "reconnect"
+                   : (wifiReconnectFails == 2) ? "directed" : "scan";
+    wifiRoaming = false;
+  }
+}
+
+// Remember the AP we are associated with so the next connect can skip the scan.
+// Only writes NVS when something changed.
+static void wifiRememberAp() {
+  String cur = WiFi.SSID();
+  const uint8_t *bssid = WiFi.BSSID();
+  const int32_t ch = WiFi.channel();
+  bool changed = false;
+  if (cur.length() && cur != wifiLastSsid) {
+    wifiLastSsid = cur;
+    changed = true;
+  }
+  if (bssid && ch > 0 && (ch != wifiLastChannel || memcmp(bssid, wifiLastBssid, sizeof(wifiLastBssid)) != 0)) {
+    memcpy(wifiLastBssid, bssid, sizeof(wifiLastBssid));
+    wifiLastChannel = ch;
+    changed = true;
+  }
+  if (changed) wifiProfilesSave();
+}
+
+// Directed connect to the cached BSSID/channel of wifi_last: no scan, and the
+// association only has to probe one channel.
+static bool wifiBeginDirected() {
+  if (wifiLastChannel <= 0 || wifiLastSsid.length() == 0) return false;
+  WifiProfile *p = wifiProfileBySsid(wifiLastSsid);
+  if (!p) return false;
+  Serial.printf("[NukaMiner] WiFi fast connect SSID='%s' ch=%d\n", p->ssid.c_str(), (int)wifiLastChannel);
+  WiFi.begin(p->ssid.c_str(), p->pass.c_str(), wifiLastChannel, wifiLastBssid);
+  return true;
+}
+
+static void wifiConnect(bool tryFast = true) {
   if (!wifiHasAnyConfig()) {
     Serial.println("[NukaMiner] No saved WiFi configuration");
     return;
@@ -4919,7 +7607,20 @@ static void wifiConnect() {
 
   // STA first (normal mode)
   WiFi.mode(WIFI_STA);
-  WiFi.setSleep(false);
+  powerRadioApply();
+
+  // Fast path: same AP as last time. Fall back to the scan below if the AP
+  // moved channel or is gone.
+  if (tryFast && WiFi.status() != WL_CONNECTED && wifiBeginDirected()) {
+    const uint32_t t0 = millis();
+    while (WiFi.status() != WL_CONNECTED && (uint32_t)(millis() - t0) < 4000) delay(50);
+    if (WiFi.status() == WL_CONNECTED) {
+      Serial.printf("[NukaMiner] WiFi fast connect OK in %lu ms\n", (unsigned long)(millis() - t0));
+      return;
+    }
+    Serial.println("[NukaMiner] WiFi fast connect failed, scanning");
+    WiFi.disconnect(false, false);
+  }
 
   // Decide what to connect to:
   //  1) Prefer the highest-priority *visible* saved profile (tie-break: RSSI).
@@ -4983,53 +7684,156 @@ static void wifiConnect() {
 
   // Legacy fallback.
   if (!chosen) {
-    Serial.printf("[NukaMiner] WiFi begin (legacy) SSID='%s'\n", cfg.wifi_ssid.c_str());
-    WiFi.begin(cfg.wifi_ssid.c_str(), cfg.wifi_pass.c_str());
+    const CfgView c = cfgView();
+    Serial.printf("[NukaMiner] WiFi begin (legacy) SSID='%s'\n", c->wifi_ssid.c_str());
+    WiFi.begin(c->wifi_ssid.c_str(), c->wifi_pass.c_str());
     return;
   }
 
-  // Mirror into cfg fields for UI/backups.
-  cfg.wifi_ssid = chosen->ssid;
-  cfg.wifi_pass = chosen->pass;
+  // Mirror into cfg fields for UI/backups (applied by the service task).
+  cfgRequestWifiMirror(chosen->ssid, chosen->pass);
 
   Serial.printf("[NukaMiner] WiFi begin SSID='%s' (prio=%d)\n", chosen->ssid.c_str(), (int)chosen->prio);
   WiFi.begin(chosen->ssid.c_str(), chosen->pass.c_str());
 }
 
-static void maybeStartPortalIfNeeded() {
-  // If no saved WiFi, start AP portal immediately.
-  if (!wifiHasAnyConfig()) {
-    Serial.println("[NukaMiner] Starting portal (no WiFi configured)");
-    portalStart(true);
+// -----------------------------
+// Background roaming
+// -----------------------------
+// Profiles are otherwise only evaluated at connect time. While connected, sweep
+// one channel at a time (short async scans, spaced out, never while a miner is
+// talking to its node) and remember the best saved-network AP. Roam only when
+// it beats the current AP by a hysteresis margin (or belongs to a
+// higher-priority profile) on two consecutive sweeps.
+static constexpr uint32_t ROAM_SWEEP_INTERVAL_MS = 180000;
+static constexpr uint32_t ROAM_CHANNEL_GAP_MS    = 1500;
+static constexpr uint16_t ROAM_DWELL_MS          = 80;
+static constexpr uint8_t  ROAM_MAX_CHANNEL       = 13;
+static constexpr int      ROAM_GOOD_RSSI         = -55; // don't bother above this
+static constexpr int      ROAM_HYSTERESIS_DB     = 8;
+static constexpr int      ROAM_MIN_RSSI          = -78; // never roam to worse than this
+static constexpr uint8_t  ROAM_CONFIRM_SWEEPS    = 2;
+
+static uint8_t  roamChan = 0;          // 0 = idle, else channel being scanned
+static bool     roamScanActive = false;
+static uint32_t roamNextMs = 60000;
+static String   roamBestSsid;
+static uint8_t  roamBestBssid[6];
+static int32_t  roamBestCh = 0;
+static int      roamBestRssi = -9999;
+static int      roamBestPrio = -32768;
+static uint8_t  roamConfirmBssid[6];
+static uint8_t  roamConfirmHits = 0;
+static bool     roamPending = false;
+
+static void roamAbortSweep() {
+  if (roamScanActive) WiFi.scanDelete();
+  roamScanActive = false;
+  roamChan = 0;
+}
+
+static void roamCollectResults(int n) {
+  const uint8_t *curBssid = WiFi.BSSID();
+  for (int i = 0; i < n; i++) {
+    const uint8_t *b = WiFi.BSSID(i);
+    if (!b || (curBssid && memcmp(b, curBssid, 6) == 0)) continue;
+    WifiProfile *p = wifiProfileBySsid(WiFi.SSID(i));
+    if (!p) continue;
+    const int r = WiFi.RSSI(i);
+    netApSample(b, WiFi.channel(i), p->ssid, r);
+    if (r < ROAM_MIN_RSSI) continue;
+    if (p->prio > roamBestPrio || (p->prio == roamBestPrio && r > roamBestRssi)) {
+      roamBestSsid = p->ssid;
+      memcpy(roamBestBssid, b, 6);
+      roamBestCh = WiFi.channel(i);
+      roamBestRssi = r;
+      roamBestPrio = p->prio;
+    }
+  }
+}
+
+static void roamEvaluateSweep() {
+  wifiRoamSweeps++;
+  WifiProfile *cur = wifiProfileBySsid(WiFi.SSID());
+  const int curPrio = cur ? cur->prio : -32768;
+  const int curRssi = WiFi.RSSI();
+  const bool better = roamBestSsid.length() &&
+      (roamBestPrio > curPrio || (roamBestPrio == curPrio && roamBestRssi >= curRssi + ROAM_HYSTERESIS_DB));
+  if (!better) { roamConfirmHits = 0; return; }
+  if (roamConfirmHits && memcmp(roamConfirmBssid, roamBestBssid, 6) == 0) {
+    roamConfirmHits++;
+  } else {
+    memcpy(roamConfirmBssid, roamBestBssid, 6);
+    roamConfirmHits = 1;
+  }
+  if (roamConfirmHits >= ROAM_CONFIRM_SWEEPS) {
+    roamPending = true;
+    wifiRoamLastGainDb = roamBestRssi - curRssi;
+  }
+}
+
+static void wifiRoamService() {
+  const CfgView c = cfgView();
+  const uint32_t now = millis();
+  if (!c->wifi_roam || portalRunning || sdBusy || WiFi.getMode() != WIFI_STA || !WiFi.isConnected()) {
+    roamAbortSweep();
+    roamPending = false;
     return;
   }
 
-  // Give STA a fair chance. DHCP + association can take >15s on some networks.
-  const uint32_t connectWindowMs = 45000;
-  uint32_t start = millis();
-  uint32_t lastPrint = 0;
-  while (!WiFi.isConnected() && millis() - start < connectWindowMs) {
-    if (millis() - lastPrint > 1000) {
-      lastPrint = millis();
-      wl_status_t st = WiFi.status();
-      Serial.printf("[NukaMiner] WiFi status=%d\n", (int)st);
-    }
-    handleButton();
-    portalLoop();
-    delay(50);
+  // Never go off-channel or drop the link while a miner waits on its node.
+  if (NM_net_busy_mask != 0) return;
+
+  if (roamPending) {
+    roamPending = false;
+    roamConfirmHits = 0;
+    WifiProfile *p = wifiProfileBySsid(roamBestSsid);
+    if (!p) return;
+    NM_log(String("[NukaMiner] WiFi roaming to ") + p->ssid + " ch" + String(roamBestCh) +
+           " (" + String(roamBestRssi) + " dBm, +" + String(wifiRoamLastGainDb) + " dB)");
+    wifiRoaming = true;
+    wifiRoamCount++;
+    WiFi.begin(p->ssid.c_str(), p->pass.c_str(), roamBestCh, roamBestBssid);
+    roamNextMs = now + ROAM_SWEEP_INTERVAL_MS;
+    return;
   }
 
-  if (WiFi.isConnected()) {
-    Serial.printf("[NukaMiner] WiFi connected: %s\n", WiFi.localIP().toString().c_str());
+  if (roamScanActive) {
+    const int n = WiFi.scanComplete();
+    if (n == WIFI_SCAN_RUNNING) return;
+    roamScanActive = false;
+    if (n < 0) { roamAbortSweep(); roamNextMs = now + ROAM_SWEEP_INTERVAL_MS; return; }
+    roamCollectResults(n);
+    WiFi.scanDelete();
+    if (++roamChan > ROAM_MAX_CHANNEL) {
+      roamChan = 0;
+      roamEvaluateSweep();
+      roamNextMs = now + ROAM_SWEEP_INTERVAL_MS + (esp_random() % 30000);
+    } else {
+      roamNextMs = now + ROAM_CHANNEL_GAP_MS;
+    }
     return;
   }
 
-  // Could not connect. Start portal as AP+STA so user can fix settings,
-  // but keep trying to connect in the background.
-  Serial.println("[NukaMiner] WiFi not connected - starting portal (AP+STA fallback)");
-  WiFi.mode(WIFI_AP_STA);
-  if (cfg.wifi_ssid.length()) WiFi.begin(cfg.wifi_ssid.c_str(), cfg.wifi_pass.c_str());
-  portalStart(true);
+  if ((int32_t)(now - roamNextMs) < 0) return;
+
+  if (roamChan == 0) {
+    // Strong link and nothing preferred elsewhere: skip the sweep entirely.
+    if (WiFi.RSSI() >= ROAM_GOOD_RSSI && wifiProfiles.size() <= 1) {
+      roamNextMs = now + ROAM_SWEEP_INTERVAL_MS;
+      return;
+    }
+    roamChan = 1;
+    roamBestSsid = "";
+    roamBestRssi = -9999;
+    roamBestPrio = -32768;
+  }
+  if (WiFi.scanNetworks(/*async=*/true, /*show_hidden=*/false, /*passive=*/false, ROAM_DWELL_MS, roamChan) == WIFI_SCAN_FAILED) {
+    roamAbortSweep();
+    roamNextMs = now + ROAM_SWEEP_INTERVAL_MS;
+    return;
+  }
+  roamScanActive = true;
 }
 
 static void portalStop() {
@@ -5039,25 +7843,890 @@ static void portalStop() {
   // Turn off AP to reduce interference once STA is up.
   WiFi.softAPdisconnect(true);
 
-  // Restore the user's Web UI setting if we force-enabled it for portal recovery.
-  if (portalForcedWeb) {
-    cfg.web_enabled = webEnabledBeforePortal;
-    portalForcedWeb = false;
-  }
+  // Back to the user's Web UI setting.
+  portalForcedWeb = false;
 
   portalRunning = false;
+  nmGateSet(NM_GATE_NO_PORTAL, true);
   portalAuto = false;
   // Resume miner tasks that were suspended for AP/Portal mode.
   minerResumeAfterPortal();
   Serial.println("[NukaMiner] Portal stopped");
 }
 
+// -----------------------------
+// Health supervisor
+// -----------------------------
+// Watches the miners and the system once a second and recovers with the
+// smallest step that can help, escalating only when a step did not:
+//   1. restart the affected worker (fresh job, socket and task)
+//   2. reset the node sockets and re-resolve the pool
+//   3. reset WiFi (radio off/on, full reconnect)
+//   4. reboot
+// Each action is logged together with its measured outcome once the settle
+// time has passed. A problem that stays away for HEALTH_CALM_MS drops the
+// ladder back to the bottom.
+//
+// Signals:
+// - worker hashrate against its own baseline, normalised by limiter duty and
+//   CPU clock so throttling and power profiles do not look like faults;
+// - workers that should be hashing but have not published for a while;
+// - free heap and largest free block (lwIP/TLS need contiguous buffers);
+// - heartbeats of the service and pool tasks;
+// - share reject rate;
+// - WiFi that the reconnect watchdog in loop() could not bring back.
+enum HealthStep : uint8_t {
+  HEALTH_NONE = 0,
+  HEALTH_RESTART_WORKER,
+  HEALTH_RESET_SOCKET,
+  HEALTH_RESET_WIFI,
+  HEALTH_REBOOT,
+  HEALTH_STEPS
+};
+enum HealthIssue : uint8_t {
+  HI_NONE = 0,
+  HI_WORKER_SLOW,
+  HI_WORKER_STALLED,
+  HI_REJECTS,
+  HI_HEAP,
+  HI_TASK_STUCK,
+  HI_WIFI_DOWN,
+  HI_COUNT
+};
+static const char *const kHealthStepNames[HEALTH_STEPS] = {"none", "restart_worker", "reset_socket", "reset_wifi", "reboot"};
+static const char *const kHealthIssueNames[HI_COUNT] = {"none", "worker_slow", "worker_stalled", "rejects", "heap", "task_stuck", "wifi_down"};
+// First and last step worth trying per issue. Rejects come from the node or
+// the account, so neither a WiFi reset nor a reboot would help.
+static const uint8_t kHealthFirstStep[HI_COUNT] = {HEALTH_NONE, HEALTH_RESTART_WORKER, HEALTH_RESTART_WORKER, HEALTH_RESET_SOCKET,
+                                                   HEALTH_RESET_SOCKET, HEALTH_REBOOT, HEALTH_RESET_WIFI};
+static const uint8_t kHealthLastStep[HI_COUNT] = {HEALTH_NONE, HEALTH_REBOOT, HEALTH_REBOOT, HEALTH_RESET_SOCKET,
+                                                  HEALTH_REBOOT, HEALTH_REBOOT, HEALTH_REBOOT};
+static const uint32_t kHealthSettleMs[HEALTH_STEPS] = {0, 90000, 90000, 120000, 0};
+
+static constexpr uint32_t HEALTH_PERIOD_MS = 1000;
+static constexpr uint32_t HEALTH_GRACE_MS = 120000;        // after boot / gates opening
+static constexpr uint32_t HEALTH_CALM_MS = 600000;         // healthy this long: ladder resets
+static constexpr uint32_t HEALTH_REBOOT_MIN_UPTIME_MS = 1800000; // no reboot loops
+static constexpr uint32_t HEALTH_STALL_MS = 300000;        // no share / publish from a worker
+static constexpr uint8_t HEALTH_SLOW_PCT = 60;             // of the baseline
+static constexpr uint8_t HEALTH_SLOW_SHARES = 5;           // consecutive slow shares
+static constexpr float HEALTH_BASE_ALPHA = 0.05f;
+static constexpr uint8_t HEALTH_BASE_MIN_SHARES = 5;
+static constexpr uint32_t HEALTH_HEAP_MIN = 24 * 1024;
+static constexpr uint32_t HEALTH_BLOCK_MIN = 12 * 1024;
+static constexpr uint32_t HEALTH_HEAP_HOLD_MS = 30000;
+static constexpr uint32_t HEALTH_SVC_STUCK_MS = 60000;
+static constexpr uint32_t HEALTH_POOL_STUCK_MS = 180000;
+static constexpr uint8_t HEALTH_REJECT_WINDOW = 20;        // shares
+static constexpr uint8_t HEALTH_REJECT_PCT = 50;
+static constexpr uint32_t HEALTH_WIFI_DOWN_MS = 60000;
+
+struct HealthWorker {
+  float baseline;         // H/s per 1000 permille duty at 240 MHz
+  float last;             // same, last share
+  uint32_t lastShares;
+  uint32_t lastUpdatedMs;
+  uint32_t progressMs;    // last time the worker published
+  uint8_t learned;        // healthy shares folded into the baseline
+  uint8_t slowRun;        // consecutive slow shares
+};
+
+struct HealthState {
+  HealthWorker w[NM_STATS_WORKERS];
+  uint8_t step;           // last step taken (HEALTH_NONE = ladder at rest)
+  uint8_t issue;          // issue that step was for
+  uint8_t worker;         // worker it was for (worker issues)
+  uint32_t actionMs;      // when it was taken
+  uint32_t healthyMs;     // last sample without any issue
+  uint32_t gatesOpenMs;   // miner gates open since
+  uint32_t heapLowMs;     // heap below thresholds since (0 = fine)
+  uint32_t wifiDownMs;    // WiFi down since (0 = up)
+  uint32_t rejShares, rejAccepted;  // window start
+  uint8_t rejPct;         // last completed window
+  uint32_t actions[HEALTH_STEPS];
+  uint32_t recovered[HEALTH_STEPS];
+  char lastAction[96];
+  char lastOutcome[96];
+};
+static HealthState g_health = {};
+static uint32_t g_healthLastMs = 0;
+
+static float healthNormRate(const MinerStatsData &d) {
+  if (!d.hashrate || !d.duty_permille) return 0.0f;
+  const uint32_t mhz = getCpuFrequencyMhz();
+  return (float)d.hashrate * (1000.0f / d.duty_permille) * (240.0f / (mhz ? mhz : 240));
+}
+
+// Worker w is expected to produce shares right now.
+static bool healthWorkerWanted(const AppConfig *c, uint8_t w) {
+  if (!(w ? c->core2_enabled : c->core1_enabled)) return false;
+  if (!(w ? minerTask1 : minerTask0)) return false;
+  const uint8_t lim = w ? c->core2_hash_limit_pct : c->hash_limit_pct;
+  return lim > 0 && NM_thermal_duty[w] > 0;
+}
+
+// Finds the most pressing current issue; fills worker for worker issues.
+static uint8_t healthDetect(const AppConfig *c, uint32_t now, uint8_t &worker) {
+  HealthState &h = g_health;
+  worker = 0;
+
+  // WiFi the reconnect watchdog gave up on (it escalates on its own first).
+  if (!portalRunning && wifiHasAnyConfig() && !WiFi.isConnected()) {
+    if (!h.wifiDownMs) h.wifiDownMs = now;
+    if ((uint32_t)(now - h.wifiDownMs) >= HEALTH_WIFI_DOWN_MS && wifiReconnectFails >= 5) return HI_WIFI_DOWN;
+  } else {
+    h.wifiDownMs = 0;
+  }
+
+  // Stuck system tasks. SD transfers and firmware uploads legitimately hold
+  // the service task.
+  if (serviceTask && !sdBusy && !Update.isRunning() && g_svcBeatMs && (uint32_t)(now - g_svcBeatMs) >= HEALTH_SVC_STUCK_MS) return HI_TASK_STUCK;
+  if (poolTask && g_poolBeatMs && (uint32_t)(now - g_poolBeatMs) >= HEALTH_POOL_STUCK_MS) return HI_TASK_STUCK;
+
+  // Heap: sustained low free heap or fragmentation.
+  const uint32_t freeHeap = ESP.getFreeHeap();
+  const uint32_t block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  if (freeHeap < HEALTH_HEAP_MIN || block < HEALTH_BLOCK_MIN) {
+    if (!h.heapLowMs) h.heapLowMs = now;
+    if ((uint32_t)(now - h.heapLowMs) >= HEALTH_HEAP_HOLD_MS) return HI_HEAP;
+  } else {
+    h.heapLowMs = 0;
+  }
+
+  // The miner checks below only make sense while mining may proceed.
+  const bool gatesOpen = minerIsRunning() && g_gates &&
+                         (xEventGroupGetBits(g_gates) & NM_GATES_MINER) == NM_GATES_MINER;
+  if (!gatesOpen) {
+    h.gatesOpenMs = 0;
+    return HI_NONE;
+  }
+  if (!h.gatesOpenMs) h.gatesOpenMs = now;
+  const bool settled = (uint32_t)(now - h.gatesOpenMs) >= HEALTH_GRACE_MS;
+
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  uint8_t found = HI_NONE;
+  for (uint8_t i = 0; i < NM_STATS_WORKERS; i++) {
+    HealthWorker &hw = h.w[i];
+    const MinerStatsData &d = st.worker[i];
+    if (d.updated_ms != hw.lastUpdatedMs) {
+      hw.lastUpdatedMs = d.updated_ms;
+      hw.progressMs = now;
+    }
+    if (!healthWorkerWanted(c, i)) {
+      hw.progressMs = now;
+      hw.slowRun = 0;
+      continue;
+    }
+    if (!hw.progressMs) hw.progressMs = now;
+
+    // New share: compare with the baseline, then learn from healthy ones.
+    if (d.shares != hw.lastShares) {
+      hw.lastShares = d.shares;
+      const float r = healthNormRate(d);
+      hw.last = r;
+      if (r > 0.0f) {
+        if (hw.learned >= HEALTH_BASE_MIN_SHARES && r < hw.baseline * (HEALTH_SLOW_PCT / 100.0f)) {
+          if (hw.slowRun < 255) hw.slowRun++;
+        } else {
+          hw.slowRun = 0;
+          hw.baseline = hw.learned ? hw.baseline + HEALTH_BASE_ALPHA * (r - hw.baseline) : r;
+          if (hw.learned < 255) hw.learned++;
+        }
+      }
+    }
+    if (!settled || found != HI_NONE) continue;
+    if ((uint32_t)(now - hw.progressMs) >= HEALTH_STALL_MS) { found = HI_WORKER_STALLED; worker = i; }
+    else if (hw.slowRun >= HEALTH_SLOW_SHARES) { found = HI_WORKER_SLOW; worker = i; }
+  }
+  if (found != HI_NONE) return found;
+
+  // Reject rate over windows of HEALTH_REJECT_WINDOW shares.
+  if (st.shares < h.rejShares || st.accepted < h.rejAccepted) { h.rejShares = st.shares; h.rejAccepted = st.accepted; }
+  const uint32_t dShares = st.shares - h.rejShares;
+  if (dShares >= HEALTH_REJECT_WINDOW) {
+    const uint32_t dAcc = st.accepted - h.rejAccepted;
+    h.rejPct = (uint8_t)(100 - std::min<uint32_t>(100, dAcc * 100 / dShares));
+    h.rejShares = st.shares;
+    h.rejAccepted = st.accepted;
+  }
+  if (h.rejPct >= HEALTH_REJECT_PCT) return HI_REJECTS;
+  return HI_NONE;
+}
+
+static void healthResetWifi() {
+  WiFi.disconnect(true, true);
+  WiFi.mode(WIFI_OFF);
+  delay(200);
+  wifiReconnectFails = 0;
+  wifiConnect(/*tryFast=*/false);
+}
+
+static void healthAct(uint8_t step, uint8_t issue, uint8_t worker, uint32_t now) {
+  HealthState &h = g_health;
+  h.step = step;
+  h.issue = issue;
+  h.worker = worker;
+  h.actionMs = now;
+  h.actions[step]++;
+  const bool workerIssue = issue == HI_WORKER_SLOW || issue == HI_WORKER_STALLED;
+  snprintf(h.lastAction, sizeof(h.lastAction), "%s%s%s: %s", kHealthIssueNames[issue],
+           workerIssue ? " core " : "", workerIssue ? (worker ? "2" : "1") : "", kHealthStepNames[step]);
+  NM_LOGW("[Health] %s (heap %lu, largest block %lu)", h.lastAction, (unsigned long)ESP.getFreeHeap(),
+          (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+  switch (step) {
+    case HEALTH_RESTART_WORKER:
+      // The worker restarts itself once it leaves mine(); a stall it cannot
+      // leave shows up again and escalates.
+      if (!minerRestartWorker(worker)) NM_LOGW("[Health] Core %u miner is not running", (unsigned)(worker + 1));
+      h.w[worker].slowRun = 0;
+      h.w[worker].progressMs = now;
+      break;
+    case HEALTH_RESET_SOCKET: {
+      MinerLock lock;
+      if (ducoJob0) ducoJob0->requestReconnect();
+      if (ducoJob1) ducoJob1->requestReconnect();
+    }
+      poolInvalidateReq = true;
+      for (uint8_t i = 0; i < NM_STATS_WORKERS; i++) { h.w[i].slowRun = 0; h.w[i].progressMs = now; }
+      h.rejPct = 0;
+      break;
+    case HEALTH_RESET_WIFI:
+      healthResetWifi();
+      break;
+    case HEALTH_REBOOT:
+      NM_log("[Health] Rebooting");
+      delay(200);
+      ESP.restart();
+      break;
+    default:
+      break;
+  }
+}
+
+static void healthSample() {
+  const uint32_t now = millis();
+  if ((uint32_t)(now - g_healthLastMs) < HEALTH_PERIOD_MS) return;
+  g_healthLastMs = now;
+  HealthState &h = g_health;
+  if (now < HEALTH_GRACE_MS || portalRunning || deviceControlMode) return;
+
+  const CfgView c = cfgView();
+  uint8_t worker = 0;
+  const uint8_t issue = healthDetect(c.operator->(), now, worker);
+  if (issue == HI_NONE) {
+    h.healthyMs = now;
+    if (h.step != HEALTH_NONE && !h.lastOutcome[0]) {
+      // The problem the last step was for is gone.
+      h.recovered[h.step]++;
+      snprintf(h.lastOutcome, sizeof(h.lastOutcome), "%s: recovered after %lu s", h.lastAction,
+               (unsigned long)((now - h.actionMs) / 1000));
+      NM_LOGI("[Health] %s", h.lastOutcome);
+    }
+    if (h.step != HEALTH_NONE && (uint32_t)(now - h.actionMs) >= HEALTH_CALM_MS) h.step = HEALTH_NONE;
+    return;
+  }
+
+  // Give the last step time to work before judging it.
+  if (h.step != HEALTH_NONE && (uint32_t)(now - h.actionMs) < kHealthSettleMs[h.step]) return;
+
+  uint8_t next = kHealthFirstStep[issue];
+  if (h.step != HEALTH_NONE) {
+    if (!h.lastOutcome[0]) {
+      snprintf(h.lastOutcome, sizeof(h.lastOutcome), "%s: no effect, now %s", h.lastAction, kHealthIssueNames[issue]);
+      NM_LOGW("[Health] %s", h.lastOutcome);
+    }
+    if (h.step + 1 > next) next = h.step + 1;
+  }
+  if (next > kHealthLastStep[issue]) next = kHealthLastStep[issue];
+  if (next == HEALTH_REBOOT) {
+    if (now < HEALTH_REBOOT_MIN_UPTIME_MS && issue != HI_TASK_STUCK) next = HEALTH_RESET_WIFI;
+    // WiFi down while not mining is not worth a reboot (old watchdog rule).
+    if (issue == HI_WIFI_DOWN && !(c->duino_enabled && minerIsRunning())) next = HEALTH_RESET_WIFI;
+  }
+  // Nothing further that could help (yet): repeat the step, but slowly.
+  if (h.step != HEALTH_NONE && next <= h.step && (uint32_t)(now - h.actionMs) < HEALTH_CALM_MS) return;
+  h.lastOutcome[0] = 0;
+  healthAct(next, issue, worker, now);
+}
+
+static void healthFillStatus(JsonDocument &doc) {
+  const HealthState &h = g_health;
+  JsonObject o = doc.createNestedObject("health");
+  o["step"] = kHealthStepNames[h.step];
+  o["issue"] = kHealthIssueNames[h.step ? h.issue : HI_NONE];
+  o["last_action"] = h.lastAction;
+  o["last_outcome"] = h.lastOutcome;
+  o["last_action_age_s"] = h.actionMs ? (millis() - h.actionMs) / 1000 : 0;
+  o["reject_pct"] = h.rejPct;
+  JsonArray base = o.createNestedArray("baseline_hs");
+  JsonArray rel = o.createNestedArray("rate_pct");
+  for (uint8_t i = 0; i < NM_STATS_WORKERS; i++) {
+    base.add((uint32_t)h.w[i].baseline);
+    rel.add(h.w[i].baseline > 0.0f ? (uint32_t)(100.0f * h.w[i].last / h.w[i].baseline) : 0);
+  }
+  JsonObject acts = o.createNestedObject("actions");
+  JsonObject recs = o.createNestedObject("recovered");
+  for (uint8_t s = HEALTH_RESTART_WORKER; s < HEALTH_STEPS; s++) {
+    acts[kHealthStepNames[s]] = h.actions[s];
+    recs[kHealthStepNames[s]] = h.recovered[s];
+  }
+}
+
+// -----------------------------
+// Tracing
+// -----------------------------
+// Spans from lib/NukaDuino/src/Trace.h: mine() phases, web requests, LCD
+// redraws and SD I/O. /trace.json downloads them as Chrome trace JSON (open
+// in ui.perfetto.dev or chrome://tracing); POST action=start|stop|free|sd
+// controls the recorder.
+#ifdef NM_TRACE
+// Web spans are named after a fixed set of route groups, so arbitrary URIs
+// (captive-portal probes, typos, query variants) cannot fill the name table.
+struct TraceRoute {
+  const char *prefix;
+  const char *name;
+};
+static const TraceRoute kTraceRoutes[] = {
+  {"/status", "status"},  {"/net.json", "status"},  {"/tasks.json", "status"}, {"/boot.json", "status"},
+  {"/crash.json", "status"}, {"/lcd", "lcd"},       {"/files", "files"},       {"/logs.json", "logs"},
+  {"/events.bin", "logs"}, {"/console", "console"},  {"/config", "config"},     {"/save", "config"},
+  {"/settings", "config"}, {"/wifi", "wifi"},        {"/backup", "backup"},     {"/restore", "backup"},
+  {"/update", "update"},   {"/trace.json", "trace"}, {"/profile", "profile"},   {"/miner", "miner"},
+  {"/pool", "miner"},      {"/duco_gid", "miner"},
+};
+
+static const char *g_traceWebRoute = nullptr;   // route group of the request being served
+
+static const char *traceRouteName(const String &uri) {
+  if (uri == "/") return "root";
+  for (const TraceRoute &r : kTraceRoutes) {
+    if (uri.startsWith(r.prefix)) return r.name;
+  }
+  return "other";
+}
+
+// Registered before every other handler: WebServer asks it first for each
+// request, which tells the span below that a request was actually served.
+class TraceRouteTap : public RequestHandler {
+public:
+  bool canHandle(HTTPMethod, String uri) override {
+    g_traceWebRoute = traceRouteName(uri);
+    return false;
+  }
+  bool canUpload(String uri) override {
+    g_traceWebRoute = traceRouteName(uri);
+    return false;
+  }
+};
+
+static void traceWebRegister() {
+  web.addHandler(new TraceRouteTap());
+}
+
+static void traceWebSpan(uint32_t t0) {
+  const char *route = g_traceWebRoute;
+  g_traceWebRoute = nullptr;
+  if (t0 == NM_TRACE_NONE || !route || !NM_trace_on) return;
+  NM_trace_span(NM_TC_WEB, NM_trace_intern(route), t0);
+}
+#endif
+
+static void traceFillInfo(JsonDocument &doc) {
+  NMTraceInfo ti;
+  NM_trace_info(ti);
+#ifdef NM_TRACE
+  doc["compiled"] = true;
+#else
+  doc["compiled"] = false;
+#endif
+  doc["on"] = ti.on;
+  doc["capacity"] = ti.capacity;
+  doc["recorded"] = ti.recorded;
+  doc["kept"] = ti.recorded < ti.capacity ? ti.recorded : ti.capacity;
+  doc["span_ms"] = ti.span_us / 1000;
+}
+
+// Write the ring to SD; recording is paused meanwhile.
+static bool traceSaveToSd(String &path) {
+  if (!sdBegin()) return false;
+  path = String("/trace-") + String(millis() / 1000) + ".json";
+  File f = SD_MMC.open(path.c_str(), FILE_WRITE);
+  if (!f) return false;
+  const bool was = NM_trace_on;
+  NM_trace_on = false;
+  static char chunk[1024];
+  NMTraceCursor cur = {};
+  bool ok = true;
+  for (size_t n; (n = NM_trace_dump(cur, chunk, sizeof(chunk))) != 0;) {
+    if (f.write((const uint8_t *)chunk, n) != n) { ok = false; break; }
+  }
+  f.close();
+  NM_trace_on = was;
+  return ok;
+}
+
+static void webHandleTraceJson() {
+  if (!requireAuthOrPortal()) return;
+  if (web.method() == HTTP_POST) {
+    const String action = web.arg("action");
+    JsonDocument doc;
+    if (action == "start") {
+      const long ev = web.hasArg("events") ? web.arg("events").toInt() : NM_TRACE_DEFAULT_EVENTS;
+      doc["ok"] = NM_trace_start((uint16_t)constrain(ev, 0L, (long)NM_TRACE_MAX_EVENTS));
+    } else if (action == "stop") {
+      NM_trace_stop();
+    } else if (action == "free") {
+      doc["ok"] = NM_trace_free();
+    } else if (action == "sd") {
+      String path;
+      doc["ok"] = traceSaveToSd(path);
+      doc["path"] = path;
+    }
+    traceFillInfo(doc);
+    String out;
+    serializeJson(doc, out);
+    web.send(200, "application/json", out);
+    return;
+  }
+
+  // Download: pause recording so the ring holds still while it streams.
+  const bool was = NM_trace_on;
+  NM_trace_on = false;
+  static char chunk[1024];
+  web.sendHeader("Content-Disposition", "attachment; filename=\"nukaminer-trace.json\"");
+  web.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  web.send(200, "application/json", "");
+  NMTraceCursor cur = {};
+  for (size_t n; (n = NM_trace_dump(cur, chunk, sizeof(chunk))) != 0;) {
+    web.sendContent(chunk, n);
+  }
+  web.sendContent("");
+  NM_trace_on = was;
+}
+
+// -----------------------------
+// CPU profiler
+// -----------------------------
+// PC sampler from lib/NukaDuino/src/Profiler.h. GET /profile reports its
+// state, GET /profile?download=1 returns the sample file for
+// tools/nm_profile.py, POST action=start|stop|free controls it.
+static void profFillInfo(JsonDocument &doc) {
+  NMProfInfo pi;
+  NM_prof_info(pi);
+  doc["compiled"] = pi.compiled;
+  doc["on"] = pi.on;
+  doc["hz"] = pi.hz;
+  doc["depth"] = pi.depth;
+  doc["slots"] = pi.slots;
+  doc["stacks"] = pi.stacks;
+  doc["samples"] = pi.samples;
+  doc["dropped"] = pi.dropped;
+  doc["duration_ms"] = pi.duration_ms;
+}
+
+static void webHandleProfile() {
+  if (!requireAuthOrPortal()) return;
+  if (web.method() == HTTP_GET && web.arg("download") == "1") {
+    static uint8_t chunk[1024];
+    web.sendHeader("Content-Disposition", "attachment; filename=\"nukaminer-profile.bin\"");
+    web.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    web.send(200, "application/octet-stream", "");
+    NMProfCursor cur = {};
+    for (size_t n; (n = NM_prof_dump(cur, chunk, sizeof(chunk))) != 0;) {
+      web.sendContent((const char *)chunk, n);
+    }
+    web.sendContent("");
+    return;
+  }
+  JsonDocument doc;
+  if (web.method() == HTTP_POST) {
+    const String action = web.arg("action");
+    if (action == "start") {
+      const long hz = web.hasArg("hz") ? web.arg("hz").toInt() : NM_PROF_DEFAULT_HZ;
+      const long depth = web.hasArg("depth") ? web.arg("depth").toInt() : 6;
+      const long slots = web.hasArg("slots") ? web.arg("slots").toInt() : NM_PROF_DEFAULT_SLOTS;
+      doc["ok"] = NM_prof_start((uint16_t)constrain(hz, 0L, 1000L), (uint8_t)constrain(depth, 0L, (long)NM_PROF_MAX_DEPTH),
+                                (uint16_t)constrain(slots, 0L, 2048L));
+    } else if (action == "stop") {
+      NM_prof_stop();
+    } else if (action == "free") {
+      doc["ok"] = NM_prof_free();
+    }
+  }
+  profFillInfo(doc);
+  String out;
+  serializeJson(doc, out);
+  web.send(200, "application/json", out);
+}
+
+// -----------------------------
+// Boot sequence
+// -----------------------------
+// setup() only does what mining needs before the radio is up. The LCD is
+// initialised on CPU0 while loopTask loads the settings and starts WiFi. The
+// miner and pool tasks wait on their run gates, so they start hashing the
+// moment an IP arrives. WiFi itself is driven from loop(): directed connect,
+// then a scan, then the portal. The SD card is still mounted on first use and
+// stays off the boot path.
+static constexpr uint32_t BOOT_DISPLAY_WAIT_MS = 3000;
+static constexpr uint32_t BOOT_WIFI_DIRECTED_MS = 4000;  // cached AP before falling back to a scan
+static constexpr uint32_t BOOT_WIFI_PORTAL_MS = 45000;   // DHCP + association can take >15s
+static constexpr uint8_t BOOT_HISTORY = 8;
+
+static SemaphoreHandle_t g_bootDisplayDone = nullptr;
+static bool g_bootWifiPending = false;
+static bool g_bootWifiDirected = false;
+static uint32_t g_bootWifiStartMs = 0;
+static uint32_t g_bootWifiLogMs = 0;
+static bool g_bootSaved = false;
+
+// Time to first share for the last few boots, newest first (NVS "nm_boot").
+struct BootRecord {
+  uint8_t reset_reason;
+  uint8_t reserved[3];
+  uint32_t wifi_up_ms;
+  uint32_t first_hash_ms;
+  uint32_t first_share_ms;
+};
+
+static void bootDisplayInit() {
+  // Safe backlight default until the settings are loaded (don't mutate config).
+  blSet(50);
+  delay(10);
+  tft.init();
+  // IMPORTANT: Our full-screen framebuffer is stored as native-endian RGB565.
+  // TFT_eSPI's fast pushPixels() path on ESP32-S3 streams the underlying bytes.
+  // Enable swapBytes so colors render correctly (otherwise red/blue/yellow/cyan get permuted).
+  tft.setSwapBytes(true);
+  tft.setRotation(1); // landscape 160x80 (updated after config load)
+  tft.fillScreen(TFT_BLACK);
+  bootMark(BOOT_DISPLAY);
+  xSemaphoreGive(g_bootDisplayDone);
+}
+
+static void bootDisplayTask(void *arg) {
+  (void)arg;
+  bootDisplayInit();
+  vTaskDelete(nullptr);
+}
+
+static void bootDisplayStart() {
+  g_bootDisplayDone = xSemaphoreCreateBinary();
+  if (xTaskCreatePinnedToCore(bootDisplayTask, "bootLcd", 3072, nullptr, 1, nullptr, 0) != pdPASS) {
+    bootDisplayInit();   // no task: do it inline
+  }
+}
+
+// The panel is not shared: keep waiting past the warning rather than drawing
+// while the init task is still on the SPI bus.
+static void bootDisplayJoin() {
+  while (xSemaphoreTake(g_bootDisplayDone, pdMS_TO_TICKS(BOOT_DISPLAY_WAIT_MS)) != pdTRUE) {
+    NM_LOGW("[NukaMiner] Display init did not finish within %lu ms, still waiting", (unsigned long)BOOT_DISPLAY_WAIT_MS);
+  }
+}
+
+// Start associating without waiting for it.
+static void wifiBootBegin() {
+  bootMark(BOOT_WIFI_BEGIN);
+  if (!wifiHasAnyConfig()) {
+    Serial.println("[NukaMiner] Starting portal (no WiFi configured)");
+    portalStart(true);
+    return;
+  }
+  WiFi.mode(WIFI_STA);
+  powerRadioApply();
+  g_bootWifiDirected = wifiBeginDirected();
+  if (!g_bootWifiDirected) wifiConnect(/*tryFast=*/false);
+  g_bootWifiPending = true;
+  g_bootWifiStartMs = millis();
+}
+
+// loop(): finish the boot connect. Until it is done the reconnect watchdog
+// stays out of the way, so it cannot restart an association in progress.
+static void wifiBootService() {
+  if (!g_bootWifiPending) return;
+  const CfgView c = cfgView();
+  const uint32_t now = millis();
+  const uint32_t elapsed = now - g_bootWifiStartMs;
+  if (WiFi.isConnected()) {
+    g_bootWifiPending = false;
+    Serial.printf("[NukaMiner] WiFi connected in %lu ms: %s\n", (unsigned long)elapsed,
+                  WiFi.localIP().toString().c_str());
+    // Start Web UI only after network stack is up (prevents LWIP mbox assert on ESP32-S3)
+    if (c->web_enabled && !portalRunning && !webBegun) {
+      web.begin();
+      webBegun = true;
+      bootMark(BOOT_WEB);
+    }
+    return;
+  }
+  if ((uint32_t)(now - g_bootWifiLogMs) >= 1000) {
+    g_bootWifiLogMs = now;
+    Serial.printf("[NukaMiner] WiFi status=%d\n", (int)WiFi.status());
+  }
+  if (g_bootWifiDirected && elapsed >= BOOT_WIFI_DIRECTED_MS) {
+    g_bootWifiDirected = false;
+    Serial.println("[NukaMiner] WiFi fast connect failed, scanning");
+    WiFi.disconnect(false, false);
+    wifiConnect(/*tryFast=*/false);
+  }
+  if (elapsed < BOOT_WIFI_PORTAL_MS) return;
+
+  // Could not connect. Start portal as AP+STA so user can fix settings,
+  // but keep trying to connect in the background.
+  g_bootWifiPending = false;
+  Serial.println("[NukaMiner] WiFi not connected - starting portal (AP+STA fallback)");
+  WiFi.mode(WIFI_AP_STA);
+  if (c->wifi_ssid.length()) WiFi.begin(c->wifi_ssid.c_str(), c->wifi_pass.c_str());
+  portalStart(true);
+}
+
+static uint8_t bootHistoryLoad(BootRecord *out) {
+  Preferences p;
+  if (!p.begin("nm_boot", true)) return 0;
+  const size_t len = p.getBytes("hist", out, sizeof(BootRecord) * BOOT_HISTORY);
+  p.end();
+  return (uint8_t)(len / sizeof(BootRecord));
+}
+
+// loop(): once the first share is in, log the timeline and add it to the
+// history (one NVS write per boot).
+static void bootService() {
+  if (g_bootSaved || !g_bootMs[BOOT_FIRST_SHARE]) return;
+  g_bootSaved = true;
+  NM_LOGI("[NukaMiner] Boot: WiFi up %lu ms, first hash %lu ms, first share %lu ms",
+          (unsigned long)g_bootMs[BOOT_WIFI_UP], (unsigned long)g_bootMs[BOOT_FIRST_HASH],
+          (unsigned long)g_bootMs[BOOT_FIRST_SHARE]);
+
+  BootRecord hist[BOOT_HISTORY];
+  uint8_t n = bootHistoryLoad(hist);
+  if (n == BOOT_HISTORY) n--;
+  memmove(&hist[1], &hist[0], sizeof(BootRecord) * n);
+  memset(&hist[0], 0, sizeof(BootRecord));
+  hist[0].reset_reason = (uint8_t)g_resetReason;
+  hist[0].wifi_up_ms = g_bootMs[BOOT_WIFI_UP];
+  hist[0].first_hash_ms = g_bootMs[BOOT_FIRST_HASH];
+  hist[0].first_share_ms = g_bootMs[BOOT_FIRST_SHARE];
+  Preferences p;
+  if (!p.begin("nm_boot", false)) return;
+  p.putBytes("hist", hist, sizeof(BootRecord) * (n + 1));
+  p.end();
+}
+
+static void bootFillStatus(JsonDocument &doc) {
+  JsonObject o = doc.createNestedObject("boot");
+  o["wifi_up_ms"] = g_bootMs[BOOT_WIFI_UP];
+  o["first_hash_ms"] = g_bootMs[BOOT_FIRST_HASH];
+  o["first_share_ms"] = g_bootMs[BOOT_FIRST_SHARE];
+}
+
+// Stages in the order they were reached. Times are uptime in ms; the ROM and
+// second-stage bootloader (a few hundred ms before the app starts) are not
+// included.
+static void webHandleBootJson() {
+  if (!requireAuthOrPortal()) return;
+  JsonDocument doc;
+  doc["reset_reason"] = NM_reset_reason_name((uint8_t)g_resetReason);
+  doc["uptime_ms"] = millis();
+  doc["safe_mode"] = NM_crash_safe_mode();
+  uint8_t order[BOOT_STAGES];
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < BOOT_STAGES; i++) {
+    if (!g_bootMs[i]) continue;
+    uint8_t j = n++;
+    while (j && g_bootMs[order[j - 1]] > g_bootMs[i]) { order[j] = order[j - 1]; j--; }
+    order[j] = i;
+  }
+  JsonArray arr = doc.createNestedArray("stages");
+  for (uint8_t k = 0; k < n; k++) {
+    const uint8_t i = order[k];
+    const BootStageDef &d = kBootStages[i];
+    JsonObject o = arr.createNestedObject();
+    o["stage"] = d.key;
+    o["at_ms"] = g_bootMs[i];
+    if (d.after != i && g_bootMs[d.after]) {
+      o["after"] = kBootStages[d.after].key;
+      o["took_ms"] = g_bootMs[i] - g_bootMs[d.after];
+    }
+  }
+  doc["to_first_hash_ms"] = g_bootMs[BOOT_FIRST_HASH];
+  doc["to_first_share_ms"] = g_bootMs[BOOT_FIRST_SHARE];
+
+  BootRecord hist[BOOT_HISTORY];
+  const uint8_t h = bootHistoryLoad(hist);
+  JsonArray ha = doc.createNestedArray("history");
+  for (uint8_t i = 0; i < h; i++) {
+    JsonObject o = ha.createNestedObject();
+    o["reset_reason"] = NM_reset_reason_name(hist[i].reset_reason);
+    o["wifi_up_ms"] = hist[i].wifi_up_ms;
+    o["first_hash_ms"] = hist[i].first_hash_ms;
+    o["first_share_ms"] = hist[i].first_share_ms;
+  }
+  String out;
+  serializeJson(doc, out);
+  web.send(200, "application/json", out);
+}
+
+// -----------------------------
+// Crash-loop safe mode
+// -----------------------------
+// lib/NukaDuino/src/CrashLog.h counts crash resets in RTC memory. After
+// NM_SAFE_MODE_RESETS of them in a row, each before the boot was marked
+// stable, the dongle boots in safe mode. Safe mode mines with the
+// last-known-good settings (in memory only), never mounts the SD card and
+// shows one static LCD screen instead of rendering pages. Panic records
+// (reason, PC, backtrace) are served at /crash.json.
+static constexpr uint32_t CRASH_STABLE_MS = 120000;      // uptime that ends a crash streak
+static constexpr uint32_t LKG_SAVE_AFTER_MS = 600000;    // mining this long before a config counts as good
+static constexpr uint32_t LKG_CHECK_MS = 600000;
+
+static uint32_t g_lkgLastCheckMs = 0;
+static bool g_lkgApplied = false;
+
+static uint32_t lkgHash(const String &s) {
+  uint32_t h = 2166136261u;   // FNV-1a
+  for (size_t i = 0; i < s.length(); i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+  return h;
+}
+
+// Settings as exported by a backup, minus the export timestamp.
+static String lkgSnapshot() {
+  JsonDocument doc;
+  buildBackupJson(doc);
+  doc.remove("exported_at_unix");
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+// Safe mode: replace the loaded settings with the last known good ones.
+// Nothing is written back, so the user's own settings return once the
+// device is stable again.
+static void safeModeLoadLastGood() {
+  Preferences p;
+  if (!p.begin("nm_lkg", true)) return;
+  const String json = p.getString("cfg", "");
+  p.end();
+  if (!json.length()) {
+    NM_LOGW("[NukaMiner] Safe mode: no last-known-good settings, using current ones");
+    return;
+  }
+  JsonDocument doc;
+  if (deserializeJson(doc, json)) return;
+  applyConfigFromJson(doc, /*persist=*/false);
+  g_lkgApplied = true;
+  NM_LOGW("[NukaMiner] Safe mode: mining with last-known-good settings");
+}
+
+// loop(): end the crash streak once up for a while, and remember settings
+// that have mined for LKG_SAVE_AFTER_MS as last known good.
+static void crashService() {
+  const uint32_t now = millis();
+  if (!NM_crash_stable() && now >= CRASH_STABLE_MS) {
+    NM_crash_mark_stable();
+    NM_LOGI("[NukaMiner] Boot stable after %lu s, crash streak cleared", (unsigned long)(now / 1000));
+  }
+  if (NM_crash_safe_mode() || now < LKG_SAVE_AFTER_MS) return;
+  if (g_lkgLastCheckMs && (uint32_t)(now - g_lkgLastCheckMs) < LKG_CHECK_MS) return;
+  g_lkgLastCheckMs = now;
+  MinerStatsSnapshot st;
+  NM_stats_snapshot(st);
+  if (!minerIsRunning() || st.accepted == 0) return;
+
+  const String snap = lkgSnapshot();
+  const uint32_t h = lkgHash(snap);
+  Preferences p;
+  if (!p.begin("nm_lkg", false)) return;
+  if (p.getUInt("hash", 0) != h) {
+    // Only a stored snapshot may carry the hash; NVS strings are limited to
+    // 4000 bytes, and a failed write must be retried, not marked as done.
+    if (p.putString("cfg", snap) == snap.length()) {
+      p.putUInt("hash", h);
+      NM_LOGI("[NukaMiner] Saved current settings as last known good");
+    } else {
+      NM_LOGW("[NukaMiner] Could not save last known good settings (%u bytes)", (unsigned)snap.length());
+    }
+  }
+  p.end();
+}
+
+static void drawSafeModePage() {
+  fbFill(TFT_BLACK);
+  drawTopBar("Safe mode");
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%u crash resets", (unsigned)NM_crash_fast_resets());
+  fbText(buf, 4, 20, TFT_ORANGE, 1, false);
+  fbText(g_lkgApplied ? "Mining: last good cfg" : "Mining: current cfg", 4, 32, TFT_WHITE, 1, false);
+  fbText("Details: /crash.json", 4, 44, TFT_WHITE, 1, false);
+  fbPush();
+}
+
+static void crashFillStatus(JsonDocument &doc) {
+  doc["safe_mode"] = NM_crash_safe_mode();
+  doc["boot_count"] = NM_crash_boot_count();
+  doc["crashes"] = NM_crash_count();
+}
+
+// GET: boot/crash summary and the stored panic records, newest first.
+// POST clear=1: forget the records.
+static void webHandleCrashJson() {
+  if (!requireAuthOrPortal()) return;
+  if (web.method() == HTTP_POST && web.arg("clear") == "1") {
+    NM_crash_clear();
+    NM_LOGI("[NukaMiner] Crash records cleared");
+  }
+  JsonDocument doc;
+  doc["boot_count"] = NM_crash_boot_count();
+  doc["reset_reason"] = NM_reset_reason_name((uint8_t)g_resetReason);
+  doc["fast_resets"] = NM_crash_fast_resets();
+  doc["safe_mode_after"] = NM_SAFE_MODE_RESETS;
+  doc["safe_mode"] = NM_crash_safe_mode();
+  doc["last_known_good"] = g_lkgApplied;
+  doc["stable"] = NM_crash_stable();
+  doc["capture"] = NM_crash_capture_enabled();
+  JsonArray arr = doc.createNestedArray("crashes");
+  NMCrashRecord c;
+  for (uint8_t i = 0; NM_crash_get(i, c); i++) {
+    JsonObject o = arr.createNestedObject();
+    o["boot"] = c.boot;
+    o["uptime_ms"] = c.uptime_ms;
+    o["reason"] = c.reason;
+    o["reset"] = NM_reset_reason_name(c.reset_reason);
+    o["core"] = c.core;
+    char hex[12];
+    snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)c.exc_pc);
+    o["pc"] = hex;
+    // Space-separated, ready for xtensa-esp32s3-elf-addr2line -pfiaC -e firmware.elf
+    char bt[NM_CRASH_DEPTH * 11 + 1];
+    size_t n = 0;
+    bt[0] = 0;
+    for (uint8_t d = 0; d < c.depth && d < NM_CRASH_DEPTH; d++) {
+      n += snprintf(bt + n, sizeof(bt) - n, "%s0x%08lx", d ? " " : "", (unsigned long)c.backtrace[d]);
+    }
+    o["backtrace"] = bt;
+  }
+  String out;
+  serializeJson(doc, out);
+  web.send(200, "application/json", out);
+}
+
 // -----------------------------
 // Arduino
 // -----------------------------
 void setup() {
-  // Capture reset reason early (for Status page)
+  // Capture reset reason early (for Status page) and count crash resets
   g_resetReason = esp_reset_reason();
+  NM_crash_boot();
+  bootMark(BOOT_SETUP);
+
+  // Run gates first: their owners start setting bits during init.
+  g_gates = xEventGroupCreate();
+  nmGateSet(NM_GATE_SD_IDLE | NM_GATE_NO_PORTAL, true);
+  g_minerLock = xSemaphoreCreateRecursiveMutex();
+  g_radioLock = xSemaphoreCreateMutex();
+  g_cfgReq = xQueueCreate(4, sizeof(CfgRequest));
 
   pinMode(PIN_BUTTON, INPUT_PULLUP);
 
@@ -5071,14 +8740,7 @@ void setup() {
   btnLastChangeMs = millis();
 
   Serial.begin(115200);
-  delay(200);
-
-  Serial.println();
-  Serial.println("[NukaMiner] Boot");
-  Serial.printf("[NukaMiner] Free heap at boot: %u\n", (unsigned)ESP.getFreeHeap());
-
-  Serial.println("[NukaMiner] Display init...");
-  Serial.println("[NukaMiner] Framebuffer alloc...");
+  logDrainStart();
 
   fbFront = (uint16_t*)malloc(WIDTH * HEIGHT * sizeof(uint16_t));
   fbBack  = (uint16_t*)malloc(WIDTH * HEIGHT * sizeof(uint16_t));
@@ -5091,72 +8753,81 @@ void setup() {
   // Initialize both buffers to black so the first web frame is valid.
   for (int i = 0; i < WIDTH * HEIGHT; i++) { fbFront[i] = 0; fbBack[i] = 0; }
 
-  // Start backlight at a safe default until config is loaded (don't mutate config)
-  blSet(50, false);
-  delay(10);
-  Serial.println("[NukaMiner] Calling tft.init()...");
-  tft.init();
-  Serial.println("[NukaMiner] tft.init ok");
-  // IMPORTANT: Our full-screen framebuffer is stored as native-endian RGB565.
-  // TFT_eSPI's fast pushPixels() path on ESP32-S3 streams the underlying bytes.
-  // Enable swapBytes so colors render correctly (otherwise red/blue/yellow/cyan get permuted).
-  tft.setSwapBytes(true);
-  tft.setRotation(1); // landscape 160x80 (updated after config load)
-  tft.fillScreen(TFT_BLACK);
-
-
-  Serial.printf("[NukaMiner] Framebuffer OK (%u bytes). Free heap: %u\n",
-                (unsigned)(WIDTH * HEIGHT * sizeof(uint16_t)), (unsigned)ESP.getFreeHeap());
+  // The panel initialises on CPU0 while this task loads config and starts
+  // WiFi; joined before the first draw (see "Boot sequence").
+  bootDisplayStart();
+  delay(200);
 
+  Serial.println();
+  Serial.println("[NukaMiner] Boot");
+  if (NM_crash_safe_mode()) {
+    Serial.printf("[NukaMiner] SAFE MODE after %u crash resets (last: %s)\n",
+                  (unsigned)NM_crash_fast_resets(), NM_reset_reason_name((uint8_t)g_resetReason));
+  }
+  Serial.printf("[NukaMiner] Free heap at boot: %u\n", (unsigned)ESP.getFreeHeap());
   Serial.println("[NukaMiner] Load config...");
 
   loadConfig();
-
   // Load WiFi profiles (and migrate legacy single-SSID settings if needed)
   wifiProfilesLoad();
+  // After the profiles: the last known good settings carry their own.
+  if (NM_crash_safe_mode()) safeModeLoadLastGood();
+
+  // setup() runs in loopTask: apply the configured loop()/LCD priority.
+  g_loopTask = xTaskGetCurrentTaskHandle();
+  NM_alloc_register(NM_ALLOC_LOOP);
+  vTaskPrioritySet(g_loopTask, cfg.task_loop_prio);
 
   // Apply hashrate limiter immediately (mining code reads this global)
   NM_hash_limit_pct = cfg.hash_limit_pct; // alias
   NM_hash_limit_pct_job0 = cfg.hash_limit_pct;
   NM_hash_limit_pct_job1 = cfg.core2_enabled ? cfg.core2_hash_limit_pct : 100;
+  bootMark(BOOT_CONFIG);
 
-  // Apply user rotation and brightness now that config is loaded
-  tft.setRotation(cfg.lcd_rot180 ? 3 : 1);
-  blSet(cfg.lcd_brightness, false);
-
-  // Init RGB LED after config is loaded
-  ledInit();
-  ledService();
   registerWebHandlers();
 
   // Start the high-priority service task on CPU0 to keep Web UI and BOOT
   // responsive under heavy mining load.
+  esp_register_freertos_idle_hook_for_cpu(yieldIdleHook0, 0);
   if (!serviceTask) {
-    xTaskCreatePinnedToCore(serviceTaskFn, "svc", 4096, nullptr, 3, &serviceTask, 0);
+    xTaskCreatePinnedToCore(serviceTaskFn, "svc", SVC_TASK_STACK, nullptr, cfg.task_svc_prio, &serviceTask, cfg.task_svc_core);
   }
 
   // SD restore only when explicitly requested (avoid SD errors on boards without SD)
 
+  // Miner and pool tasks wait on the WiFi gate, so start them first: they
+  // begin the moment DHCP finishes instead of after setup() has seen it.
+  if (wifiHasAnyConfig()) minerStart();
+  bootMark(BOOT_MINERS);
+
   Serial.println("[NukaMiner] WiFi connect...");
+  WiFi.onEvent(wifiOnEvent);
+  wifiBootBegin();
 
-  wifiConnect();
-  maybeStartPortalIfNeeded();
+  bootDisplayJoin();
+  Serial.printf("[NukaMiner] Display ready at %lu ms. Free heap: %u\n",
+                (unsigned long)g_bootMs[BOOT_DISPLAY], (unsigned)ESP.getFreeHeap());
 
-  // Start Web UI only after network stack is up (prevents LWIP mbox assert on ESP32-S3)
-  if (cfg.web_enabled && WiFi.isConnected() && !portalRunning) {
-    if (!webBegun) { web.begin(); webBegun = true; }
-  }
+  // Apply user rotation and brightness now that config is loaded
+  tft.setRotation(cfg.lcd_rot180 ? 3 : 1);
+  blSet(cfg.lcd_brightness);
 
-  // Start miner after WiFi is up (will wait for connection)
-  minerStart();
+  // Init RGB LED after config is loaded
+  ledInit();
+  ledService();
+  // CPU clock and LCD/LED/radio caps of the power profile
+  powerProfileApply();
 
   // Pick a sensible initial page.
-  if (!wifiHasAnyConfig()) {
+  if (NM_crash_safe_mode()) {
+    drawSafeModePage();
+  } else if (!wifiHasAnyConfig()) {
     page = PAGE_SETUP;
   } else {
     page = cfg.duino_enabled ? PAGE_MINING : PAGE_IP;
   }
 
+  bootMark(BOOT_SETUP_DONE);
   Serial.println("[NukaMiner] Setup complete");
 
   lastInteractionMs = millis();
@@ -5166,10 +8837,13 @@ void loop() {
   // BOOT handling, portalLoop and web.handleClient() are serviced by the
   // dedicated CPU0 service task for responsiveness during mining.
 
+  // One settings snapshot per pass; the web handler may be saving on CPU0.
+  const CfgView lc = cfgView();
+
   // Auto-cycle LCD pages (only when not in AP/portal)
-  if (!portalRunning && !deviceControlMode && cfg.carousel_enabled && cfg.carousel_seconds > 0 && !displaySleeping) {
+  if (!portalRunning && !deviceControlMode && lc->carousel_enabled && lc->carousel_seconds > 0 && !displaySleeping) {
     uint32_t now = millis();
-    uint32_t period = (uint32_t)cfg.carousel_seconds * 1000UL;
+    uint32_t period = (uint32_t)lc->carousel_seconds * 1000UL;
     if (now - lastCarouselFlipMs >= period) {
       lastCarouselFlipMs = now;
       switch (page) {
@@ -5184,67 +8858,92 @@ void loop() {
   }
   // portalLoop/web handled in serviceTaskFn
 
+  // Boot connect (directed, scan, then portal) until the first IP.
+  wifiBootService();
+
   // If we started the portal as a fallback (AP+STA) and STA later connects,
   // shut down AP and switch to normal operation.
   if (portalRunning && portalAuto && WiFi.isConnected()) {
     portalStop();
     // Start Web UI now that STA is up
-    if (cfg.web_enabled && !webBegun) { web.begin(); webBegun = true; }
+    if (lc->web_enabled && !webBegun) { web.begin(); webBegun = true; bootMark(BOOT_WEB); }
     // Miner task may already be running; if not, start it.
     if (!minerIsRunning()) minerStart();
 
     // If we were showing setup instructions because portal was active,
     // switch to a normal info page after the device is connected.
     if (page == PAGE_SETUP) {
-      page = cfg.duino_enabled ? PAGE_MINING : PAGE_IP;
+      page = lc->duino_enabled ? PAGE_MINING : PAGE_IP;
     }
   }
 
   // -----------------------------
   // WiFi reconnect watchdog
-  // If WiFi drops while mining, attempt to reconnect. After 5 failed attempts
-  // (spaced out) reboot to recover from DNS/SSL stack issues.
+  // If WiFi drops while mining, escalate gently: a plain reconnect keeps the
+  // driver and lwIP state (miner sockets survive if DHCP hands back the same
+  // IP), then a directed connect to the cached BSSID/channel, then a full
+  // scan, and only then a full stack reset. If that does not help either,
+  // the health supervisor takes over (radio reset, then reboot).
   // -----------------------------
-  if (!portalRunning && wifiHasAnyConfig()) {
+  if (!portalRunning && !g_bootWifiPending && wifiHasAnyConfig()) {
     if (WiFi.status() == WL_CONNECTED) {
       wifiReconnectFails = 0;
-      // Remember last successful SSID to speed up future boots.
-      String cur = WiFi.SSID();
-      if (cur.length() && cur != wifiLastSsid) {
-        wifiLastSsid = cur;
-        wifiProfilesSave();
-      }
+      // Remember last successful SSID/BSSID/channel to speed up reconnects.
+      wifiRememberAp();
+      // setup() skips the miners until WiFi is configured; start them once
+      // the profile saved from the portal is up. minerStart() no-ops while
+      // tasks exist or mining is disabled.
+      if (lc->duino_enabled && !minerIsRunning()) minerStart();
     } else {
       uint32_t now = millis();
-      if (now - lastWifiCheckMs > 1000) {
+      // Give each stage time to complete before escalating.
+      static const uint16_t stageWaitMs[] = {1000, 3000, 5000, 10000, 10000};
+      const uint16_t waitMs = stageWaitMs[wifiReconnectFails < 4 ? wifiReconnectFails : 4];
+      if (now - lastWifiCheckMs > 250) {
         lastWifiCheckMs = now;
-        if (now - lastWifiAttemptMs > 5000) {
+        if (now - lastWifiAttemptMs > waitMs) {
           lastWifiAttemptMs = now;
-          wifiReconnectFails++;
+          if (wifiReconnectFails < 255) wifiReconnectFails++;
           NM_log(String("[NukaMiner] WiFi disconnected, reconnect attempt ") + wifiReconnectFails);
 
-          // Aggressive reconnect to refresh DHCP/DNS
-          WiFi.disconnect(true, true);
-          delay(50);
-          WiFi.mode(WIFI_STA);
-          WiFi.begin(cfg.wifi_ssid.c_str(), cfg.wifi_pass.c_str());
-
-          if (cfg.duino_enabled && minerIsRunning() && wifiReconnectFails >= 5) {
-            NM_log("[NukaMiner] WiFi reconnect failed 5 times while mining - rebooting");
-            delay(200);
-            ESP.restart();
+          if (wifiReconnectFails == 1) {
+            WiFi.reconnect();
+          } else if (wifiReconnectFails == 2 && wifiBeginDirected()) {
+            // directed connect issued
+          } else if (wifiReconnectFails <= 3) {
+            WiFi.disconnect(false, false);
+            wifiConnect(/*tryFast=*/false);
+          } else {
+            // Aggressive reconnect to refresh DHCP/DNS
+            WiFi.disconnect(true, true);
+            delay(50);
+            WiFi.mode(WIFI_STA);
+            WiFi.begin(lc->wifi_ssid.c_str(), lc->wifi_pass.c_str());
           }
         }
       }
     }
   }
 
+  wifiRoamService();
+  netSampleCurrentAp();
+  taskTelemetrySample();
+  taskTuneSample();
+  thermalSample();
+  powerSample();
+  healthSample();
+  crashService();
+  bootService();
+  nmGateSync();
+
   // Sample hashrate for LCD graph (once per second)
   {
     uint32_t now = millis();
     if (now - lastHrSampleMs >= 1000) {
       lastHrSampleMs = now;
-      const uint32_t totalHash = (uint32_t)hashrate + (cfg.core2_enabled ? (uint32_t)hashrate_core_two : 0U);
+      MinerStatsSnapshot st;
+      NM_stats_snapshot(st);
+      const uint32_t totalHash = minerTotalHashrate(st);
       if (hrHistPos < HR_HIST_LEN) {
         hrHist[hrHistPos++] = totalHash;
         if (hrHistPos == HR_HIST_LEN) hrHistFilled = true;
@@ -5259,10 +8958,10 @@ void loop() {
   }
 
   // Carousel mode: auto-cycle pages when not in AP/portal
-  if (!portalRunning && cfg.carousel_enabled && cfg.carousel_seconds >= 2 && !displaySleeping) {
+  if (!portalRunning && lc->carousel_enabled && lc->carousel_seconds >= 2 && !displaySleeping) {
     uint32_t now = millis();
     if (lastCarouselFlipMs == 0) lastCarouselFlipMs = now;
-    if (now - lastCarouselFlipMs >= (uint32_t)cfg.carousel_seconds * 1000UL) {
+    if (now - lastCarouselFlipMs >= (uint32_t)lc->carousel_seconds * 1000UL) {
       lastCarouselFlipMs = now;
       // advance page (skip setup page in normal mode)
       switch (page) {
@@ -5276,14 +8975,19 @@ void loop() {
     }
   }
 
-  // Display sleep
-  if (!displaySleeping && cfg.display_sleep_s > 0) {
-    if (millis() - lastInteractionMs > cfg.display_sleep_s * 1000UL) {
+  // Display sleep (the power profile may shorten it)
+  {
+    uint32_t sleepS = lc->display_sleep_s;
+    const uint16_t capS = powerProfile(lc->power_profile).lcd_sleep_s;
+    if (capS && (sleepS == 0 || sleepS > capS)) sleepS = capS;
+    if (!displaySleeping && sleepS > 0 && millis() - lastInteractionMs > sleepS * 1000UL) {
       displaySleep();
     }
   }
 
-  if (!displaySleeping) {
+  // Safe mode keeps the static screen drawn in setup().
+  if (!displaySleeping && !NM_crash_safe_mode()) {
+    NM_TRACE_SCOPE(NM_TC_LCD, "redraw");
     switch(page) {
       case PAGE_LOGO:   drawLogoPage(); break;
       case PAGE_MINING: drawMiningPage(); break;
@@ -5297,5 +9001,7 @@ void loop() {
   // Update RGB LED state
   ledService();
 
+  const uint32_t sleepStart = millis();
   delay(100);
+  yieldNoteLoopWake(millis() - sleepStart, 100);
 }
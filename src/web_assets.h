@@ -742,6 +742,16 @@ async function dcMakePngBlob() {
   }
 
   function estimatePowerAndEff(s) {
+    // The firmware keeps the same model with clock, modem sleep and achieved
+    // duty folded in (status.json "power"); prefer it when present.
+    if (s.power && Number.isFinite(Number(s.power.est_ma)) && Number(s.power.est_ma) > 0) {
+      const ma = Number(s.power.est_ma);
+      const v = 5.0;
+      const w = Number(s.power.est_w) || (ma / 1000.0) * v;
+      const hr = Number(s.hashrate || 0); // kH/s
+      const eff = (Number.isFinite(hr) && w > 0.0001) ? (hr / w) : 0;
+      return { ma, w, eff, v };
+    }
     // Lightweight heuristic model. Tune constants here only (no backend needed).
     // Values are "ballpark" for ESP32-S3 class boards on USB power.
     const BASE_MA = 58;             // MCU + regulators baseline (calibrated)
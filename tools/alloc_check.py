@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Check NukaMiner's steady-state allocation budget against a running dongle.
+
+The firmware counts heap allocations per task (lib/NukaDuino/src/AllocStats.h)
+and measures every share cycle that ran on an already connected socket. Those
+cycles must not allocate. This tool watches /status.json for a while, prints
+the per-subsystem counts and the cost of a status poll, and exits non-zero if
+a steady-state share cycle allocated during the run (or, with
+--status-budget, if a status poll went over budget).
+
+    python3 tools/alloc_check.py http://<dongle> --user admin --password nukaminer --seconds 300
+
+Needs a firmware built with NM_ALLOC_STATS (the default platformio.ini).
+"""
+
+import argparse
+import base64
+import json
+import sys
+import time
+import urllib.request
+
+
+def fetch(base, user, password):
+    req = urllib.request.Request(base.rstrip("/") + "/status.json")
+    if user:
+        token = base64.b64encode(f"{user}:{password or ''}".encode()).decode()
+        req.add_header("Authorization", "Basic " + token)
+    with urllib.request.urlopen(req, timeout=10) as r:
+        return json.loads(r.read())
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("url", help="http://<dongle>")
+    ap.add_argument("--user")
+    ap.add_argument("--password")
+    ap.add_argument("--seconds", type=int, default=120, help="how long to watch (default 120)")
+    ap.add_argument("--interval", type=float, default=2.0, help="poll interval in seconds")
+    ap.add_argument("--status-budget", type=int, default=None,
+                    help="fail if one status poll allocates more than this many blocks")
+    args = ap.parse_args()
+
+    first = fetch(args.url, args.user, args.password)
+    alloc = first.get("alloc", {})
+    if not alloc.get("enabled"):
+        sys.exit("firmware was built without NM_ALLOC_STATS; nothing to check")
+
+    end = time.time() + args.seconds
+    last = first
+    while time.time() < end:
+        time.sleep(args.interval)
+        last = fetch(args.url, args.user, args.password)
+
+    a0, a1 = first["alloc"], last["alloc"]
+    print(f"heap free {last['heap']}  min {last['heap_min']}  largest block {last['heap_largest']}"
+          f"  fragmentation {last['heap_frag_pct']}%")
+    print(f"{'subsystem':<10} {'allocs':>10} {'per s':>8} {'live':>8} {'bytes':>12}")
+    for name, t1 in a1["tags"].items():
+        t0 = a0["tags"].get(name, {"allocs": 0})
+        d = t1["allocs"] - t0["allocs"]
+        print(f"{name:<10} {t1['allocs']:>10} {d / args.seconds:>8.1f} {t1['live']:>8} {t1['bytes']:>12}")
+
+    failed = False
+    for w, (s0, s1) in enumerate(zip(a0["share_cycle"], a1["share_cycle"])):
+        cycles = s1["cycles"] - s0["cycles"]
+        dirty = s1["dirty"] - s0["dirty"]
+        verdict = "ok" if dirty == 0 else "FAIL"
+        if cycles == 0:
+            verdict = "no steady-state shares seen"
+        print(f"core {w + 1}: {cycles} steady-state share cycles, {dirty} allocated"
+              f" (worst ever {s1['max']})  {verdict}")
+        failed |= dirty > 0
+
+    sp = a1["status_poll"]
+    print(f"status poll: last {sp['last']} allocations, worst {sp['max']} over {sp['cycles']} polls")
+    if args.status_budget is not None and sp["max"] > args.status_budget:
+        print(f"status poll over budget ({sp['max']} > {args.status_budget})")
+        failed = True
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
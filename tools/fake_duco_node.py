@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Minimal fake Duino-Coin node for failover testing on a LAN.
+
+Speaks just enough of the miner protocol for NukaMiner (version greeting,
+JOB requests, share submissions) and can be "killed" on cue so the dongle's
+node failover can be timed end to end.
+
+Typical run (two nodes, kill the primary after 5 shares) against firmware
+built with -D NM_TEST_HOOKS, which provides /pool/override:
+
+    python3 tools/fake_duco_node.py --port 2813 --die-after 5 &
+    python3 tools/fake_duco_node.py --port 2814 &
+    curl -u admin:nukaminer -X POST \
+      "http://<dongle>/pool/override?primary=<pc-ip>:2813&standby=<pc-ip>:2814"
+
+Then read failover_last_ms / failover_standby_count from /status.json.
+Send SIGUSR1 to kill a node manually, SIGUSR2 to bring it back.
+"""
+
+import argparse
+import asyncio
+import hashlib
+import os
+import random
+import signal
+import sys
+import time
+
+
+def log(port, msg):
+    print(f"{time.strftime('%H:%M:%S')} [:{port}] {msg}", flush=True)
+
+
+def make_job(diff):
+    last = hashlib.sha1(os.urandom(16)).hexdigest()
+    # Miners search nonces in [0, diff * 100].
+    nonce = random.randint(0, diff * 100)
+    expected = hashlib.sha1((last + str(nonce)).encode()).hexdigest()
+    return last, expected, nonce
+
+
+class FakeNode:
+    def __init__(self, args):
+        self.args = args
+        self.server = None
+        self.writers = set()
+        self.shares = 0
+
+    async def handle(self, reader, writer):
+        peer = writer.get_extra_info("peername")
+        self.writers.add(writer)
+        log(self.args.port, f"miner connected {peer}")
+        try:
+            writer.write(f"{self.args.version}\n".encode())
+            await writer.drain()
+            while True:
+                line = await reader.readline()
+                if not line:
+                    break
+                text = line.decode(errors="replace").strip()
+                if text.startswith("JOB,"):
+                    last, expected, _ = make_job(self.args.diff)
+                    writer.write(f"{last},{expected},{self.args.diff}\n".encode())
+                else:
+                    self.shares += 1
+                    writer.write(b"GOOD\n")
+                    log(self.args.port, f"share #{self.shares} from {peer}: {text[:60]}")
+                await writer.drain()
+                if self.args.die_after and self.shares >= self.args.die_after:
+                    self.kill(f"--die-after {self.args.die_after} reached")
+                    break
+        except (ConnectionError, asyncio.IncompleteReadError):
+            pass
+        finally:
+            self.writers.discard(writer)
+            writer.close()
+
+    def kill(self, why):
+        if self.server is None:
+            return
+        log(self.args.port, f"KILLED ({why}) at {time.time():.3f}")
+        self.server.close()
+        self.server = None
+        for w in list(self.writers):
+            # Abort (RST) rather than a polite FIN, like a crashed node.
+            w.transport.abort()
+        self.writers.clear()
+        if self.args.revive_after:
+            asyncio.get_running_loop().call_later(self.args.revive_after,
+                                                  lambda: asyncio.ensure_future(self.start()))
+
+    async def start(self):
+        if self.server is not None:
+            return
+        self.shares = 0
+        self.server = await asyncio.start_server(self.handle, self.args.host, self.args.port)
+        log(self.args.port, f"listening on {self.args.host}:{self.args.port} (diff {self.args.diff})")
+
+
+async def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=2813)
+    ap.add_argument("--diff", type=int, default=50, help="job difficulty (nonce range is diff*100)")
+    ap.add_argument("--version", default="3.0", help="greeting sent on connect")
+    ap.add_argument("--die-after", type=int, default=0, help="kill the node after N shares (0 = never)")
+    ap.add_argument("--revive-after", type=float, default=0, help="restart N seconds after being killed")
+    args = ap.parse_args()
+
+    node = FakeNode(args)
+    await node.start()
+    loop = asyncio.get_running_loop()
+    if hasattr(signal, "SIGUSR1"):
+        loop.add_signal_handler(signal.SIGUSR1, lambda: node.kill("SIGUSR1"))
+        loop.add_signal_handler(signal.SIGUSR2, lambda: asyncio.ensure_future(node.start()))
+    await asyncio.Event().wait()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        sys.exit(0)
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Decode NukaMiner's binary log dump (/events.bin) on the host.
+
+The dongle stores log events as an id plus raw 32-bit arguments and only
+formats them when someone reads them. This tool does the formatting off the
+device: it reads the event table from lib/NukaDuino/src/LogEvents.h, so the
+firmware and the decoder always agree on ids and formats.
+
+    curl -s -u admin:nukaminer http://<dongle>/events.bin -o events.bin
+    python3 tools/nm_events.py events.bin
+
+    # or fetch directly
+    python3 tools/nm_events.py http://<dongle>/events.bin --user admin --password nukaminer
+
+Text lines logged with NM_LOGx/NM_log are in the dump too and are printed
+as-is (without a timestamp, since only events carry one).
+"""
+
+import argparse
+import base64
+import os
+import re
+import struct
+import sys
+import urllib.request
+
+LEVELS = ["-", "E", "W", "I", "D", "V"]
+FLAG_EVENT = 0x02
+ARG_U32, ARG_I32, ARG_F32 = 0, 1, 2
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_TABLE = os.path.join(HERE, "..", "lib", "NukaDuino", "src", "LogEvents.h")
+
+
+def load_table(path):
+    """Returns [(name, fmt)] in enum order from the NM_EVENT_TABLE X-macro."""
+    entry = re.compile(r'^\s*X\(\s*(\w+)\s*,\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+    table = []
+    with open(path, encoding="utf-8") as f:
+        in_table = False
+        for line in f:
+            if line.startswith("#define NM_EVENT_TABLE"):
+                in_table = True
+                continue
+            if not in_table:
+                continue
+            m = entry.match(line)
+            if m:
+                fmt = m.group(2).encode().decode("unicode_escape")
+                table.append((m.group(1), fmt))
+            if not line.rstrip().endswith("\\"):
+                break
+    if not table:
+        sys.exit(f"no NM_EVENT_TABLE entries found in {path}")
+    return table
+
+
+SPEC = re.compile(r"%(%|[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?[diouxXfFeEgG])")
+
+
+def render(fmt, types, raw):
+    """Applies fmt to the raw words the way the firmware's logEventFormat does."""
+    out, pos, i = [], 0, 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        spec = m.group(1)
+        if spec == "%":
+            out.append("%")
+            continue
+        word = raw[i] if i < len(raw) else 0
+        kind = (types >> (2 * i)) & 3
+        i += 1
+        if kind == ARG_F32:
+            value = struct.unpack("<f", struct.pack("<I", word))[0]
+        elif kind == ARG_I32:
+            value = struct.unpack("<i", struct.pack("<I", word))[0]
+        else:
+            value = word
+        py = "%" + re.sub(r"(hh|h|ll|l|z)", "", spec)
+        if py[-1] == "u":
+            py = py[:-1] + "d"
+        if py[-1] in "diouxX":
+            value = int(value)
+        out.append(py % value)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(data, table):
+    if len(data) < 16 or data[:4] != b"NMEV":
+        sys.exit("not a NukaMiner events.bin dump")
+    version = data[4]
+    if version != 1:
+        sys.exit(f"unsupported dump version {version}")
+    now_ms, head = struct.unpack_from("<II", data, 8)
+    off = 16
+    while off + 4 <= len(data):
+        level, flags, length = struct.unpack_from("<BBH", data, off)
+        off += 4
+        payload = data[off:off + length]
+        off += length
+        tag = LEVELS[level] if level < len(LEVELS) else "?"
+        if not flags & FLAG_EVENT:
+            yield f"{'':>11}  {tag} {payload.decode('utf-8', 'replace')}"
+            continue
+        if len(payload) < 8:
+            continue
+        ev_id, types, t_ms = struct.unpack_from("<HHI", payload)
+        raw = list(struct.unpack_from(f"<{(len(payload) - 8) // 4}I", payload, 8))
+        age = (now_ms - t_ms) & 0xFFFFFFFF
+        if ev_id < len(table):
+            name, fmt = table[ev_id]
+            text = render(fmt, types, raw)
+        else:
+            name, text = f"#{ev_id}", " ".join(str(w) for w in raw)
+        yield f"{-age / 1000:>10.3f}s  {tag} {text}  [{name}]"
+
+
+def fetch(url, user, password):
+    req = urllib.request.Request(url)
+    if user:
+        token = base64.b64encode(f"{user}:{password or ''}".encode()).decode()
+        req.add_header("Authorization", "Basic " + token)
+    with urllib.request.urlopen(req, timeout=10) as r:
+        return r.read()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="events.bin file or http://<dongle>/events.bin URL")
+    ap.add_argument("--table", default=DEFAULT_TABLE, help="path to LogEvents.h")
+    ap.add_argument("--user")
+    ap.add_argument("--password")
+    args = ap.parse_args()
+
+    table = load_table(args.table)
+    if args.source.startswith(("http://", "https://")):
+        data = fetch(args.source, args.user, args.password)
+    else:
+        with open(args.source, "rb") as f:
+            data = f.read()
+    for line in decode(data, table):
+        print(line)
+
+
+if __name__ == "__main__":
+    main()
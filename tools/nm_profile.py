@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Turn a NukaMiner CPU profile (/profile?download=1) into folded stacks.
+
+The dongle samples the program counter of both cores from a timer interrupt
+and counts identical stacks on the device. This tool symbolises the addresses
+with the firmware ELF and prints one folded stack per line, the input format
+of flamegraph.pl, inferno and speedscope:
+
+    curl -s -u admin:nukaminer -X POST -d action=start http://<dongle>/profile
+    # ... let it run ...
+    curl -s -u admin:nukaminer 'http://<dongle>/profile?download=1' -o profile.bin
+    python3 tools/nm_profile.py profile.bin --elf .pio/build/<env>/firmware.elf > profile.folded
+    flamegraph.pl profile.folded > profile.svg
+
+    # or fetch directly
+    python3 tools/nm_profile.py 'http://<dongle>/profile?download=1' --user admin --password nukaminer --elf firmware.elf
+
+Symbols come from addr2line (--elf, --addr2line) or from an `nm -n` listing
+(--symbols); without either, frames are printed as hex addresses. The stack
+starts with the task name; --per-core puts "cpu0"/"cpu1" in front of it.
+
+--make-sample writes a small synthetic profile (and prints a matching symbols
+listing) so the format and this tool can be checked without a dongle.
+"""
+
+import argparse
+import base64
+import bisect
+import collections
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import urllib.request
+
+HEADER = struct.Struct("<4sBBHIIIII")   # 28 bytes, see lib/NukaDuino/src/Profiler.h
+TASK_NAME = 16
+
+
+def parse(data):
+    """Returns (info dict, [task names], [(count, core, task, [pc...])])."""
+    if len(data) < HEADER.size or data[:4] != b"NMPF":
+        sys.exit("not a NukaMiner profile")
+    magic, version, max_depth, ntasks, hz, samples, dropped, nstacks, duration_ms = HEADER.unpack_from(data)
+    if version != 1:
+        sys.exit(f"unsupported profile version {version}")
+    off = HEADER.size
+    tasks = []
+    for _ in range(ntasks):
+        raw = data[off:off + TASK_NAME]
+        off += TASK_NAME
+        tasks.append(raw.split(b"\0", 1)[0].decode("utf-8", "replace") or "?")
+    stacks = []
+    while off + 8 <= len(data):
+        count, core, task, depth, _ = struct.unpack_from("<IBBBB", data, off)
+        off += 8
+        if off + 4 * depth > len(data):
+            break
+        pcs = list(struct.unpack_from(f"<{depth}I", data, off))
+        off += 4 * depth
+        stacks.append((count, core, task, pcs))
+    info = dict(hz=hz, samples=samples, dropped=dropped, stacks=nstacks, duration_ms=duration_ms,
+                max_depth=max_depth)
+    if len(stacks) != nstacks:
+        print(f"warning: header says {nstacks} stacks, file has {len(stacks)}", file=sys.stderr)
+    return info, tasks, stacks
+
+
+def load_symbols(path):
+    """Sorted (addr, name) from `nm -n -C` output (text symbols only)."""
+    line_re = re.compile(r"^([0-9a-fA-F]+)\s+(?:[0-9a-fA-F]+\s+)?[tTwW]\s+(.+)$")
+    syms = []
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            m = line_re.match(line.strip())
+            if m:
+                syms.append((int(m.group(1), 16), m.group(2)))
+    syms.sort()
+    return syms
+
+
+def resolve_nm(addrs, syms):
+    starts = [a for a, _ in syms]
+    out = {}
+    for a in addrs:
+        i = bisect.bisect_right(starts, a) - 1
+        out[a] = syms[i][1] if i >= 0 else None
+    return out
+
+
+def resolve_addr2line(addrs, elf, tool):
+    """One addr2line run for all addresses (-a echoes each address first)."""
+    if not shutil.which(tool):
+        sys.exit(f"{tool} not found; pass --addr2line or --symbols")
+    addrs = sorted(addrs)
+    stdin = "".join(f"0x{a:08x}\n" for a in addrs)
+    res = subprocess.run([tool, "-f", "-C", "-a", "-e", elf], input=stdin, capture_output=True,
+                         text=True, check=True)
+    out, cur = {}, None
+    for line in res.stdout.splitlines():
+        if line.startswith("0x"):
+            cur = int(line, 16)
+        elif cur is not None and cur not in out:
+            out[cur] = None if line.startswith("??") else line
+    return out
+
+
+def frame_name(addr, names):
+    name = names.get(addr)
+    # Folded stacks use ';' as the separator and ' ' before the count.
+    return (name or f"0x{addr:08x}").replace(";", ":").replace(" ", "_")
+
+
+def fold(tasks, stacks, names, per_core):
+    folded = collections.Counter()
+    for count, core, task, pcs in stacks:
+        frames = [tasks[task] if task < len(tasks) else "?"]
+        if per_core:
+            frames.insert(0, f"cpu{core}")
+        frames += [frame_name(pc, names) for pc in reversed(pcs)]   # root first
+        folded[";".join(frames)] += count
+    return folded
+
+
+def make_sample(path):
+    """Writes a synthetic profile and returns an nm-style listing for it."""
+    syms = [(0x42000000, "app_main"), (0x42000100, "minerTaskFn"), (0x42000400, "DSHA1::update"),
+            (0x42000800, "serviceTaskFn"), (0x42000a00, "WebServer::handleClient"),
+            (0x40380000, "vPortYield"), (0x40380200, "prvIdleTask")]
+    tasks = ["?", "duco0", "duco1", "svc", "IDLE0"]
+    stacks = [
+        (620, 0, 1, [0x42000410, 0x42000180, 0x42000020]),
+        (587, 1, 2, [0x42000420, 0x42000190, 0x42000020]),
+        (41, 0, 1, [0x42000150, 0x42000020]),
+        (33, 0, 3, [0x42000a40, 0x42000830]),
+        (19, 0, 4, [0x40380210]),
+        (3, 1, 0, [0x40380010]),
+    ]
+    samples = sum(s[0] for s in stacks)
+    out = bytearray(HEADER.pack(b"NMPF", 1, 6, len(tasks), 199, samples, 0, len(stacks), 3000))
+    for t in tasks:
+        out += t.encode().ljust(TASK_NAME, b"\0")
+    for count, core, task, pcs in stacks:
+        out += struct.pack("<IBBBB", count, core, task, len(pcs), 0)
+        out += struct.pack(f"<{len(pcs)}I", *pcs)
+    with open(path, "wb") as f:
+        f.write(out)
+    return "".join(f"{a:08x} T {n}\n" for a, n in syms)
+
+
+def fetch(url, user, password):
+    req = urllib.request.Request(url)
+    if user:
+        token = base64.b64encode(f"{user}:{password or ''}".encode()).decode()
+        req.add_header("Authorization", "Basic " + token)
+    with urllib.request.urlopen(req, timeout=30) as r:
+        return r.read()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", nargs="?", help="profile file or http://<dongle>/profile?download=1 URL")
+    ap.add_argument("--elf", help="firmware.elf the profile was taken with")
+    ap.add_argument("--addr2line", default="xtensa-esp32s3-elf-addr2line")
+    ap.add_argument("--symbols", help="`nm -n -C firmware.elf` output instead of --elf")
+    ap.add_argument("--per-core", action="store_true", help="prefix stacks with cpu0/cpu1")
+    ap.add_argument("--make-sample", metavar="OUT", help="write a synthetic profile to OUT, its symbols to stdout")
+    ap.add_argument("--user")
+    ap.add_argument("--password")
+    args = ap.parse_args()
+
+    if args.make_sample:
+        sys.stdout.write(make_sample(args.make_sample))
+        return
+    if not args.source:
+        ap.error("source is required")
+    if args.source.startswith(("http://", "https://")):
+        data = fetch(args.source, args.user, args.password)
+    else:
+        with open(args.source, "rb") as f:
+            data = f.read()
+
+    info, tasks, stacks = parse(data)
+    addrs = {pc for _, _, _, pcs in stacks for pc in pcs}
+    if args.symbols:
+        names = resolve_nm(addrs, load_symbols(args.symbols))
+    elif args.elf:
+        names = resolve_addr2line(addrs, args.elf, args.addr2line)
+    else:
+        names = {}
+    for line, count in sorted(fold(tasks, stacks, names, args.per_core).items()):
+        print(f"{line} {count}")
+    print(f"{info['samples']} samples ({info['dropped']} dropped) at {info['hz']} Hz over "
+          f"{info['duration_ms'] / 1000:.1f} s, {len(stacks)} distinct stacks", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,115 @@
+// Host simulation of the thermal governor (lib/NukaDuino/src/ThermalGovernor.h).
+//
+// First-order thermal model of a dongle in a USB hub with no airflow:
+//   C dT/dt = P - (T - ambient) / R
+//   P = idle + workers * duty * per_worker
+// plus sensor noise and the internal sensor's 0.5 degC steps. Runs the
+// governor and, for comparison, a bang-bang cut-off (all miners off at the
+// ceiling, back on below ceiling - hysteresis), and prints peak temperature,
+// time over the ceiling and mining throughput for each.
+//
+//   g++ -O2 -std=c++11 -Ilib/NukaDuino/src tools/thermal_sim.cpp -o /tmp/thermal_sim
+//   /tmp/thermal_sim [ambient_c] [ceiling_c] [minutes]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ThermalGovernor.h"
+
+namespace {
+
+struct Model {
+    double ambient = 40.0;
+    double r = 28.0;          // degC per W
+    double tau_s = 90.0;      // R * C
+    double idle_w = 0.45;
+    double worker_w = 0.55;   // per worker at 100% duty
+    double t = 0;
+
+    void step(double dt, uint8_t workers, uint16_t duty) {
+        const double p = idle_w + workers * (duty / 1000.0) * worker_w;
+        const double tss = ambient + p * r;
+        t += (tss - t) * (1.0 - exp(-dt / tau_s));
+    }
+    float sense() const {
+        const double noisy = t + ((rand() % 1001) / 1000.0 - 0.5) * 0.8;
+        return (float)(floor(noisy * 2.0) / 2.0);
+    }
+};
+
+struct Result {
+    double peak = 0, overS = 0, work = 0, meanLate = 0;
+    uint32_t parks = 0;
+};
+
+void report(const char *name, const Result &r, double seconds, uint8_t workers) {
+    printf("%-10s peak %6.2f C   late mean %6.2f C   over ceiling %6.0f s   throughput %5.1f%%   parks %u\n",
+           name, r.peak, r.meanLate, r.overS, 100.0 * r.work / (seconds * workers), r.parks);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const double ambient = argc > 1 ? atof(argv[1]) : 40.0;
+    const float ceiling = argc > 2 ? (float)atof(argv[2]) : 75.0f;
+    const double minutes = argc > 3 ? atof(argv[3]) : 60.0;
+    const double seconds = minutes * 60.0;
+    const uint8_t workers = 2;
+    srand(1);
+
+    printf("ambient %.1f C, ceiling %.1f C, %.0f min, full-load steady state %.1f C\n",
+           ambient, ceiling, minutes, ambient + (0.45 + workers * 0.55) * 28.0);
+
+    // Governor.
+    {
+        Model m;
+        m.ambient = ambient;
+        m.t = ambient + 0.45 * m.r;
+        ThermalGovernor gov;
+        ThermalGovernor::Params p;
+        p.ceiling_c = ceiling;
+        p.workers = workers;
+        gov.configure(p);
+        gov.reset();
+        Result r;
+        uint32_t late = 0;
+        uint8_t lastWorkers = workers;
+        for (double s = 0; s < seconds; s += p.period_s) {
+            const ThermalGovernor::Output &o = gov.update(m.sense());
+            if (o.workers < lastWorkers) r.parks++;
+            lastWorkers = o.workers;
+            m.step(p.period_s, o.workers, o.duty);
+            r.work += o.workers * (o.duty / 1000.0) * p.period_s;
+            if (m.t > r.peak) r.peak = m.t;
+            if (m.t > ceiling) r.overS += p.period_s;
+            if (s >= seconds / 2) { r.meanLate += m.t; late++; }
+        }
+        r.meanLate /= late ? late : 1;
+        report("governor", r, seconds, workers);
+    }
+
+    // Bang-bang baseline with the same hysteresis.
+    {
+        Model m;
+        m.ambient = ambient;
+        m.t = ambient + 0.45 * m.r;
+        Result r;
+        uint32_t late = 0;
+        bool on = true;
+        double filt = m.t;
+        for (double s = 0; s < seconds; s += 1.0) {
+            filt += 0.25 * (m.sense() - filt);
+            if (on && filt >= ceiling) on = false;
+            else if (!on && filt < ceiling - 3.0) on = true;
+            m.step(1.0, on ? workers : 0, 1000);
+            r.work += on ? workers : 0;
+            if (m.t > r.peak) r.peak = m.t;
+            if (m.t > ceiling) r.overS += 1.0;
+            if (s >= seconds / 2) { r.meanLate += m.t; late++; }
+        }
+        r.meanLate /= late ? late : 1;
+        report("bang-bang", r, seconds, workers);
+    }
+    return 0;
+}
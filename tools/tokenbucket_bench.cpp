@@ -0,0 +1,102 @@
+// Host benchmark for the miner's hash-rate limiter (lib/NukaDuino/src/TokenBucket.h).
+//
+// Replays the hash loop against a simulated clock: ~64-hash work slices with
+// jitter, a 1 ms FreeRTOS tick where delay(n) wakes on the n-th tick boundary,
+// and the yield controller's one-tick yield every 15 ms. For each target duty
+// it reports what the bucket measured, the true simulated duty, and how
+// bursty the result is (longest hashing run, spread over 100 ms windows).
+//
+//   g++ -O2 -std=c++11 -Ilib/NukaDuino/src tools/tokenbucket_bench.cpp -o /tmp/tb_bench
+//   /tmp/tb_bench [seconds]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TokenBucket.h"
+
+namespace {
+
+const uint32_t TICK_US = 1000;
+const uint32_t SLICE_US = 300;     // 64 hashes at ~210 kH/s
+const uint32_t YIELD_EVERY_US = 15000;
+
+struct Sim {
+    uint64_t now = 0;
+    uint64_t busy = 0;
+    uint64_t run = 0, maxRun = 0;
+    uint64_t winBusy = 0, winStart = 0;
+    double winSum = 0, winSq = 0;
+    uint32_t windows = 0;
+
+    void work(uint32_t us) {
+        now += us;
+        busy += us;
+        winBusy += us;
+        run += us;
+        if (run > maxRun) maxRun = run;
+        roll();
+    }
+    void sleepTicks(uint32_t ticks) {
+        if (!ticks) return;
+        const uint64_t wake = (now / TICK_US + ticks) * TICK_US;
+        now = wake;
+        run = 0;
+        roll();
+    }
+    void roll() {
+        while (now - winStart >= 100000) {
+            const double d = (double)winBusy / 100000.0;
+            winSum += d;
+            winSq += d * d;
+            windows++;
+            winBusy = 0;
+            winStart += 100000;
+        }
+    }
+};
+
+void runOne(uint16_t pct, uint32_t seconds) {
+    Sim sim;
+    TokenBucket tb;
+    tb.configure(pct * 10);
+    tb.start((uint32_t)sim.now);
+    uint64_t lastYield = 0;
+    const uint64_t end = (uint64_t)seconds * 1000000;
+
+    while (sim.now < end) {
+        sim.work(SLICE_US - 40 + (uint32_t)(rand() % 81));
+        tb.mark((uint32_t)sim.now, true);
+
+        if (tb.limiting()) {
+            const uint32_t owed = tb.owedUs(TICK_US);
+            if (owed) {
+                sim.sleepTicks(owed >= 100000 ? 100 : owed / 1000);
+                tb.mark((uint32_t)sim.now, false);
+                lastYield = sim.now;
+            }
+        }
+        if (sim.now - lastYield >= YIELD_EVERY_US) {
+            sim.sleepTicks(1);
+            tb.mark((uint32_t)sim.now, false);
+            lastYield = sim.now;
+        }
+    }
+
+    const double trueDuty = 100.0 * sim.busy / sim.now;
+    const double mean = sim.windows ? sim.winSum / sim.windows : 0;
+    const double sd = sim.windows ? sqrt(fmax(0, sim.winSq / sim.windows - mean * mean)) : 0;
+    printf("%6u %10.2f %10.2f %+8.2f %10.2f %11.2f\n", pct, tb.achieved() / 10.0, trueDuty,
+           trueDuty - pct, sim.maxRun / 1000.0, sd * 100);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const uint32_t seconds = argc > 1 ? (uint32_t)atoi(argv[1]) : 60;
+    srand(1);
+    printf("target   measured   true(%%)   error   max run ms  sd 100ms(%%)\n");
+    const uint16_t targets[] = {5, 10, 25, 40, 50, 60, 75, 90, 95, 100};
+    for (uint16_t pct : targets) runOne(pct, seconds);
+    return 0;
+}